@@ -0,0 +1,138 @@
+// bench/bench_common.hpp
+#ifndef MY_MALLOC_BENCH_COMMON_HPP
+#define MY_MALLOC_BENCH_COMMON_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace my_malloc {
+namespace bench {
+
+// Small deterministic PRNG so that every allocator sees the same sequence.
+class XorShift64 {
+public:
+    explicit XorShift64(uint64_t seed = 0x9E3779B97F4A7C15ull) : state_(seed ? seed : 1) {}
+
+    uint64_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    // Uniform in [lo, hi].
+    size_t range(size_t lo, size_t hi) {
+        return lo + static_cast<size_t>(next() % (hi - lo + 1));
+    }
+
+private:
+    uint64_t state_;
+};
+
+class Stopwatch {
+public:
+    Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+    double elapsed_seconds() const {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        return std::chrono::duration<double>(elapsed).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+// "--name=value" style string argument, or the default when absent.
+inline const char* get_str_arg(int argc, char** argv, const char* name, const char* default_value) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (arg[0] != '-' || arg[1] != '-') {
+            continue;
+        }
+        size_t j = 0;
+        while (name[j] != '\0' && arg[2 + j] == name[j]) {
+            ++j;
+        }
+        if (name[j] == '\0' && arg[2 + j] == '=') {
+            return arg + 3 + j;
+        }
+    }
+    return default_value;
+}
+
+// "--name=value" style integer argument, or the default when absent.
+inline size_t get_arg(int argc, char** argv, const char* name, size_t default_value) {
+    const char* value = get_str_arg(argc, argv, name, nullptr);
+    return value ? static_cast<size_t>(std::strtoull(value, nullptr, 10)) : default_value;
+}
+
+inline void print_result(const char* name, size_t ops, double seconds) {
+    std::printf("%-28s %10zu ops %10.3f ms %10.1f ns/op\n",
+                name, ops, seconds * 1e3, ops ? seconds * 1e9 / static_cast<double>(ops) : 0.0);
+}
+
+// Current RSS of this process from /proc/self/statm, in KB. 0 on error.
+inline size_t get_rss_kb() {
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    unsigned long size_pages = 0;
+    unsigned long resident_pages = 0;
+    const int fields = std::fscanf(statm, "%lu %lu", &size_pages, &resident_pages);
+    std::fclose(statm);
+    return fields == 2 ? resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 1024 : 0;
+}
+
+// High-water RSS of this process, in KB.
+inline size_t get_peak_rss_kb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss);
+}
+
+// Runs fn in a forked child so that its peak RSS is measured on its own
+// rather than folded into the high-water mark of earlier runs. The double
+// fn returns is passed back through a pipe. Call before starting threads.
+template <typename Fn>
+bool run_forked(Fn fn, double& result, size_t& peak_rss_kb) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        const double value = fn();
+        const bool written = write(fds[1], &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value));
+        _exit(written ? 0 : 1);
+    }
+
+    close(fds[1]);
+    const bool received = read(fds[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+    close(fds[0]);
+
+    int status = 0;
+    rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid) {
+        return false;
+    }
+    peak_rss_kb = static_cast<size_t>(usage.ru_maxrss);
+    return received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace bench
+} // namespace my_malloc
+
+#endif // MY_MALLOC_BENCH_COMMON_HPP
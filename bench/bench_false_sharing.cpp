@@ -0,0 +1,209 @@
+// 伪共享：Hoard 的 cache-thrash（主动伪共享）与 cache-scratch（被动伪共享）
+//
+// 用法: bench_false_sharing [--mode=all|thrash|scratch] [--threads=N] [--iters=N]
+//                           [--writes=N] [--size=N]
+//   --iters   每个线程申请/释放对象的次数
+//   --writes  每个对象的每个字节被写的次数
+//   --size    对象大小，默认 8 字节，多个对象落在同一缓存行
+//
+// thrash:  每个线程反复申请一个小对象、写它、释放。如果分配器把相邻的块交给不同线程，
+//          这些写会在同一缓存行上来回争抢
+// scratch: 主线程先连续申请每个线程一个对象交给各线程，线程释放后再反复申请、写、释放。
+//          被释放的块若被线程自己复用，伪共享就从主线程的布局中继承下来
+//
+// 除 my_malloc（每线程一个 heap）和 glibc 外，还跑一个所有线程共用一个 ThreadHeap 的对照组，
+// 它按块序号从低到高把同一 slab 的相邻块发给不同线程，是伪共享的上界
+
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using my_malloc::bench::PerfCounter;
+
+struct Config {
+    size_t threads;
+    size_t iters;
+    size_t writes;
+    size_t size;
+};
+
+// 每个线程一个 heap，下标 threads 给主线程；释放交给块所属的 heap
+class PerThreadHeaps {
+public:
+    static constexpr const char* NAME = "my_malloc";
+
+    explicit PerThreadHeaps(size_t threads) {
+        for (size_t i = 0; i <= threads; ++i) {
+            heaps_.push_back(std::make_unique<my_malloc::ThreadHeap>());
+        }
+    }
+
+    void* allocate(size_t thread, size_t size) { return heaps_[thread]->allocate(size); }
+
+    void release(void* ptr) {
+        my_malloc::MappedSegment::get_owning_segment(ptr)->get_owner_heap()->free(ptr);
+    }
+
+private:
+    std::vector<std::unique_ptr<my_malloc::ThreadHeap>> heaps_;
+};
+
+// 对照组：所有线程共用一个 heap，靠它的锁保证线程安全
+class SharedHeap {
+public:
+    static constexpr const char* NAME = "shared heap (control)";
+
+    explicit SharedHeap(size_t) {}
+
+    void* allocate(size_t, size_t size) { return heap_.allocate(size); }
+    void release(void* ptr) { heap_.free(ptr); }
+
+private:
+    my_malloc::ThreadHeap heap_;
+};
+
+class Glibc {
+public:
+    static constexpr const char* NAME = "glibc";
+
+    explicit Glibc(size_t) {}
+
+    void* allocate(size_t, size_t size) { return std::malloc(size); }
+    void release(void* ptr) { std::free(ptr); }
+};
+
+void write_object(void* ptr, const Config& config) {
+    auto* bytes = static_cast<volatile char*>(ptr);
+    for (size_t w = 0; w < config.writes; ++w) {
+        for (size_t i = 0; i < config.size; ++i) {
+            bytes[i] = static_cast<char>(bytes[i] + 1);
+        }
+    }
+}
+
+template <typename Allocator>
+void thrash_worker(Allocator& allocator, size_t thread, const Config& config) {
+    for (size_t i = 0; i < config.iters; ++i) {
+        void* ptr = allocator.allocate(thread, config.size);
+        write_object(ptr, config);
+        allocator.release(ptr);
+    }
+}
+
+template <typename Allocator>
+void scratch_worker(Allocator& allocator, size_t thread, void* inherited, const Config& config) {
+    write_object(inherited, config);
+    allocator.release(inherited);
+    thrash_worker(allocator, thread, config);
+}
+
+struct Result {
+    double seconds;
+    uint64_t l1d_misses;
+    uint64_t cache_misses;
+};
+
+template <typename Allocator>
+Result run(const Config& config, bool scratch, PerfCounter& l1d, PerfCounter& llc) {
+    Allocator allocator(config.threads);
+
+    // 主线程连续申请，相邻的块依次交给各个线程
+    std::vector<void*> inherited(config.threads, nullptr);
+    if (scratch) {
+        for (size_t i = 0; i < config.threads; ++i) {
+            inherited[i] = allocator.allocate(config.threads, config.size);
+        }
+    }
+
+    l1d.start();
+    llc.start();
+    my_malloc::bench::Stopwatch watch;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < config.threads; ++i) {
+        workers.emplace_back([&, i] {
+            if (scratch) {
+                scratch_worker(allocator, i, inherited[i], config);
+            } else {
+                thrash_worker(allocator, i, config);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double seconds = watch.elapsed_seconds();
+    l1d.stop();
+    llc.stop();
+    return Result{seconds, l1d.read(), llc.read()};
+}
+
+template <typename Allocator>
+void report(const Config& config, bool scratch, PerfCounter& l1d, PerfCounter& llc) {
+    const Result result = run<Allocator>(config, scratch, l1d, llc);
+    const double writes = static_cast<double>(config.threads * config.iters * config.writes * config.size);
+
+    std::printf("  %-24s %10.3f ms %8.2f ns/write", Allocator::NAME, result.seconds * 1e3, result.seconds * 1e9 / writes);
+    if (l1d.is_available()) {
+        std::printf(" %14llu L1D misses", static_cast<unsigned long long>(result.l1d_misses));
+    }
+    if (llc.is_available()) {
+        std::printf(" %12llu cache misses", static_cast<unsigned long long>(result.cache_misses));
+    }
+    std::printf("\n");
+}
+
+void run_mode(const Config& config, bool scratch) {
+    std::printf("%s: %zu threads, %zu objects of %zu bytes each, %zu writes per byte\n",
+                scratch ? "cache-scratch (passive)" : "cache-thrash (active)",
+                config.threads, config.iters, config.size, config.writes);
+
+    // 计数器在创建线程之前打开，工作线程继承它们
+    PerfCounter l1d(PERF_TYPE_HW_CACHE, my_malloc::bench::cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                                                      PERF_COUNT_HW_CACHE_RESULT_MISS));
+    PerfCounter llc(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    if (!l1d.is_available() && !llc.is_available()) {
+        std::printf("  (hardware cache counters unavailable, reporting time only)\n");
+    }
+
+    report<PerThreadHeaps>(config, scratch, l1d, llc);
+    report<Glibc>(config, scratch, l1d, llc);
+    report<SharedHeap>(config, scratch, l1d, llc);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* mode = my_malloc::bench::get_str_arg(argc, argv, "mode", "all");
+    const size_t cores = std::thread::hardware_concurrency();
+
+    Config config;
+    config.threads = my_malloc::bench::get_arg(argc, argv, "threads", cores > 2 ? cores : 2);
+    config.iters = my_malloc::bench::get_arg(argc, argv, "iters", 1000);
+    config.writes = my_malloc::bench::get_arg(argc, argv, "writes", 500);
+    config.size = my_malloc::bench::get_arg(argc, argv, "size", 8);
+    if (config.threads == 0 || config.size == 0) {
+        return 1;
+    }
+
+    const bool all = std::strcmp(mode, "all") == 0;
+    if (!all && std::strcmp(mode, "thrash") != 0 && std::strcmp(mode, "scratch") != 0) {
+        std::fprintf(stderr, "unknown mode: %s\n", mode);
+        return 1;
+    }
+    if (all || std::strcmp(mode, "thrash") == 0) {
+        run_mode(config, false);
+    }
+    if (all || std::strcmp(mode, "scratch") == 0) {
+        run_mode(config, true);
+    }
+    return 0;
+}
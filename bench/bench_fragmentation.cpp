@@ -0,0 +1,206 @@
+// 长时间运行的碎片与 RSS：尺寸分布分阶段变化，每个阶段采样 RSS 与存活的请求字节数
+//
+// 用法: bench_fragmentation [--allocator=my_malloc|glibc] [--ops=N] [--live-mb=N]
+//                           [--sample-every=N] [--samples=0|1]
+//   --ops           每个阶段的操作数（一次分配或一次释放各算一次）
+//   --live-mb       存活请求字节数的目标，达到后转为随机释放
+//   --sample-every  每隔多少次操作读一次 /proc/self/statm
+//   --samples       1 表示逐条打印采样
+//
+// 阶段依次为：
+//   small  8B–1KB 为主，建出大量小对象 slab
+//   large  16KB–1MB，小对象 slab 被释放后，其页要合并成 span 再给大对象用
+//   mixed  两者混合，2% 的分配成为一直存活到结束的长寿对象，把 slab 和 span 钉在原处
+// 上一阶段的对象随随机释放逐渐被新形状的对象替换。
+// RSS 是进程级的，每次只跑一个分配器
+
+#include "bench_common.hpp"
+
+#include <my_malloc/ThreadHeap.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+using my_malloc::bench::XorShift64;
+
+constexpr size_t TOUCH_STRIDE = 4096;
+
+struct Object {
+    void* ptr;
+    size_t size;
+};
+
+struct Phase {
+    const char* name;
+    size_t (*next_size)(XorShift64& rng);
+    size_t survivor_permille;
+};
+
+size_t small_size(XorShift64& rng) {
+    // 小尺寸更常见
+    const size_t roll = rng.range(0, 99);
+    return roll < 70 ? rng.range(8, 128) : roll < 95 ? rng.range(129, 512) : rng.range(513, 1024);
+}
+
+size_t large_size(XorShift64& rng) {
+    return rng.range(16 * 1024, 1024 * 1024);
+}
+
+size_t mixed_size(XorShift64& rng) {
+    return rng.range(0, 9) == 0 ? large_size(rng) : small_size(rng);
+}
+
+const Phase PHASES[] = {
+    {"small", small_size, 0},
+    {"large", large_size, 0},
+    {"mixed", mixed_size, 20},
+};
+
+struct MyMalloc {
+    my_malloc::ThreadHeap heap;
+
+    void* allocate(size_t size) { return heap.allocate(size); }
+    void release(void* ptr) { heap.free(ptr); }
+};
+
+struct Glibc {
+    void* allocate(size_t size) { return std::malloc(size); }
+    void release(void* ptr) { std::free(ptr); }
+};
+
+void touch(void* ptr, size_t size) {
+    auto* bytes = static_cast<volatile char*>(ptr);
+    for (size_t i = 0; i < size; i += TOUCH_STRIDE) {
+        bytes[i] = 1;
+    }
+    bytes[size - 1] = 1;
+}
+
+struct Sample {
+    size_t rss_kb;
+    size_t live_bytes;
+
+    double ratio() const {
+        return live_bytes == 0 ? 0.0 : static_cast<double>(rss_kb) * 1024 / static_cast<double>(live_bytes);
+    }
+};
+
+struct Options {
+    size_t ops;
+    size_t live_target;
+    size_t sample_every;
+    bool print_samples;
+};
+
+template <typename Allocator>
+int run(const Options& options) {
+    Allocator allocator;
+    XorShift64 rng;
+    std::vector<Object> live;
+    std::vector<Object> survivors;
+    size_t live_bytes = 0;
+    size_t survivor_bytes = 0;
+
+    const size_t baseline_kb = my_malloc::bench::get_rss_kb();
+    std::printf("baseline rss: %zu KB, live target: %zu MB\n", baseline_kb, options.live_target >> 20);
+    std::printf("%-8s %10s %14s %14s %12s %14s\n",
+                "phase", "ops", "peak rss KB", "live KB", "peak ratio", "steady ratio");
+
+    double overall_peak_ratio = 0;
+    size_t overall_peak_kb = 0;
+    for (const Phase& phase : PHASES) {
+        std::vector<Sample> samples;
+        my_malloc::bench::Stopwatch watch;
+
+        for (size_t op = 1; op <= options.ops; ++op) {
+            if (live_bytes + survivor_bytes < options.live_target || live.empty()) {
+                const size_t size = phase.next_size(rng);
+                void* ptr = allocator.allocate(size);
+                if (ptr == nullptr) {
+                    std::fprintf(stderr, "allocation of %zu bytes failed\n", size);
+                    return 1;
+                }
+                touch(ptr, size);
+                // 长寿对象最多占目标的四分之一，否则会挤掉阶段本身的负载
+                if (rng.range(0, 999) < phase.survivor_permille && survivor_bytes < options.live_target / 4) {
+                    survivors.push_back(Object{ptr, size});
+                    survivor_bytes += size;
+                } else {
+                    live.push_back(Object{ptr, size});
+                    live_bytes += size;
+                }
+            } else {
+                const size_t index = rng.range(0, live.size() - 1);
+                allocator.release(live[index].ptr);
+                live_bytes -= live[index].size;
+                live[index] = live.back();
+                live.pop_back();
+            }
+
+            if (op % options.sample_every == 0) {
+                const Sample sample{my_malloc::bench::get_rss_kb() - baseline_kb, live_bytes + survivor_bytes};
+                samples.push_back(sample);
+                if (options.print_samples) {
+                    std::printf("  %s %zu rss_kb %zu live_kb %zu ratio %.3f\n",
+                                phase.name, op, sample.rss_kb, sample.live_bytes >> 10, sample.ratio());
+                }
+            }
+        }
+
+        // 稳态取阶段后一半采样的平均值，前一半还在从上一阶段的形状过渡
+        size_t peak_kb = 0;
+        double peak_ratio = 0;
+        double steady_sum = 0;
+        size_t steady_count = 0;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            peak_kb = samples[i].rss_kb > peak_kb ? samples[i].rss_kb : peak_kb;
+            peak_ratio = samples[i].ratio() > peak_ratio ? samples[i].ratio() : peak_ratio;
+            if (i >= samples.size() / 2) {
+                steady_sum += samples[i].ratio();
+                steady_count++;
+            }
+        }
+        overall_peak_kb = peak_kb > overall_peak_kb ? peak_kb : overall_peak_kb;
+        overall_peak_ratio = peak_ratio > overall_peak_ratio ? peak_ratio : overall_peak_ratio;
+
+        std::printf("%-8s %10zu %14zu %14zu %12.3f %14.3f   (%.1f ms)\n",
+                    phase.name, options.ops, peak_kb, (live_bytes + survivor_bytes) >> 10, peak_ratio,
+                    steady_count ? steady_sum / static_cast<double>(steady_count) : 0.0,
+                    watch.elapsed_seconds() * 1e3);
+    }
+    std::printf("overall: peak rss %zu KB, peak rss/live %.3f\n", overall_peak_kb, overall_peak_ratio);
+
+    for (const Object& object : live) {
+        allocator.release(object.ptr);
+    }
+    for (const Object& object : survivors) {
+        allocator.release(object.ptr);
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* allocator = my_malloc::bench::get_str_arg(argc, argv, "allocator", "my_malloc");
+
+    Options options;
+    options.ops = my_malloc::bench::get_arg(argc, argv, "ops", 2000000);
+    options.live_target = my_malloc::bench::get_arg(argc, argv, "live-mb", 64) << 20;
+    options.sample_every = my_malloc::bench::get_arg(argc, argv, "sample-every", 10000);
+    options.print_samples = my_malloc::bench::get_arg(argc, argv, "samples", 0) != 0;
+    if (options.ops == 0 || options.live_target == 0 || options.sample_every == 0) {
+        return 1;
+    }
+
+    if (std::strcmp(allocator, "my_malloc") == 0) {
+        return run<MyMalloc>(options);
+    }
+    if (std::strcmp(allocator, "glibc") == 0) {
+        return run<Glibc>(options);
+    }
+    std::fprintf(stderr, "unknown allocator: %s\n", allocator);
+    return 1;
+}
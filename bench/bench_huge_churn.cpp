@@ -0,0 +1,90 @@
+// 2–8MB 分配的反复申请/释放：比较 Segment 区域、Huge 缓存与系统 malloc
+//
+// 用法: bench_huge_churn [--iters=N] [--slots=N] [--touch=0|1]
+//   --slots  同时存活的对象数
+//   --touch  1 表示每次分配后写满每一页，0 表示只写首尾两页
+
+#include "bench_common.hpp"
+
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+using my_malloc::bench::XorShift64;
+
+constexpr size_t MIN_SIZE = 2 * 1024 * 1024;
+constexpr size_t MAX_SIZE = 8 * 1024 * 1024;
+
+void touch(void* ptr, size_t size, bool every_page) {
+    auto* bytes = static_cast<volatile char*>(ptr);
+    if (every_page) {
+        for (size_t i = 0; i < size; i += my_malloc::PAGE_SIZE) {
+            bytes[i] = 1;
+        }
+    } else {
+        bytes[0] = 1;
+        bytes[size - 1] = 1;
+    }
+}
+
+template <typename Alloc, typename Free>
+double run(size_t iters, size_t slots, bool every_page, Alloc alloc, Free release) {
+    XorShift64 rng;
+    std::vector<void*> live(slots, nullptr);
+
+    my_malloc::bench::Stopwatch watch;
+    for (size_t i = 0; i < iters; ++i) {
+        const size_t slot = rng.range(0, slots - 1);
+        if (live[slot] != nullptr) {
+            release(live[slot]);
+        }
+        const size_t size = rng.range(MIN_SIZE, MAX_SIZE);
+        live[slot] = alloc(size);
+        touch(live[slot], size, every_page);
+    }
+    const double seconds = watch.elapsed_seconds();
+
+    for (void* ptr : live) {
+        if (ptr != nullptr) {
+            release(ptr);
+        }
+    }
+    return seconds;
+}
+
+double run_my_malloc(size_t iters, size_t slots, bool every_page) {
+    my_malloc::ThreadHeap heap;
+    return run(iters, slots, every_page,
+               [&](size_t size) { return heap.allocate(size); },
+               [&](void* ptr) { heap.free(ptr); });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t iters = my_malloc::bench::get_arg(argc, argv, "iters", 20000);
+    const size_t slots = my_malloc::bench::get_arg(argc, argv, "slots", 8);
+    const bool every_page = my_malloc::bench::get_arg(argc, argv, "touch", 0) != 0;
+    if (slots == 0) {
+        return 1;
+    }
+
+    auto& options = my_malloc::AllocatorOptions::get_instance();
+
+    options.region_max_segments = my_malloc::DEFAULT_REGION_MAX_SEGMENTS;
+    my_malloc::bench::print_result("my_malloc (segment region)", iters, run_my_malloc(iters, slots, every_page));
+
+    options.region_max_segments = 0;
+    my_malloc::bench::print_result("my_malloc (huge cache)", iters, run_my_malloc(iters, slots, every_page));
+
+    my_malloc::bench::print_result("system malloc", iters,
+        run(iters, slots, every_page,
+            [](size_t size) { return std::malloc(size); },
+            [](void* ptr) { std::free(ptr); }));
+
+    return 0;
+}
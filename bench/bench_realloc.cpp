@@ -0,0 +1,214 @@
+// realloc 密集负载：仿照 JSON / 日志拼接，缓冲区按小步追加或翻倍增长，偶尔收缩到实际长度
+//
+// 用法: bench_realloc [--range=all|small|large|huge] [--pattern=all|append|double]
+//                     [--total-mb=N] [--shrink-every=N]
+//   --total-mb      每个配置写入的总字节数，写满后结束
+//   --shrink-every  每建完 N 个缓冲区，有一个在释放前收缩到实际长度（shrink-to-fit），0 表示不收缩
+//
+// 尺寸范围决定缓冲区增长的上限：
+//   small  到 4KB，全程在小对象 slab 内
+//   large  到 1MB，落在 LargeSlabHeader 管理的 span 上
+//   huge   到 32MB，独立映射，my_malloc 与 glibc 都可以靠 mremap 扩展
+// 每次 realloc 后把新追加的字节写一遍，和真实的拼接一样触碰新页。
+//
+// my_malloc 的原地、重映射、复制次数与复制字节数取自 ThreadHeap::get_stats() 的差值；
+// glibc 只能看到指针是否变化，搬家时按 min(旧长度, 新长度) 计为移动字节数，
+// 它的大块走 mremap 并不真正复制，所以这是上界
+
+#include "bench_common.hpp"
+
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/HeapStats.hpp>
+
+#include <cstring>
+
+namespace {
+
+using my_malloc::bench::XorShift64;
+
+struct Range {
+    const char* name;
+    size_t max_size;
+};
+
+const Range RANGES[] = {
+    {"small", 4 * 1024},
+    {"large", 1024 * 1024},
+    {"huge",  32 * 1024 * 1024},
+};
+
+enum class Pattern {
+    APPEND,  // 每次追加一小段，像逐个字段拼接
+    DOUBLE,  // 容量翻倍，像 std::vector 的增长
+};
+
+struct MyMalloc {
+    static constexpr const char* NAME = "my_malloc";
+    my_malloc::ThreadHeap heap;
+
+    void* reallocate(void* ptr, size_t size) { return heap.reallocate(ptr, size); }
+    void release(void* ptr) { heap.free(ptr); }
+};
+
+struct Glibc {
+    static constexpr const char* NAME = "glibc";
+
+    void* reallocate(void* ptr, size_t size) { return std::realloc(ptr, size); }
+    void release(void* ptr) { std::free(ptr); }
+};
+
+struct Options {
+    size_t total_bytes;
+    size_t shrink_every;
+};
+
+struct Result {
+    size_t reallocs = 0;
+    size_t moves = 0;
+    size_t moved_bytes = 0;
+    size_t written_bytes = 0;
+    double seconds = 0;
+};
+
+// 下一次的目标长度：追加的步长随范围放大，否则 huge 缓冲区要上百万次 realloc
+size_t next_length(Pattern pattern, size_t length, size_t max_size, XorShift64& rng) {
+    if (pattern == Pattern::DOUBLE) {
+        return length == 0 ? 16 : length * 2;
+    }
+    const size_t max_step = max_size / 256 > 64 ? max_size / 256 : 64;
+    return length + rng.range(1, max_step);
+}
+
+template <typename Allocator>
+bool resize(Allocator& allocator, char*& buffer, size_t old_length, size_t new_length, Result& result) {
+    char* grown = static_cast<char*>(allocator.reallocate(buffer, new_length));
+    if (grown == nullptr) {
+        std::fprintf(stderr, "realloc to %zu bytes failed\n", new_length);
+        return false;
+    }
+    result.reallocs++;
+    if (buffer != nullptr && grown != buffer) {
+        result.moves++;
+        result.moved_bytes += old_length < new_length ? old_length : new_length;
+    }
+    buffer = grown;
+    return true;
+}
+
+template <typename Allocator>
+bool run(Allocator& allocator, const Range& range, Pattern pattern, const Options& options, Result& result) {
+    XorShift64 rng;
+    size_t buffers = 0;
+    my_malloc::bench::Stopwatch watch;
+
+    while (result.written_bytes < options.total_bytes) {
+        char* buffer = nullptr;
+        size_t length = 0;
+        for (;;) {
+            const size_t target = next_length(pattern, length, range.max_size, rng);
+            if (target > range.max_size) {
+                break;
+            }
+            if (!resize(allocator, buffer, length, target, result)) {
+                return false;
+            }
+            std::memset(buffer + length, static_cast<int>(target & 0xff), target - length);
+            result.written_bytes += target - length;
+            length = target;
+        }
+
+        // 翻倍得到的容量往往比内容大，收缩到内容的实际长度
+        if (options.shrink_every != 0 && ++buffers % options.shrink_every == 0 && length > 1) {
+            const size_t fitted = rng.range(length / 4 + 1, length);
+            if (!resize(allocator, buffer, length, fitted, result)) {
+                return false;
+            }
+        }
+        allocator.release(buffer);
+    }
+
+    result.seconds = watch.elapsed_seconds();
+    return true;
+}
+
+void print_row(const char* name, const Result& result) {
+    const double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+    const double in_place = result.reallocs == 0 ? 0.0
+        : 100.0 * static_cast<double>(result.reallocs - result.moves) / static_cast<double>(result.reallocs);
+    std::printf("  %-10s %10zu reallocs %12.0f /s %9.1f MB/s %9zu moves %6.1f%% in place",
+                name, result.reallocs, static_cast<double>(result.reallocs) / seconds,
+                static_cast<double>(result.written_bytes) / seconds / (1024 * 1024), result.moves, in_place);
+}
+
+void report_my_malloc(const Range& range, Pattern pattern, const Options& options) {
+    MyMalloc allocator;
+    Result result;
+    const my_malloc::HeapStats before = my_malloc::ThreadHeap::get_stats();
+    if (!run(allocator, range, pattern, options, result)) {
+        return;
+    }
+    const my_malloc::HeapStats after = my_malloc::ThreadHeap::get_stats();
+
+    // 首次 realloc(nullptr, n) 走 allocate，不计入三者
+    print_row(MyMalloc::NAME, result);
+    std::printf("\n  %-10s %10llu avoided (%llu in place, %llu remapped) %9llu copies %12llu bytes copied\n", "",
+                static_cast<unsigned long long>(after.realloc_in_place - before.realloc_in_place
+                                                + after.realloc_remapped - before.realloc_remapped),
+                static_cast<unsigned long long>(after.realloc_in_place - before.realloc_in_place),
+                static_cast<unsigned long long>(after.realloc_remapped - before.realloc_remapped),
+                static_cast<unsigned long long>(after.realloc_copies - before.realloc_copies),
+                static_cast<unsigned long long>(after.realloc_copied_bytes - before.realloc_copied_bytes));
+}
+
+void report_glibc(const Range& range, Pattern pattern, const Options& options) {
+    Glibc allocator;
+    Result result;
+    if (!run(allocator, range, pattern, options, result)) {
+        return;
+    }
+    print_row(Glibc::NAME, result);
+    std::printf(" %12zu bytes moved (upper bound)\n", result.moved_bytes);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* range_name = my_malloc::bench::get_str_arg(argc, argv, "range", "all");
+    const char* pattern_name = my_malloc::bench::get_str_arg(argc, argv, "pattern", "all");
+
+    Options options;
+    options.total_bytes = my_malloc::bench::get_arg(argc, argv, "total-mb", 256) << 20;
+    options.shrink_every = my_malloc::bench::get_arg(argc, argv, "shrink-every", 8);
+    if (options.total_bytes == 0) {
+        return 1;
+    }
+
+    const bool all_patterns = std::strcmp(pattern_name, "all") == 0;
+    if (!all_patterns && std::strcmp(pattern_name, "append") != 0 && std::strcmp(pattern_name, "double") != 0) {
+        std::fprintf(stderr, "unknown pattern: %s\n", pattern_name);
+        return 1;
+    }
+
+    bool matched = false;
+    for (const Range& range : RANGES) {
+        if (std::strcmp(range_name, "all") != 0 && std::strcmp(range_name, range.name) != 0) {
+            continue;
+        }
+        matched = true;
+        for (Pattern pattern : {Pattern::APPEND, Pattern::DOUBLE}) {
+            const char* name = pattern == Pattern::APPEND ? "append" : "double";
+            if (!all_patterns && std::strcmp(pattern_name, name) != 0) {
+                continue;
+            }
+            std::printf("%s / %s: up to %zu bytes, %zu MB written\n",
+                        range.name, name, range.max_size, options.total_bytes >> 20);
+            report_my_malloc(range, pattern, options);
+            report_glibc(range, pattern, options);
+        }
+    }
+    if (!matched) {
+        std::fprintf(stderr, "unknown range: %s\n", range_name);
+        return 1;
+    }
+    return 0;
+}
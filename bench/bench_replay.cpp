@@ -0,0 +1,251 @@
+// 回放 AllocTrace 录制的跟踪文件，比较不同分配器
+//
+// 用法: bench_replay --trace=PATH [--allocator=my_malloc|glibc] [--touch=1]
+//       bench_replay --record=PATH [--iters=N] [--slots=N]
+//   --allocator  回放使用的分配器；峰值 RSS 是进程级的，每次只回放一个
+//   --touch      每个新对象的每一页写一个字节，使 RSS 反映真实占用
+//   --record     不回放，而是录制一段随机负载，便于试用
+//
+// 所有线程的记录按时间戳合并后在单线程中回放：ThreadHeap 还不支持跨 heap 释放。
+// 吞吐量一轮附带每次操作的硬件计数器，perf 不可用时退回 rusage
+
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocTrace.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using my_malloc::TraceOp;
+using my_malloc::TraceRecord;
+using my_malloc::bench::XorShift64;
+
+constexpr size_t TOUCH_STRIDE = 4096;
+
+// 地址在加载时换成稠密编号；早于录制开始分配的对象的 free 被丢弃
+struct ReplayOp {
+    uint64_t size;      // 0 表示 free
+    uint32_t id;
+};
+
+struct Trace {
+    std::vector<ReplayOp> ops;
+    uint32_t num_ids = 0;
+    size_t num_threads = 0;
+    size_t skipped_frees = 0;
+};
+
+bool load_trace(const char* path, Trace& trace) {
+    FILE* in = std::fopen(path, "rb");
+    if (in == nullptr) {
+        return false;
+    }
+
+    my_malloc::TraceFileHeader header;
+    std::vector<TraceRecord> records;
+    bool ok = std::fread(&header, sizeof(header), 1, in) == 1 && header.magic == my_malloc::TRACE_MAGIC &&
+              header.record_size == sizeof(TraceRecord);
+    if (ok) {
+        TraceRecord rec;
+        while (std::fread(&rec, sizeof(rec), 1, in) == 1) {
+            records.push_back(rec);
+        }
+    }
+    std::fclose(in);
+    if (!ok) {
+        return false;
+    }
+
+    // 每个线程的记录块内部有序，按时间戳稳定排序即可合并
+    std::stable_sort(records.begin(), records.end(), [](const TraceRecord& a, const TraceRecord& b) {
+        return a.timestamp_ns < b.timestamp_ns;
+    });
+
+    std::unordered_map<uint64_t, uint32_t> live;
+    std::vector<bool> threads;
+    for (const TraceRecord& rec : records) {
+        if (rec.thread_id >= threads.size()) {
+            threads.resize(rec.thread_id + 1);
+        }
+        threads[rec.thread_id] = true;
+
+        if (rec.op == TraceOp::ALLOC) {
+            live[rec.address] = trace.num_ids;
+            trace.ops.push_back({rec.size, trace.num_ids++});
+            continue;
+        }
+        auto it = live.find(rec.address);
+        if (it == live.end()) {
+            trace.skipped_frees++;
+            continue;
+        }
+        trace.ops.push_back({0, it->second});
+        live.erase(it);
+    }
+    trace.num_threads = static_cast<size_t>(std::count(threads.begin(), threads.end(), true));
+    return true;
+}
+
+struct MyMalloc {
+    my_malloc::ThreadHeap heap;
+    void* allocate(size_t size) { return heap.allocate(size); }
+    void free(void* ptr) { heap.free(ptr); }
+};
+
+struct Glibc {
+    void* allocate(size_t size) { return std::malloc(size); }
+    void free(void* ptr) { std::free(ptr); }
+};
+
+void touch(void* ptr, size_t size) {
+    auto* bytes = static_cast<volatile char*>(ptr);
+    for (size_t off = 0; off < size; off += TOUCH_STRIDE) {
+        bytes[off] = 1;
+    }
+}
+
+template <typename Allocator>
+double run_throughput(const Trace& trace, bool touch_pages, my_malloc::bench::OpCounters& counters) {
+    Allocator allocator;
+    std::vector<void*> ptrs(trace.num_ids, nullptr);
+
+    counters.start();
+    my_malloc::bench::Stopwatch watch;
+    for (const ReplayOp& op : trace.ops) {
+        if (op.size != 0) {
+            void* ptr = allocator.allocate(op.size);
+            if (touch_pages && ptr != nullptr) {
+                touch(ptr, op.size);
+            }
+            ptrs[op.id] = ptr;
+        } else {
+            allocator.free(ptrs[op.id]);
+            ptrs[op.id] = nullptr;
+        }
+    }
+    const double seconds = watch.elapsed_seconds();
+    counters.stop();
+
+    for (void* ptr : ptrs) {
+        allocator.free(ptr);
+    }
+    return seconds;
+}
+
+// 每次调用单独计时；结果包含两次读时钟的开销
+template <typename Allocator>
+std::vector<uint32_t> run_latency(const Trace& trace, bool touch_pages) {
+    Allocator allocator;
+    std::vector<void*> ptrs(trace.num_ids, nullptr);
+    std::vector<uint32_t> latencies;
+    latencies.reserve(trace.ops.size());
+
+    for (const ReplayOp& op : trace.ops) {
+        const auto start = std::chrono::steady_clock::now();
+        if (op.size != 0) {
+            ptrs[op.id] = allocator.allocate(op.size);
+        } else {
+            allocator.free(ptrs[op.id]);
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        latencies.push_back(static_cast<uint32_t>(
+            std::min<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), UINT32_MAX)));
+
+        if (op.size != 0) {
+            if (touch_pages && ptrs[op.id] != nullptr) {
+                touch(ptrs[op.id], op.size);
+            }
+        } else {
+            ptrs[op.id] = nullptr;
+        }
+    }
+
+    for (void* ptr : ptrs) {
+        allocator.free(ptr);
+    }
+    return latencies;
+}
+
+template <typename Allocator>
+void replay(const char* name, const Trace& trace, bool touch_pages) {
+    const size_t baseline_kb = my_malloc::bench::get_peak_rss_kb();
+
+    my_malloc::bench::OpCounters counters;
+    my_malloc::bench::print_result(name, trace.ops.size(), run_throughput<Allocator>(trace, touch_pages, counters));
+    counters.print_per_op(trace.ops.size());
+
+    std::vector<uint32_t> latencies = run_latency<Allocator>(trace, touch_pages);
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies.empty() ? 0u : latencies[static_cast<size_t>(p * static_cast<double>(latencies.size() - 1))];
+    };
+    std::printf("latency ns: p50 %u  p99 %u  p99.9 %u  max %u\n",
+                percentile(0.5), percentile(0.99), percentile(0.999), percentile(1.0));
+
+    const size_t peak_kb = my_malloc::bench::get_peak_rss_kb();
+    std::printf("peak rss: %zu KB (+%zu KB over the loaded trace)\n",
+                peak_kb, peak_kb > baseline_kb ? peak_kb - baseline_kb : 0);
+}
+
+int record(const char* path, size_t iters, size_t slots) {
+    if (slots == 0 || !my_malloc::AllocTrace::get_instance().start(path)) {
+        return 1;
+    }
+
+    my_malloc::ThreadHeap heap;
+    XorShift64 rng;
+    std::vector<void*> live(slots, nullptr);
+    for (size_t i = 0; i < iters; ++i) {
+        const size_t slot = rng.range(0, slots - 1);
+        heap.free(live[slot]);
+        // 大多是小对象，偶尔出现中等和 huge 对象
+        const size_t roll = rng.range(0, 999);
+        const size_t size = roll < 990 ? rng.range(8, 1024)
+                          : roll < 999 ? rng.range(64 * 1024, 1024 * 1024)
+                                       : rng.range(4 * 1024 * 1024, 16 * 1024 * 1024);
+        live[slot] = heap.allocate(size);
+    }
+    for (void* ptr : live) {
+        heap.free(ptr);
+    }
+    return my_malloc::AllocTrace::get_instance().stop() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* record_path = my_malloc::bench::get_str_arg(argc, argv, "record", nullptr);
+    if (record_path != nullptr) {
+        return record(record_path,
+                      my_malloc::bench::get_arg(argc, argv, "iters", 1000000),
+                      my_malloc::bench::get_arg(argc, argv, "slots", 4096));
+    }
+
+    const char* trace_path = my_malloc::bench::get_str_arg(argc, argv, "trace", nullptr);
+    const char* allocator = my_malloc::bench::get_str_arg(argc, argv, "allocator", "my_malloc");
+    const bool touch_pages = my_malloc::bench::get_arg(argc, argv, "touch", 1) != 0;
+
+    Trace trace;
+    if (trace_path == nullptr || !load_trace(trace_path, trace)) {
+        std::fprintf(stderr, "usage: bench_replay --trace=PATH [--allocator=my_malloc|glibc] [--touch=0|1]\n");
+        return 1;
+    }
+    std::printf("trace: %zu ops, %u objects, %zu threads, %zu frees of untraced objects skipped\n",
+                trace.ops.size(), trace.num_ids, trace.num_threads, trace.skipped_frees);
+
+    if (std::strcmp(allocator, "glibc") == 0) {
+        replay<Glibc>("glibc", trace, touch_pages);
+    } else if (std::strcmp(allocator, "my_malloc") == 0) {
+        replay<MyMalloc>("my_malloc", trace, touch_pages);
+    } else {
+        std::fprintf(stderr, "unknown allocator: %s\n", allocator);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+// 小对象申请/释放的开销：比较关闭采样与不同采样间隔
+//
+// 用法: bench_sampling [--iters=N] [--slots=N] [--interval=BYTES]
+//   --slots     同时存活的对象数
+//   --interval  开启采样时的平均采样间隔，默认 512KB
+//
+// 每次运行后附一行每次操作的指令数、周期与缓存/TLB 缺失，perf 不可用时退回 rusage
+
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/HeapProfiler.hpp>
+
+#include <vector>
+
+namespace {
+
+using my_malloc::bench::XorShift64;
+
+constexpr size_t MIN_SIZE = 16;
+constexpr size_t MAX_SIZE = 1024;
+
+double run(size_t iters, size_t slots, my_malloc::bench::OpCounters& counters) {
+    my_malloc::ThreadHeap heap;
+    XorShift64 rng;
+    std::vector<void*> live(slots, nullptr);
+
+    counters.start();
+    my_malloc::bench::Stopwatch watch;
+    for (size_t i = 0; i < iters; ++i) {
+        const size_t slot = rng.range(0, slots - 1);
+        if (live[slot] != nullptr) {
+            heap.free(live[slot]);
+        }
+        live[slot] = heap.allocate(rng.range(MIN_SIZE, MAX_SIZE));
+    }
+    const double seconds = watch.elapsed_seconds();
+    counters.stop();
+
+    for (void* ptr : live) {
+        heap.free(ptr);
+    }
+    return seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t iters = my_malloc::bench::get_arg(argc, argv, "iters", 5000000);
+    const size_t slots = my_malloc::bench::get_arg(argc, argv, "slots", 1024);
+    const size_t interval = my_malloc::bench::get_arg(argc, argv, "interval", 512 * 1024);
+    if (slots == 0) {
+        return 1;
+    }
+
+    auto& options = my_malloc::AllocatorOptions::get_instance();
+    my_malloc::bench::OpCounters counters;
+
+    // 交替运行，减小频率漂移对比较的影响
+    for (int round = 0; round < 3; ++round) {
+        options.profile_sample_interval = 0;
+        my_malloc::bench::print_result("sampling off", iters, run(iters, slots, counters));
+        counters.print_per_op(iters);
+
+        options.profile_sample_interval = interval;
+        my_malloc::bench::print_result("sampling on", iters, run(iters, slots, counters));
+        counters.print_per_op(iters);
+    }
+
+    std::printf("live samples: %zu, dropped: %llu\n",
+                my_malloc::HeapProfiler::get_instance().get_live_samples(),
+                static_cast<unsigned long long>(my_malloc::HeapProfiler::get_instance().get_dropped_samples()));
+    return 0;
+}
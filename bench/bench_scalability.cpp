@@ -0,0 +1,325 @@
+// 多线程扩展性：larson、threadtest、xmalloc、shbench 四种经典负载，线程数从 1 翻倍到核数
+//
+// 用法: bench_scalability [--workload=all|larson|threadtest|xmalloc|shbench]
+//                         [--allocator=my_malloc|glibc] [--iters=N] [--max-threads=N]
+//   --iters        每个线程执行的分配次数，总工作量随线程数增长
+//   --max-threads  默认为在线 CPU 数
+//
+// 每个线程有自己的 ThreadHeap；释放总是交给块所属的 heap，跨线程释放会落到对方的锁上。
+// 每个配置在单独的子进程中运行，峰值 RSS 互不影响。
+// 扩展效率 = N 线程吞吐 / (N × 单线程吞吐)
+
+#include "bench_common.hpp"
+
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+
+#include <array>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using my_malloc::bench::XorShift64;
+
+// 线程本地分配，释放交给块所属的 heap
+struct MyMallocAllocator {
+    my_malloc::ThreadHeap heap;
+
+    void* allocate(size_t size) { return heap.allocate(size); }
+
+    static void release(void* ptr) {
+        if (ptr != nullptr) {
+            my_malloc::MappedSegment::get_owning_segment(ptr)->get_owner_heap()->free(ptr);
+        }
+    }
+};
+
+struct GlibcAllocator {
+    void* allocate(size_t size) { return std::malloc(size); }
+    static void release(void* ptr) { std::free(ptr); }
+};
+
+// 可重复使用的线程屏障
+class Barrier {
+public:
+    explicit Barrier(size_t count) : count_(count) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> guard(lock_);
+        const size_t generation = generation_;
+        if (++waiting_ == count_) {
+            waiting_ = 0;
+            generation_++;
+            cv_.notify_all();
+        } else {
+            cv_.wait(guard, [&] { return generation != generation_; });
+        }
+    }
+
+private:
+    std::mutex lock_;
+    std::condition_variable cv_;
+    size_t count_;
+    size_t waiting_ = 0;
+    size_t generation_ = 0;
+};
+
+struct Config {
+    size_t threads;
+    size_t iters;
+};
+
+template <typename Allocator>
+using AllocatorSet = std::vector<std::unique_ptr<Allocator>>;
+
+// 各线程的 heap 必须比所有还没释放的块活得久
+template <typename Allocator>
+AllocatorSet<Allocator> make_allocators(size_t count) {
+    AllocatorSet<Allocator> allocators;
+    for (size_t i = 0; i < count; ++i) {
+        allocators.push_back(std::make_unique<Allocator>());
+    }
+    return allocators;
+}
+
+// 所有线程就绪后同时开始计时，返回每秒操作数（一次分配或一次释放各算一次）
+template <typename Allocator, typename Body>
+double run_threads(const Config& config, AllocatorSet<Allocator>& allocators, Body body) {
+    Barrier start(config.threads + 1);
+    std::vector<size_t> ops(config.threads, 0);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < config.threads; ++i) {
+        workers.emplace_back([&, i] {
+            start.wait();
+            ops[i] = body(i, *allocators[i]);
+        });
+    }
+
+    start.wait();
+    my_malloc::bench::Stopwatch watch;
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double seconds = watch.elapsed_seconds();
+
+    size_t total = 0;
+    for (size_t n : ops) {
+        total += n;
+    }
+    return seconds > 0 ? static_cast<double>(total) / seconds : 0.0;
+}
+
+// larson：模拟服务器，每个线程在自己的槽位数组里随机替换对象；
+// 每轮结束后数组整体交给下一个线程，上一轮其他线程分配的块由本线程释放
+template <typename Allocator>
+double larson(const Config& config) {
+    constexpr size_t SLOTS = 1000;
+    constexpr size_t ROUNDS = 10;
+    constexpr size_t MIN_SIZE = 16;
+    constexpr size_t MAX_SIZE = 512;
+
+    auto allocators = make_allocators<Allocator>(config.threads);
+    std::vector<std::vector<void*>> arrays(config.threads, std::vector<void*>(SLOTS, nullptr));
+    Barrier round_end(config.threads);
+
+    const double ops_per_sec = run_threads(config, allocators, [&](size_t id, Allocator& allocator) {
+        XorShift64 rng(id + 1);
+        size_t ops = 0;
+        for (size_t round = 0; round < ROUNDS; ++round) {
+            std::vector<void*>& live = arrays[(id + round) % config.threads];
+            for (size_t i = 0; i < config.iters / ROUNDS; ++i) {
+                void*& slot = live[rng.range(0, SLOTS - 1)];
+                if (slot != nullptr) {
+                    Allocator::release(slot);
+                    ops++;
+                }
+                slot = allocator.allocate(rng.range(MIN_SIZE, MAX_SIZE));
+                ops++;
+            }
+            round_end.wait();
+        }
+        return ops;
+    });
+
+    for (auto& live : arrays) {
+        for (void* ptr : live) {
+            Allocator::release(ptr);
+        }
+    }
+    return ops_per_sec;
+}
+
+// threadtest：每个线程反复申请一批同样大小的对象再全部释放，线程之间没有共享
+template <typename Allocator>
+double threadtest(const Config& config) {
+    constexpr size_t BATCH = 1000;
+    constexpr size_t SIZE = 64;
+
+    auto allocators = make_allocators<Allocator>(config.threads);
+    return run_threads(config, allocators, [&](size_t, Allocator& allocator) {
+        std::vector<void*> batch(BATCH);
+        size_t ops = 0;
+        for (size_t done = 0; done < config.iters; done += BATCH) {
+            for (size_t i = 0; i < BATCH; ++i) {
+                batch[i] = allocator.allocate(SIZE);
+            }
+            for (size_t i = 0; i < BATCH; ++i) {
+                Allocator::release(batch[i]);
+            }
+            ops += 2 * BATCH;
+        }
+        return ops;
+    });
+}
+
+// xmalloc：生产者/消费者。每个线程分配一批对象放进共享队列，再取出任意一批释放，
+// 取到的往往是其他线程分配的
+template <typename Allocator>
+double xmalloc(const Config& config) {
+    constexpr size_t BATCH = 64;
+    constexpr size_t MIN_SIZE = 16;
+    constexpr size_t MAX_SIZE = 256;
+    using Batch = std::array<void*, BATCH>;
+
+    std::mutex queue_lock;
+    std::vector<Batch> queue;
+    queue.reserve(config.threads + 1);
+
+    auto allocators = make_allocators<Allocator>(config.threads);
+    return run_threads(config, allocators, [&](size_t id, Allocator& allocator) {
+        XorShift64 rng(id + 1);
+        Batch batch;
+        size_t ops = 0;
+        for (size_t done = 0; done < config.iters; done += BATCH) {
+            for (void*& ptr : batch) {
+                ptr = allocator.allocate(rng.range(MIN_SIZE, MAX_SIZE));
+            }
+            {
+                // 先放入再取出，队列长度不超过线程数，不会扩容
+                std::lock_guard<std::mutex> guard(queue_lock);
+                queue.push_back(batch);
+                batch = queue.front();
+                queue.front() = queue.back();
+                queue.pop_back();
+            }
+            for (void* ptr : batch) {
+                Allocator::release(ptr);
+            }
+            ops += 2 * BATCH;
+        }
+        return ops;
+    });
+}
+
+// shbench：小对象为主、夹杂少量中等和较大对象的混合尺寸，槽位随机替换，线程之间没有共享
+template <typename Allocator>
+double shbench(const Config& config) {
+    constexpr size_t SLOTS = 2000;
+
+    auto allocators = make_allocators<Allocator>(config.threads);
+    return run_threads(config, allocators, [&](size_t id, Allocator& allocator) {
+        XorShift64 rng(id + 1);
+        std::vector<void*> live(SLOTS, nullptr);
+        size_t ops = 0;
+        for (size_t i = 0; i < config.iters; ++i) {
+            void*& slot = live[rng.range(0, SLOTS - 1)];
+            if (slot != nullptr) {
+                Allocator::release(slot);
+                ops++;
+            }
+            const size_t roll = rng.range(0, 999);
+            const size_t size = roll < 900 ? rng.range(1, 128)
+                              : roll < 990 ? rng.range(129, 4096)
+                                           : rng.range(4097, 512 * 1024);
+            slot = allocator.allocate(size);
+            ops++;
+        }
+        for (void* ptr : live) {
+            Allocator::release(ptr);
+        }
+        return ops;
+    });
+}
+
+struct Workload {
+    const char* name;
+    double (*my_malloc_fn)(const Config&);
+    double (*glibc_fn)(const Config&);
+};
+
+const Workload WORKLOADS[] = {
+    {"larson",     larson<MyMallocAllocator>,     larson<GlibcAllocator>},
+    {"threadtest", threadtest<MyMallocAllocator>, threadtest<GlibcAllocator>},
+    {"xmalloc",    xmalloc<MyMallocAllocator>,    xmalloc<GlibcAllocator>},
+    {"shbench",    shbench<MyMallocAllocator>,    shbench<GlibcAllocator>},
+};
+
+// 1, 2, 4, ... 直到 max_threads，最后一档总是 max_threads 本身
+size_t next_thread_count(size_t threads, size_t max_threads) {
+    if (threads == max_threads) {
+        return max_threads + 1;
+    }
+    return threads * 2 < max_threads ? threads * 2 : max_threads;
+}
+
+void run_workload(const Workload& workload, bool use_glibc, size_t iters, size_t max_threads) {
+    std::printf("\n%s (%s)\n", workload.name, use_glibc ? "glibc" : "my_malloc");
+    std::printf("%8s %16s %12s %14s\n", "threads", "ops/sec", "efficiency", "peak rss KB");
+
+    double single_thread = 0;
+    for (size_t threads = 1; threads <= max_threads; threads = next_thread_count(threads, max_threads)) {
+        const Config config{threads, iters};
+        double ops_per_sec = 0;
+        size_t peak_rss_kb = 0;
+        const bool ok = my_malloc::bench::run_forked(
+            [&] { return use_glibc ? workload.glibc_fn(config) : workload.my_malloc_fn(config); },
+            ops_per_sec, peak_rss_kb);
+        if (!ok) {
+            std::printf("%8zu %16s\n", threads, "failed");
+            continue;
+        }
+
+        if (threads == 1) {
+            single_thread = ops_per_sec;
+        }
+        const double efficiency = single_thread > 0 ? ops_per_sec / (single_thread * static_cast<double>(threads)) : 0.0;
+        std::printf("%8zu %16.0f %11.1f%% %14zu\n", threads, ops_per_sec, efficiency * 100, peak_rss_kb);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* workload = my_malloc::bench::get_str_arg(argc, argv, "workload", "all");
+    const char* allocator = my_malloc::bench::get_str_arg(argc, argv, "allocator", "my_malloc");
+    const size_t iters = my_malloc::bench::get_arg(argc, argv, "iters", 1000000);
+    const size_t cores = std::thread::hardware_concurrency();
+    const size_t max_threads = my_malloc::bench::get_arg(argc, argv, "max-threads", cores ? cores : 1);
+    if (iters == 0 || max_threads == 0) {
+        return 1;
+    }
+
+    const bool use_glibc = std::strcmp(allocator, "glibc") == 0;
+    if (!use_glibc && std::strcmp(allocator, "my_malloc") != 0) {
+        std::fprintf(stderr, "unknown allocator: %s\n", allocator);
+        return 1;
+    }
+
+    bool matched = false;
+    for (const Workload& w : WORKLOADS) {
+        if (std::strcmp(workload, "all") == 0 || std::strcmp(workload, w.name) == 0) {
+            run_workload(w, use_glibc, iters, max_threads);
+            matched = true;
+        }
+    }
+    if (!matched) {
+        std::fprintf(stderr, "unknown workload: %s\n", workload);
+        return 1;
+    }
+    return 0;
+}
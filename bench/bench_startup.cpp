@@ -0,0 +1,273 @@
+// 启动与首次分配延迟：进程启动到第一次分配完成，以及新线程启动到第一次分配完成
+//
+// 用法: bench_startup [--mode=all|process|thread] [--runs=N]
+//   --runs  每种情形重复的次数，报告中位数、p90 与最小值
+//
+// process: 父进程记下时间后 fork + exec 自身，子进程在冷启动状态下依次测
+//          exec 到 main、SlabConfig 构造（含 size_to_class_map_ 的建表）、ThreadHeap 构造、
+//          第一次 allocate（首个 MappedSegment::create 与 slab 初始化），再测一次热的 allocate 作对照
+// thread:  在已预热的进程里创建线程，测线程启动、ThreadHeap 构造与第一次 allocate。
+//          线程退出时 heap 被析构，它的 Segment 可能被下一轮复用，与反复创建工作线程的情形一致
+//
+// 每个阶段都与 glibc malloc 的同一情形并列
+
+#include "bench_common.hpp"
+
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/SlabConfig.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t FIRST_SIZE = 64;
+constexpr size_t MAX_STAGES = 6;
+
+uint64_t now_ns() {
+    // steady_clock 即 CLOCK_MONOTONIC，父子进程之间可以直接相减
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+struct Scenario {
+    const char* name;
+    const char* stages[MAX_STAGES];
+    size_t num_stages;
+};
+
+// 最后一个阶段是热路径对照，不计入总和
+const Scenario PROCESS_MY_MALLOC = {
+    "my_malloc", {"exec to main", "SlabConfig", "ThreadHeap ctor", "first allocate", "second allocate"}, 5};
+const Scenario PROCESS_GLIBC = {"glibc", {"exec to main", "first malloc", "second malloc"}, 3};
+const Scenario THREAD_MY_MALLOC = {
+    "my_malloc", {"thread start", "ThreadHeap ctor", "first allocate", "second allocate"}, 4};
+const Scenario THREAD_GLIBC = {"glibc", {"thread start", "first malloc", "second malloc"}, 3};
+
+using Samples = std::vector<std::vector<uint64_t>>;
+
+// ---------------------------------------------------------------------------
+// 子进程：从 main 开始按顺序记录各阶段，结果以二进制写到 stdout
+// ---------------------------------------------------------------------------
+
+// 静态存储，避免构造 heap 本身先经过 glibc 的 operator new
+alignas(my_malloc::ThreadHeap) unsigned char heap_storage[sizeof(my_malloc::ThreadHeap)];
+
+int run_child(uint64_t spawn_ns, bool use_glibc) {
+    uint64_t stages[MAX_STAGES] = {};
+    uint64_t t = now_ns();
+    stages[0] = t - spawn_ns;
+
+    auto lap = [&t](uint64_t& stage) {
+        const uint64_t now = now_ns();
+        stage = now - t;
+        t = now;
+    };
+
+    if (use_glibc) {
+        void* first = std::malloc(FIRST_SIZE);
+        lap(stages[1]);
+        void* second = std::malloc(FIRST_SIZE);
+        lap(stages[2]);
+        std::free(second);
+        std::free(first);
+    } else {
+        my_malloc::SlabConfig::get_instance();
+        lap(stages[1]);
+        auto* heap = new (heap_storage) my_malloc::ThreadHeap();
+        lap(stages[2]);
+        void* first = heap->allocate(FIRST_SIZE);
+        lap(stages[3]);
+        void* second = heap->allocate(FIRST_SIZE);
+        lap(stages[4]);
+        heap->free(second);
+        heap->free(first);
+        heap->~ThreadHeap();
+    }
+
+    return write(STDOUT_FILENO, stages, sizeof(stages)) == static_cast<ssize_t>(sizeof(stages)) ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// 父进程
+// ---------------------------------------------------------------------------
+
+bool spawn_child(bool use_glibc, std::vector<uint64_t>& stages) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+
+    // 参数在 fork 之前准备好，子进程里只做 dup2 和 exec
+    const uint64_t spawn_ns = now_ns();
+    std::string child_arg = "--child=" + std::to_string(spawn_ns);
+    std::string allocator_arg = use_glibc ? "--allocator=glibc" : "--allocator=my_malloc";
+    char exe[] = "/proc/self/exe";
+    char* args[] = {exe, &child_arg[0], &allocator_arg[0], nullptr};
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[1]);
+        execv(exe, args);
+        _exit(127);
+    }
+
+    close(fds[1]);
+    uint64_t values[MAX_STAGES] = {};
+    const bool received = read(fds[0], values, sizeof(values)) == static_cast<ssize_t>(sizeof(values));
+    close(fds[0]);
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !received || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return false;
+    }
+    stages.assign(values, values + MAX_STAGES);
+    return true;
+}
+
+std::vector<uint64_t> run_thread(bool use_glibc) {
+    std::vector<uint64_t> stages(MAX_STAGES, 0);
+    const uint64_t spawn_ns = now_ns();
+
+    std::thread worker([&] {
+        uint64_t t = now_ns();
+        stages[0] = t - spawn_ns;
+        auto lap = [&t](uint64_t& stage) {
+            const uint64_t now = now_ns();
+            stage = now - t;
+            t = now;
+        };
+
+        if (use_glibc) {
+            void* first = std::malloc(FIRST_SIZE);
+            lap(stages[1]);
+            void* second = std::malloc(FIRST_SIZE);
+            lap(stages[2]);
+            std::free(second);
+            std::free(first);
+        } else {
+            // 线程栈上的 heap，和每个工作线程各持有一个 heap 的用法一样
+            my_malloc::ThreadHeap heap;
+            lap(stages[1]);
+            void* first = heap.allocate(FIRST_SIZE);
+            lap(stages[2]);
+            void* second = heap.allocate(FIRST_SIZE);
+            lap(stages[3]);
+            heap.free(second);
+            heap.free(first);
+        }
+    });
+    worker.join();
+    return stages;
+}
+
+double percentile(std::vector<uint64_t> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return static_cast<double>(values[static_cast<size_t>(p * static_cast<double>(values.size() - 1))]) / 1e3;
+}
+
+void print_scenario(const Scenario& scenario, const Samples& samples) {
+    std::printf("  %s (%zu runs)\n", scenario.name, samples.size());
+    std::printf("    %-22s %10s %10s %10s\n", "stage (us)", "median", "p90", "min");
+
+    auto print_stage = [&](const char* name, const std::vector<uint64_t>& values) {
+        std::printf("    %-22s %10.1f %10.1f %10.1f\n",
+                    name, percentile(values, 0.5), percentile(values, 0.9), percentile(values, 0.0));
+    };
+
+    // 总和按每轮单独相加，再取分位数
+    std::vector<uint64_t> totals(samples.size(), 0);
+    for (size_t stage = 0; stage < scenario.num_stages; ++stage) {
+        std::vector<uint64_t> values;
+        for (size_t run = 0; run < samples.size(); ++run) {
+            values.push_back(samples[run][stage]);
+            if (stage + 1 < scenario.num_stages) {
+                totals[run] += samples[run][stage];
+            }
+        }
+        if (stage + 1 == scenario.num_stages) {
+            print_stage("total to first", totals);
+        }
+        print_stage(scenario.stages[stage], values);
+    }
+}
+
+void run_process_mode(size_t runs) {
+    std::printf("process start -> first allocation\n");
+    for (bool use_glibc : {false, true}) {
+        Samples samples;
+        for (size_t i = 0; i < runs; ++i) {
+            std::vector<uint64_t> stages;
+            if (!spawn_child(use_glibc, stages)) {
+                std::fprintf(stderr, "child process failed\n");
+                return;
+            }
+            samples.push_back(stages);
+        }
+        print_scenario(use_glibc ? PROCESS_GLIBC : PROCESS_MY_MALLOC, samples);
+    }
+}
+
+void run_thread_mode(size_t runs) {
+    std::printf("new thread -> first allocation\n");
+
+    // 先让本进程的 SlabConfig 与 glibc 主 arena 都热起来，只测线程自己的开销
+    {
+        my_malloc::ThreadHeap warm;
+        warm.free(warm.allocate(FIRST_SIZE));
+        std::free(std::malloc(FIRST_SIZE));
+    }
+
+    for (bool use_glibc : {false, true}) {
+        Samples samples;
+        for (size_t i = 0; i < runs; ++i) {
+            samples.push_back(run_thread(use_glibc));
+        }
+        print_scenario(use_glibc ? THREAD_GLIBC : THREAD_MY_MALLOC, samples);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* child = my_malloc::bench::get_str_arg(argc, argv, "child", nullptr);
+    const char* allocator = my_malloc::bench::get_str_arg(argc, argv, "allocator", "my_malloc");
+    if (child != nullptr) {
+        return run_child(std::strtoull(child, nullptr, 10), std::strcmp(allocator, "glibc") == 0);
+    }
+
+    const char* mode = my_malloc::bench::get_str_arg(argc, argv, "mode", "all");
+    const size_t runs = my_malloc::bench::get_arg(argc, argv, "runs", 50);
+    if (runs == 0) {
+        return 1;
+    }
+
+    const bool all = std::strcmp(mode, "all") == 0;
+    if (!all && std::strcmp(mode, "process") != 0 && std::strcmp(mode, "thread") != 0) {
+        std::fprintf(stderr, "unknown mode: %s\n", mode);
+        return 1;
+    }
+
+    std::printf("sizeof(ThreadHeap) = %zu bytes\n", sizeof(my_malloc::ThreadHeap));
+    if (all || std::strcmp(mode, "process") == 0) {
+        run_process_mode(runs);
+    }
+    if (all || std::strcmp(mode, "thread") == 0) {
+        run_thread_mode(runs);
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+// 基于 Google Benchmark 的微基准：每个小对象类、中等 span、Huge 对象的申请/释放，
+// LIFO 与 FIFO 两种释放顺序，以及在 slab 边界上来回的分配。
+// 每个用例都紧跟着同样负载下的 glibc malloc，方便直接对比。
+//
+// 用法: gbench_alloc [Google Benchmark 参数]
+//   例如 --benchmark_filter='small/.*/64$' 只跑 64 字节类
+
+#include <benchmark/benchmark.h>
+
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/SlabConfig.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+using my_malloc::PAGE_SIZE;
+using my_malloc::SEGMENT_SIZE;
+using my_malloc::SlabConfig;
+
+struct MyMalloc {
+    my_malloc::ThreadHeap heap;
+
+    void* allocate(size_t size) { return heap.allocate(size); }
+    void release(void* ptr) { heap.free(ptr); }
+};
+
+struct Glibc {
+    void* allocate(size_t size) { return std::malloc(size); }
+    void release(void* ptr) { std::free(ptr); }
+};
+
+// 申请后立即释放，测的是快路径本身。预先留住一个块，
+// 否则小对象的 slab 每次释放后都会变空并被归还
+template <typename Allocator>
+void alloc_free_pair(benchmark::State& state, size_t size) {
+    Allocator allocator;
+    void* pinned = allocator.allocate(size);
+    for (auto _ : state) {
+        void* ptr = allocator.allocate(size);
+        benchmark::DoNotOptimize(ptr);
+        allocator.release(ptr);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size));
+    allocator.release(pinned);
+}
+
+// 一次申请 batch 个块，再按申请顺序 (FIFO) 或逆序 (LIFO) 全部释放
+template <typename Allocator>
+void batch(benchmark::State& state, size_t size, bool fifo) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    Allocator allocator;
+    std::vector<void*> ptrs(count);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i) {
+            ptrs[i] = allocator.allocate(size);
+        }
+        benchmark::ClobberMemory();
+        if (fifo) {
+            for (size_t i = 0; i < count; ++i) {
+                allocator.release(ptrs[i]);
+            }
+        } else {
+            for (size_t i = count; i > 0; --i) {
+                allocator.release(ptrs[i - 1]);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+
+// 先把一个 slab 填满，之后每次申请都要新建 slab，释放后它又变空：
+// 反复穿过 slab 边界，测的是 slab 初始化与归还的开销
+template <typename Allocator>
+void slab_ping_pong(benchmark::State& state, size_t size) {
+    const auto& config = SlabConfig::get_instance();
+    const size_t capacity = config.get_info(config.get_size_class_index(size)).slab_capacity;
+
+    Allocator allocator;
+    std::vector<void*> full(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        full[i] = allocator.allocate(size);
+    }
+
+    for (auto _ : state) {
+        void* ptr = allocator.allocate(size);
+        benchmark::DoNotOptimize(ptr);
+        allocator.release(ptr);
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    for (void* ptr : full) {
+        allocator.release(ptr);
+    }
+}
+
+// 同一负载依次登记 my_malloc 和 glibc 两个用例，输出中两者相邻
+void register_pair(const std::string& group, size_t size,
+                   void (*my_malloc_fn)(benchmark::State&, size_t),
+                   void (*glibc_fn)(benchmark::State&, size_t)) {
+    const std::string suffix = std::to_string(size);
+    benchmark::RegisterBenchmark((group + "/my_malloc/" + suffix).c_str(), my_malloc_fn, size);
+    benchmark::RegisterBenchmark((group + "/glibc/" + suffix).c_str(), glibc_fn, size);
+}
+
+void register_benchmarks() {
+    const auto& config = SlabConfig::get_instance();
+
+    // 每个小对象类取其块大小
+    for (size_t i = 0; i < config.get_num_classes(); ++i) {
+        register_pair("small", config.get_info(i).block_size,
+                      alloc_free_pair<MyMalloc>, alloc_free_pair<Glibc>);
+    }
+
+    // 每个中等类取其 span 大小
+    for (size_t i = 0; i < config.get_num_medium_classes(); ++i) {
+        register_pair("large", config.get_medium_class_pages(i) * PAGE_SIZE,
+                      alloc_free_pair<MyMalloc>, alloc_free_pair<Glibc>);
+    }
+
+    for (size_t size : {2 * SEGMENT_SIZE, 8 * SEGMENT_SIZE, 32 * SEGMENT_SIZE}) {
+        register_pair("huge", size, alloc_free_pair<MyMalloc>, alloc_free_pair<Glibc>);
+    }
+
+    for (size_t size : {size_t{16}, size_t{64}, size_t{256}, size_t{1024}, size_t{4096}}) {
+        const std::string suffix = std::to_string(size);
+        for (bool fifo : {false, true}) {
+            const std::string group = fifo ? "fifo" : "lifo";
+            benchmark::RegisterBenchmark((group + "/my_malloc/" + suffix).c_str(), batch<MyMalloc>, size, fifo)
+                ->Arg(1024);
+            benchmark::RegisterBenchmark((group + "/glibc/" + suffix).c_str(), batch<Glibc>, size, fifo)
+                ->Arg(1024);
+        }
+    }
+
+    for (size_t size : {size_t{64}, size_t{1024}, size_t{16384}}) {
+        register_pair("slab_ping_pong", size, slab_ping_pong<MyMalloc>, slab_ping_pong<Glibc>);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    register_benchmarks();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,167 @@
+// bench/perf_counters.hpp
+#ifndef MY_MALLOC_BENCH_PERF_COUNTERS_HPP
+#define MY_MALLOC_BENCH_PERF_COUNTERS_HPP
+
+#include <my_malloc/sys/perf_event.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sys/resource.h>
+
+namespace my_malloc {
+namespace bench {
+
+// One hardware or software event counted with perf_event_open, for the
+// calling thread and every thread it creates after construction. User
+// space only, so it works under perf_event_paranoid=2. When the event
+// cannot be opened (no PMU in a VM, perf blocked by a seccomp filter)
+// is_available() is false and the counter reads 0.
+class PerfCounter {
+public:
+    PerfCounter(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = perf_event_open(&attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+
+    ~PerfCounter() {
+        if (fd_ >= 0) {
+            perf_event_close(fd_);
+        }
+    }
+
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    bool is_available() const { return fd_ >= 0; }
+
+    void start() {
+        if (fd_ >= 0) {
+            perf_event_ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            perf_event_ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    void stop() {
+        if (fd_ >= 0) {
+            perf_event_ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    // Includes the counts of inherited threads that have already exited.
+    uint64_t read() const {
+        uint64_t value = 0;
+        if (fd_ >= 0 && perf_event_read(fd_, &value, sizeof(value)) != static_cast<long>(sizeof(value))) {
+            value = 0;
+        }
+        return value;
+    }
+
+private:
+    int fd_;
+};
+
+constexpr uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+// Per-operation cost of a measured region: instructions, cycles, L1D and
+// LLC misses, dTLB misses and page faults. Events that cannot be opened
+// are left out of the report. getrusage() is sampled around the region as
+// well, so page faults and CPU time are still reported when perf is not
+// available. Construct before creating the threads to be measured.
+class OpCounters {
+public:
+    OpCounters()
+        : instructions_(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS),
+          cycles_(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES),
+          l1d_misses_(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                                      PERF_COUNT_HW_CACHE_RESULT_MISS)),
+          llc_misses_(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES),
+          dtlb_misses_(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                                       PERF_COUNT_HW_CACHE_RESULT_MISS)),
+          page_faults_(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS),
+          all_{&instructions_, &cycles_, &l1d_misses_, &llc_misses_, &dtlb_misses_, &page_faults_} {}
+
+    OpCounters(const OpCounters&) = delete;
+    OpCounters& operator=(const OpCounters&) = delete;
+
+    // Software events often open where the PMU is hidden, so only the
+    // instruction and cycle counters decide whether rusage time is shown.
+    bool has_hardware() const {
+        return instructions_.is_available() || cycles_.is_available();
+    }
+
+    void start() {
+        getrusage(RUSAGE_SELF, &usage_start_);
+        for (PerfCounter* counter : all_) {
+            counter->start();
+        }
+    }
+
+    void stop() {
+        for (PerfCounter* counter : all_) {
+            counter->stop();
+        }
+        getrusage(RUSAGE_SELF, &usage_stop_);
+    }
+
+    // One line of per-op averages for the last start()/stop() region.
+    void print_per_op(size_t ops) const {
+        const double n = ops ? static_cast<double>(ops) : 1.0;
+        std::printf("  per op:");
+        print_event(instructions_, "instructions", n);
+        print_event(cycles_, "cycles", n);
+        print_event(l1d_misses_, "L1D misses", n);
+        print_event(llc_misses_, "LLC misses", n);
+        print_event(dtlb_misses_, "dTLB misses", n);
+        if (page_faults_.is_available()) {
+            print_event(page_faults_, "page faults", n);
+        } else {
+            const long faults = (usage_stop_.ru_minflt - usage_start_.ru_minflt)
+                              + (usage_stop_.ru_majflt - usage_start_.ru_majflt);
+            std::printf(" %.4f page faults", static_cast<double>(faults) / n);
+        }
+        if (!has_hardware()) {
+            std::printf(" %.1f ns user %.1f ns sys (rusage)",
+                        elapsed_ns(usage_start_.ru_utime, usage_stop_.ru_utime) / n,
+                        elapsed_ns(usage_start_.ru_stime, usage_stop_.ru_stime) / n);
+        }
+        std::printf("\n");
+    }
+
+private:
+    static void print_event(const PerfCounter& counter, const char* name, double ops) {
+        if (counter.is_available()) {
+            std::printf(" %.4f %s", static_cast<double>(counter.read()) / ops, name);
+        }
+    }
+
+    static double elapsed_ns(const timeval& from, const timeval& to) {
+        return (static_cast<double>(to.tv_sec - from.tv_sec) * 1e6 + static_cast<double>(to.tv_usec - from.tv_usec))
+             * 1e3;
+    }
+
+    PerfCounter instructions_;
+    PerfCounter cycles_;
+    PerfCounter l1d_misses_;
+    PerfCounter llc_misses_;
+    PerfCounter dtlb_misses_;
+    PerfCounter page_faults_;
+    PerfCounter* const all_[6];
+    rusage usage_start_{};
+    rusage usage_stop_{};
+};
+
+} // namespace bench
+} // namespace my_malloc
+
+#endif // MY_MALLOC_BENCH_PERF_COUNTERS_HPP
@@ -6,7 +6,10 @@
 
 // Include the new, detailed component headers
 #include <my_malloc/internal/AllocSlab.hpp>
+#include <my_malloc/internal/HeapStats.hpp>
+#include <my_malloc/internal/HugeSegmentCache.hpp>
 #include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/SegmentRegion.hpp>
 #include <my_malloc/internal/SlabConfig.hpp>
 #include <my_malloc/internal/definitions.hpp>
 
@@ -18,6 +21,18 @@ class MappedSegment;
 }
 
 
+enum class BlockKind : uint8_t {
+    SMALL,    // block of a small slab
+    LARGE,    // medium span of whole pages
+    HUGE      // dedicated mapping or region run
+};
+
+struct HeapBlock {
+    void* ptr;
+    size_t usable_size;
+    BlockKind kind;
+};
+
 class ThreadHeap {
     public:
 
@@ -32,12 +47,48 @@ class ThreadHeap {
 
     void* allocate(size_t size);
     void free(void* ptr);
+    void* reallocate(void* ptr, size_t size);
+
+    static size_t get_usable_size(const void* ptr);
+
     void push_pending_free(void* ptr);
 
+    // Sums the counters of every live heap, plus the allocation and free
+    // counts of heaps already destroyed. Heaps keep running meanwhile.
+    static HeapStats get_stats();
+
+    // Same as get_stats() but gives up instead of waiting when a heap is
+    // being created or destroyed concurrently. Usable from signal handlers.
+    static bool try_get_stats(HeapStats& stats);
+
+    // Calls fn on every registered heap while registration is blocked.
+    // Returns false without calling fn when blocking is false and the
+    // registry is busy. fn must take the heap's lock_ itself if it reads
+    // anything other than the counters.
+    static bool for_each_heap(void (*fn)(ThreadHeap& heap, void* arg), void* arg, bool blocking = true);
+
+    // Returns cached medium spans and reserved empty slabs to the page
+    // freelists and purges the dirty pages of cached huge segments and
+    // free region segments. Takes the heap's lock.
+    void purge();
+    static void purge_all_heaps();
+
+    // Calls fn on every live block of this heap. Small slabs are read from
+    // their bitmaps and spans are skipped whole, so the cost follows the
+    // number of spans and live blocks, not the mapped address space. fn
+    // runs under the heap's lock and must not allocate from or free into
+    // this heap. Returns false without calling fn when blocking is false
+    // and the heap is busy.
+    bool heap_walk(void (*fn)(const HeapBlock& block, void* arg), void* arg, bool blocking = true);
+
 // private:
 
+    // Partially used slabs of one class, plus up to empty_slab_reserve
+    // empty ones kept aside and linked through next_.
     struct SlabCache {
         SmallSlabHeader list_head;
+        SmallSlabHeader* empty_slabs = nullptr;
+        size_t num_empty = 0;
         SlabCache() : list_head() {}
     };
 
@@ -45,6 +96,17 @@ class ThreadHeap {
         PendingFreeNode* next;
     };
 
+    // Freed medium spans of one page-count class, linked through their
+    // first bytes. The head page is marked CACHED_SLAB.
+    struct MediumSpanNode {
+        MediumSpanNode* next;
+    };
+
+    struct MediumSpanCache {
+        MediumSpanNode* head = nullptr;
+        size_t count = 0;
+    };
+
 
     std::mutex lock_;
 
@@ -53,22 +115,47 @@ class ThreadHeap {
 
     SlabCache slab_caches_[MAX_NUM_SIZE_CLASSES];
     LargeSlabHeader* free_slabs_[SEGMENT_SIZE / PAGE_SIZE]{};
+    MediumSpanCache medium_caches_[MAX_NUM_MEDIUM_CLASSES];
 
     MappedSegment* active_segments_{nullptr};
     MappedSegment* huge_segments_{nullptr};
 
+    HugeSegmentCache huge_cache_;
+    SegmentRegion segment_region_;
+
+    HeapCounters stats_;
+
+    // Allocated bytes left before the next profiler sample. Sampling is
+    // armed once a countdown has been drawn with a non-zero interval.
+    int64_t bytes_until_sample_{0};
+    bool sampling_armed_{false};
+    uint64_t sample_rng_state_;
+    ThreadHeap* registry_next_{nullptr};
+    ThreadHeap* registry_prev_{nullptr};
+
+    void* allocate_locked(size_t size);
     void* allocate_from_small_slab_cache(size_t class_id);
     void* allocate_huge_slab(size_t size);
+    void* reallocate_huge_slab(MappedSegment* segment, size_t size);
 
 
     void process_pending_frees();
 
+    void sample_allocation(void* ptr, size_t size);
+    static PageDescriptor* get_sample_desc(void* ptr);
+
     SmallSlabHeader* allocate_small_slab(size_t class_id);
     void* allocate_large_slab(uint16_t num_pages);
+    void* allocate_medium_slab(size_t class_id);
+    bool cache_medium_slab(void* slab_ptr, size_t class_id);
     void* acquire_pages(uint16_t num_pages);
+    void* carve_pages(MappedSegment* segment, uint16_t num_pages);
+    void retire_frontier(MappedSegment* segment);
 
     LargeSlabHeader* initialize_as_free_slab(void* slab_ptr, uint16_t num_pages);
 
+    static bool collect_stats(HeapStats& stats, bool blocking);
+
     void free_huge_slab(MappedSegment* segment);
     void free_large_slab(void* slab_ptr);
     void free_in_small_slab(void* ptr, SmallSlabHeader* header);
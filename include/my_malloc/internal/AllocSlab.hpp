@@ -6,6 +6,8 @@
 
 namespace my_malloc {
 
+// Intrusive freelist node written into the first page of a free span.
+// Allocated large slabs keep their length in the PageDescriptor table.
 struct LargeSlabHeader {
     LargeSlabHeader* prev = nullptr;
     LargeSlabHeader* next_ = nullptr;
@@ -0,0 +1,92 @@
+// include/my_malloc/internal/AllocTrace.hpp
+#ifndef MY_MALLOC_ALLOC_INTERNALS_ALLOC_TRACE_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_ALLOC_TRACE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace my_malloc {
+
+constexpr uint64_t TRACE_MAGIC = 0x3145434152544d4dull;   // "MMTRACE1"
+constexpr size_t TRACE_RING_RECORDS = 64 * 1024;
+
+enum class TraceOp : uint8_t {
+    ALLOC,
+    FREE
+};
+
+// One allocator call. The address identifies the object: a replay maps
+// every live address to a dense pointer id while loading the trace.
+struct TraceRecord {
+    uint64_t timestamp_ns;   // CLOCK_MONOTONIC
+    uint64_t address;
+    uint64_t size;           // zero for FREE
+    uint32_t thread_id;      // small per-recording index, not the kernel tid
+    TraceOp op;
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(TraceRecord) == 32, "TraceRecord must stay compact");
+
+struct TraceFileHeader {
+    uint64_t magic;
+    uint32_t record_size;
+    uint32_t reserved;
+};
+
+// Per-thread ring of records. The owning thread appends at head_; whoever
+// holds the trace lock drains [tail_, head_) to the file, so stop() can
+// flush rings of threads that are still running.
+struct TraceRing {
+    TraceRecord* records;
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    uint32_t thread_id;
+    bool in_use;             // cleared when the owning thread exits
+    TraceRing* next;
+};
+
+// Optional recording of every ThreadHeap::allocate/free into a binary
+// file: a TraceFileHeader followed by TraceRecords, in per-thread chunks
+// that are each ordered by time. Rings are mapped on a thread's first
+// record and reused after it exits.
+class AllocTrace {
+public:
+    static AllocTrace& get_instance();
+
+    // Checked on every allocate/free; a static keeps it to one load.
+    static bool is_recording() { return recording_.load(std::memory_order_relaxed); }
+
+    // Truncates path and starts recording. Fails if already recording.
+    bool start(const char* path);
+
+    // Stops recording, drains every ring and closes the file. Records
+    // still in a ring when the process exits without stop() are lost.
+    bool stop();
+
+    void record(TraceOp op, const void* ptr, size_t size);
+
+    uint64_t get_dropped_records() const { return dropped_records_.load(std::memory_order_relaxed); }
+
+// private:
+    AllocTrace() = default;
+
+    TraceRing* acquire_ring();
+    void release_ring(TraceRing* ring);
+    bool drain(TraceRing* ring);
+
+    static std::atomic<bool> recording_;
+
+    std::mutex lock_;        // guards fd_, the ring list and all draining
+    int fd_ = -1;
+    bool write_failed_ = false;
+    TraceRing* rings_ = nullptr;
+    uint32_t next_thread_id_ = 0;
+    std::atomic<uint64_t> dropped_records_{0};
+};
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_ALLOC_TRACE_HPP
@@ -0,0 +1,90 @@
+#ifndef MY_MALLOC_ALLOC_INTERNALS_ALLOCATOR_OPTIONS_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_ALLOCATOR_OPTIONS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace my_malloc {
+
+constexpr size_t DEFAULT_HUGE_CACHE_BUDGET = 256 * 1024 * 1024;
+constexpr uint64_t DEFAULT_HUGE_CACHE_DECAY_MS = 10 * 1000;
+constexpr size_t DEFAULT_HUGETLB_PAGE_SIZE = 2 * 1024 * 1024;
+constexpr size_t DEFAULT_MEDIUM_CACHE_DEPTH = 4;
+constexpr size_t DEFAULT_REGION_MAX_SEGMENTS = 8;
+
+enum class HugeTlbMode : uint8_t {
+    OFF,            // never use MAP_HUGETLB
+    HUGE_ONLY,      // try hugetlb pages for huge allocations
+    ALL_SEGMENTS    // additionally for every regular segment
+};
+
+enum class HugeLayout : uint8_t {
+    INLINE,          // user data directly follows the MappedSegment header
+    SEGMENT_ALIGNED  // user data starts on a SEGMENT_SIZE (2MB) boundary
+};
+
+// Process-wide policy knobs. They may be changed at any time; every heap
+// re-reads them on its next slow-path operation.
+struct AllocatorOptions {
+    // Bytes of faulted-in memory the huge-segment cache of one heap may hold.
+    // Zero disables the cache. Free segments of the segment region are
+    // purged against the same budget.
+    std::atomic<size_t> huge_cache_budget{DEFAULT_HUGE_CACHE_BUDGET};
+
+    // Idle time after which a cached huge segment is purged with MADV_FREE.
+    // The mapping itself stays cached until the cache overflows.
+    std::atomic<uint64_t> huge_cache_decay_ms{DEFAULT_HUGE_CACHE_DECAY_MS};
+
+    // Explicit huge-page backing. Falls back to normal pages when the
+    // hugetlb pool cannot satisfy a mapping. The page size must be a
+    // power of two no smaller than SEGMENT_SIZE (2MB or 1GB on x86-64).
+    std::atomic<HugeTlbMode> hugetlb_mode{HugeTlbMode::OFF};
+    std::atomic<size_t> hugetlb_page_size{DEFAULT_HUGETLB_PAGE_SIZE};
+
+    // Placement of huge allocations. SEGMENT_ALIGNED keeps the header in the
+    // pages just below a 2MB boundary so that the whole user range is
+    // THP-eligible and can be remapped on huge-page boundaries.
+    std::atomic<HugeLayout> huge_layout{HugeLayout::INLINE};
+
+    // Freed spans each medium size class keeps for reuse before they are
+    // returned to the page freelists. Zero disables the span caches.
+    std::atomic<size_t> medium_cache_depth{DEFAULT_MEDIUM_CACHE_DEPTH};
+
+    // Largest huge allocation, in segments, served from the heap's
+    // contiguous segment region instead of a dedicated mapping. Only the
+    // INLINE layout without hugetlb uses the region. Zero disables it.
+    std::atomic<size_t> region_max_segments{DEFAULT_REGION_MAX_SEGMENTS};
+
+    // Mean number of allocated bytes between heap profiler samples, drawn
+    // from a geometric distribution. Zero disables sampling. A heap that
+    // is not sampling re-reads this after PROFILE_RECHECK_BYTES.
+    std::atomic<size_t> profile_sample_interval{0};
+
+    // Empty small slabs each size class keeps for reuse instead of giving
+    // their pages back. Zero releases every slab as soon as it empties.
+    // A lowered reserve is trimmed by the next ThreadHeap::purge().
+    std::atomic<size_t> empty_slab_reserve{0};
+
+    // Options by name, as used by MY_MALLOC_CONF and the opt.* control
+    // keys. Enum options take their lower-case enumerator names or their
+    // numeric values; sizes accept a k, m or g suffix. Returns false for
+    // an unknown name or an invalid value, leaving the option unchanged.
+    bool set(const char* name, const char* value);
+    bool set(const char* name, uint64_t value);
+    bool get(const char* name, uint64_t& value) const;
+
+    // Applies "name:value,name:value". Entries that fail are skipped.
+    // Returns false if any entry failed.
+    bool apply_conf(const char* conf);
+
+    // Calls fn with the name of every option.
+    static void for_each_name(void (*fn)(const char* name, void* arg), void* arg);
+
+    // The first call applies the MY_MALLOC_CONF environment variable.
+    static AllocatorOptions& get_instance();
+};
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_ALLOCATOR_OPTIONS_HPP
@@ -0,0 +1,47 @@
+// include/my_malloc/internal/Control.hpp
+#ifndef MY_MALLOC_ALLOC_INTERNALS_CONTROL_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_CONTROL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace my_malloc {
+
+// String-keyed access to options, statistics and maintenance actions, in
+// the spirit of jemalloc's mallctl. Every value is a uint64_t.
+//
+//   opt.<option>                   read/write, see AllocatorOptions::set
+//   epoch                          write refreshes the stats.* snapshot;
+//                                  read returns the number of refreshes
+//   stats.heaps, stats.live_bytes, stats.slab_bytes,
+//   stats.fragmentation_ppm
+//   stats.huge.{allocs,frees,bytes}
+//   stats.segments.{count,bytes}
+//   stats.syscalls.{mmap,munmap,mremap}
+//   stats.realloc.{in_place,remapped,copies,copied_bytes}
+//   stats.{small,medium}.num_classes
+//   stats.{small,medium}.<class>.{block_size,allocs,frees,live_bytes,slabs,slab_bytes}
+//   stats.slow_paths.<path>.{count,total_ticks,p50,p99,p999}
+//   stats.locks.<site>.{acquisitions,contended,spin_ticks,wait_ticks,
+//                       hold_p50,hold_p99,hold_p999}
+//   stats.prof.{live_samples,dropped_samples}
+//   stats.trace.dropped_records
+//   heap.purge                     write-only, ThreadHeap::purge_all_heaps
+//   prof.reset                     write-only, HeapProfiler::reset_cumulative
+//
+// stats.* read a snapshot taken by the last epoch write, or by the first
+// stats read. All functions return false for an unknown name, a write to
+// a read-only name, or an invalid value.
+bool ctl_read(const char* name, uint64_t& value);
+bool ctl_write(const char* name, uint64_t value);
+
+// Same as ctl_write, with the value in MY_MALLOC_CONF syntax.
+bool ctl_write(const char* name, const char* value);
+
+// Calls fn with every name ctl_read accepts. The name is only valid for
+// the duration of the call.
+void ctl_for_each_name(void (*fn)(const char* name, void* arg), void* arg);
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_CONTROL_HPP
@@ -0,0 +1,87 @@
+// include/my_malloc/internal/HeapInspector.hpp
+#ifndef MY_MALLOC_ALLOC_INTERNALS_HEAP_INSPECTOR_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_HEAP_INSPECTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <my_malloc/internal/StatsReport.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+namespace my_malloc {
+
+class MappedSegment;
+class ThreadHeap;
+
+constexpr size_t SEGMENT_NUM_PAGES = SEGMENT_SIZE / PAGE_SIZE;
+
+// Heat-map cells, one per page. Pages of a small slab show the slab's
+// utilization as a decile digit, or '#' when it is full.
+constexpr char HEAT_METADATA = 'M';
+constexpr char HEAT_FREE = '_';
+constexpr char HEAT_UNTOUCHED = '.';   // beyond the segment's bump frontier
+constexpr char HEAT_LARGE = 'L';
+constexpr char HEAT_CACHED = 'C';      // medium span parked in its class cache
+constexpr char HEAT_FULL = '#';
+
+struct SlabSnapshot {
+    uint16_t first_page;
+    uint16_t class_id;
+    uint16_t used;
+    uint16_t capacity;
+};
+
+struct SegmentSnapshot {
+    const void* address;
+    uint16_t frontier;
+    uint16_t num_slabs;
+
+    uint16_t metadata_pages;
+    uint16_t small_pages;
+    uint16_t large_pages;
+    uint16_t cached_pages;
+    uint16_t free_pages;
+    uint16_t untouched_pages;
+
+    // Longest run of pages a new span could be carved from, counting the
+    // untouched tail as free.
+    uint16_t largest_free_span;
+
+    char heat_map[SEGMENT_NUM_PAGES];
+    SlabSnapshot slabs[SEGMENT_NUM_PAGES];
+};
+
+// Copy of the page layout of one heap's active segments. Capturing holds
+// the heap's lock only while copying; rendering works on the copy, so a
+// live heap is never observed mid-update.
+class HeapSnapshot {
+public:
+    HeapSnapshot() = default;
+    ~HeapSnapshot();
+
+    HeapSnapshot(const HeapSnapshot&) = delete;
+    HeapSnapshot& operator=(const HeapSnapshot&) = delete;
+
+    // Returns false if the heap is busy and blocking is false, or if the
+    // snapshot memory cannot be mapped.
+    bool capture(ThreadHeap& heap, bool blocking = true);
+
+    size_t get_num_segments() const { return num_segments_; }
+    const SegmentSnapshot& get_segment(size_t index) const { return segments_[index]; }
+
+    // ASCII heat map (TEXT) or the same data as one JSON object.
+    void write(int fd, StatsFormat format) const;
+
+// private:
+    void release();
+    static void fill(const MappedSegment* segment, SegmentSnapshot& out);
+
+    const ThreadHeap* heap_ = nullptr;
+    SegmentSnapshot* segments_ = nullptr;
+    size_t num_segments_ = 0;
+    size_t mapped_size_ = 0;
+};
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_HEAP_INSPECTOR_HPP
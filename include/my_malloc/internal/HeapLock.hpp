@@ -0,0 +1,121 @@
+// include/my_malloc/internal/HeapLock.hpp
+#ifndef MY_MALLOC_ALLOC_INTERNALS_HEAP_LOCK_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_HEAP_LOCK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include <my_malloc/internal/HeapStats.hpp>
+
+namespace my_malloc {
+
+// try_lock attempts before a contended acquisition blocks.
+constexpr size_t LOCK_SPIN_LIMIT = 128;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Scoped owner of a heap's lock_. With MY_MALLOC_LOCK_STATS it counts the
+// acquisition, times any spinning and blocking, and records the hold time
+// into the site's histogram just before unlocking; every counter is
+// written while the lock is held. Otherwise it is a plain lock_guard.
+// The std::defer_lock form leaves the lock to lock() or try_lock(), for
+// callers that must not wait on a busy heap; a failed try_lock() is not
+// counted as an acquisition.
+class HeapLockGuard {
+public:
+    HeapLockGuard(std::mutex& lock, HeapCounters& counters, LockSite site)
+        : HeapLockGuard(lock, counters, site, std::defer_lock) {
+        this->lock();
+    }
+
+    HeapLockGuard(const HeapLockGuard&) = delete;
+    HeapLockGuard& operator=(const HeapLockGuard&) = delete;
+
+#ifdef MY_MALLOC_LOCK_STATS
+    HeapLockGuard(std::mutex& lock, HeapCounters& counters, LockSite site, std::defer_lock_t)
+        : lock_(lock), counters_(counters.locks[static_cast<size_t>(site)]) {}
+
+    void lock() {
+        owned_ = true;
+        if (lock_.try_lock()) {
+            HeapCounters::add(counters_.acquisitions, 1);
+            start_ = read_tick_counter();
+            return;
+        }
+
+        const uint64_t spin_start = read_tick_counter();
+        bool acquired = false;
+        for (size_t i = 0; i < LOCK_SPIN_LIMIT && !acquired; ++i) {
+            cpu_relax();
+            acquired = lock_.try_lock();
+        }
+        const uint64_t spin_end = read_tick_counter();
+        if (!acquired) {
+            lock_.lock();
+        }
+        start_ = read_tick_counter();
+
+        HeapCounters::add(counters_.acquisitions, 1);
+        HeapCounters::add(counters_.contended, 1);
+        HeapCounters::add(counters_.spin_ticks, spin_end - spin_start);
+        if (!acquired) {
+            HeapCounters::add(counters_.wait_ticks, start_ - spin_end);
+        }
+    }
+
+    bool try_lock() {
+        owned_ = lock_.try_lock();
+        if (owned_) {
+            HeapCounters::add(counters_.acquisitions, 1);
+            start_ = read_tick_counter();
+        }
+        return owned_;
+    }
+
+    ~HeapLockGuard() {
+        if (owned_) {
+            counters_.hold.record(read_tick_counter() - start_);
+            lock_.unlock();
+        }
+    }
+
+private:
+    std::mutex& lock_;
+    LockCounters& counters_;
+    uint64_t start_ = 0;
+    bool owned_ = false;
+#else
+    HeapLockGuard(std::mutex& lock, HeapCounters&, LockSite, std::defer_lock_t) : lock_(lock) {}
+
+    void lock() {
+        lock_.lock();
+        owned_ = true;
+    }
+
+    bool try_lock() {
+        owned_ = lock_.try_lock();
+        return owned_;
+    }
+
+    ~HeapLockGuard() {
+        if (owned_) {
+            lock_.unlock();
+        }
+    }
+
+private:
+    std::mutex& lock_;
+    bool owned_ = false;
+#endif
+};
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_HEAP_LOCK_HPP
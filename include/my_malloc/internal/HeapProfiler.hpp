@@ -0,0 +1,101 @@
+// include/my_malloc/internal/HeapProfiler.hpp
+#ifndef MY_MALLOC_ALLOC_INTERNALS_HEAP_PROFILER_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_HEAP_PROFILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include <my_malloc/internal/definitions.hpp>
+
+namespace my_malloc {
+
+constexpr size_t PROFILE_MAX_DEPTH = 32;
+constexpr size_t PROFILE_BUCKET_SLOTS = 4096;
+constexpr size_t PROFILE_LIVE_SLOTS = 64 * 1024;
+
+// A heap with sampling disabled looks at the option again after this
+// many allocated bytes.
+constexpr int64_t PROFILE_RECHECK_BYTES = 16 * 1024 * 1024;
+
+// Sampled allocations aggregated by call stack.
+struct ProfileBucket {
+    uint64_t hash;
+    uint32_t depth;
+    bool used;
+    void* stack[PROFILE_MAX_DEPTH];
+    uint64_t inuse_objects;
+    uint64_t inuse_bytes;
+    uint64_t alloc_objects;   // cumulative since the last reset_cumulative()
+    uint64_t alloc_bytes;
+};
+
+struct LiveSample {
+    const void* ptr;          // nullptr marks an empty slot
+    const ThreadHeap* heap;
+    size_t size;
+    size_t bucket;
+};
+
+// Process-wide store for heap samples. The heaps decide when to sample;
+// this class only keeps the samples and writes profiles. Both tables are
+// mapped on the first sample and have a fixed size: samples that do not
+// fit are counted as dropped.
+class HeapProfiler {
+public:
+    static HeapProfiler& get_instance();
+
+    // Records a sampled allocation and bumps desc->sampled.
+    bool record_allocation(const void* ptr, size_t size, const ThreadHeap* heap,
+                           void* const* stack, size_t depth, size_t interval, PageDescriptor* desc);
+
+    // Retires the sample for ptr, if any, and drops desc->sampled.
+    bool record_free(const void* ptr, PageDescriptor* desc);
+
+    // Re-keys a sample whose object was moved by an in-place realloc.
+    void record_move(const void* old_ptr, const void* new_ptr, size_t new_size);
+
+    // Retires every sample of a heap that is being destroyed.
+    void retire_heap(const ThreadHeap* heap);
+
+    // Writes a legacy pprof heap profile ("heap_v2" text format). Every
+    // stack carries its in-use and its cumulative sampled counts, so the
+    // same file serves -sample_index=inuse_space and alloc_space.
+    bool write_profile(int fd);
+    bool write_profile(const char* path);
+
+    // Starts a new cumulative profile; live samples are kept.
+    void reset_cumulative();
+
+    size_t get_live_samples();
+    uint64_t get_dropped_samples();
+
+    // Walks the frame-pointer chain, skipping the innermost `skip` frames.
+    // Frames of code built without frame pointers are lost or end the walk.
+    static size_t capture_stack(void** frames, size_t max_depth, size_t skip);
+
+    // Bytes until the next sample, geometric with the given mean.
+    static int64_t next_sample_distance(uint64_t* rng_state, size_t interval);
+
+// private:
+    HeapProfiler() = default;
+
+    bool map_tables();
+    size_t find_or_add_bucket(void* const* stack, size_t depth);
+    size_t find_live(const void* ptr) const;
+    void erase_live(size_t slot);
+
+    static size_t live_slot_of(const void* ptr);
+
+    std::mutex lock_;
+    ProfileBucket* buckets_ = nullptr;
+    LiveSample* live_ = nullptr;
+    size_t num_buckets_ = 0;
+    size_t num_live_ = 0;
+    uint64_t dropped_samples_ = 0;
+    size_t last_interval_ = 0;
+};
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_HEAP_PROFILER_HPP
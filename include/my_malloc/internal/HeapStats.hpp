@@ -0,0 +1,266 @@
+// include/my_malloc/internal/HeapStats.hpp
+#ifndef MY_MALLOC_ALLOC_INTERNALS_HEAP_STATS_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_HEAP_STATS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <my_malloc/internal/SlabConfig.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <ctime>
+#endif
+
+namespace my_malloc {
+
+// Rare, variable-cost operations whose latency is recorded when the
+// library is built with MY_MALLOC_LATENCY_HISTOGRAMS.
+enum class SlowPath : uint8_t {
+    SEGMENT_CREATE,    // mapping a new 2MB segment
+    HUGE_MAP,          // mapping a huge object the caches could not serve
+    SPAN_SPLIT,        // splitting a larger free span in acquire_pages
+    SMALL_SLAB_INIT,   // stamping the page descriptors of a new small slab
+    SPAN_RELEASE       // coalescing a freed span with its neighbours
+};
+
+constexpr size_t NUM_SLOW_PATHS = 5;
+
+// Bucket i counts durations of [2^(i-1), 2^i) ticks; bucket 0 counts zero.
+constexpr size_t LATENCY_BUCKETS = 40;
+
+#ifdef MY_MALLOC_LATENCY_HISTOGRAMS
+constexpr bool LATENCY_HISTOGRAMS_ENABLED = true;
+#else
+constexpr bool LATENCY_HISTOGRAMS_ENABLED = false;
+#endif
+
+// Places that take a heap's lock_, timed when the library is built with
+// MY_MALLOC_LOCK_STATS.
+enum class LockSite : uint8_t {
+    ALLOCATE,       // ThreadHeap::allocate
+    FREE,           // small and medium frees
+    HUGE_FREE,      // unlinking a huge object
+    REALLOC,        // resizing an object in place
+    PURGE,          // ThreadHeap::purge
+    INSPECT         // heap walks, snapshots and segment dumps
+};
+
+constexpr size_t NUM_LOCK_SITES = 6;
+
+#ifdef MY_MALLOC_LOCK_STATS
+constexpr bool LOCK_STATS_ENABLED = true;
+#else
+constexpr bool LOCK_STATS_ENABLED = false;
+#endif
+
+inline const char* lock_site_name(LockSite site) {
+    switch (site) {
+        case LockSite::ALLOCATE:     return "allocate";
+        case LockSite::FREE:         return "free";
+        case LockSite::HUGE_FREE:    return "huge_free";
+        case LockSite::REALLOC:      return "realloc";
+        case LockSite::PURGE:        return "purge";
+        case LockSite::INSPECT:      return "inspect";
+    }
+    return "unknown";
+}
+
+inline const char* slow_path_name(SlowPath path) {
+    switch (path) {
+        case SlowPath::SEGMENT_CREATE:  return "segment_create";
+        case SlowPath::HUGE_MAP:        return "huge_map";
+        case SlowPath::SPAN_SPLIT:      return "span_split";
+        case SlowPath::SMALL_SLAB_INIT: return "small_slab_init";
+        case SlowPath::SPAN_RELEASE:    return "span_release";
+    }
+    return "unknown";
+}
+
+// TSC ticks on x86, nanoseconds elsewhere.
+inline uint64_t read_tick_counter() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+// Counters of one size class. Only the owning heap writes them, always
+// under its lock, so increments are a relaxed load plus a relaxed store
+// rather than a locked read-modify-write. Readers on other threads may
+// observe them at any time without stopping the heap.
+struct ClassCounters {
+    std::atomic<uint64_t> allocs{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> slabs{0};    // slabs (small) or spans (medium) owned by the class
+};
+
+struct LatencyCounters {
+    std::atomic<uint64_t> buckets[LATENCY_BUCKETS] = {};
+    std::atomic<uint64_t> total_ticks{0};
+
+    static size_t bucket_of(uint64_t ticks) {
+        const size_t width = ticks == 0 ? 0 : static_cast<size_t>(64 - __builtin_clzll(ticks));
+        return width < LATENCY_BUCKETS ? width : LATENCY_BUCKETS - 1;
+    }
+
+    void record(uint64_t ticks);
+};
+
+// Acquisitions of the heap lock at one site. A contended acquisition
+// first spins on try_lock, then blocks; both phases are timed.
+struct LockCounters {
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> spin_ticks{0};
+    std::atomic<uint64_t> wait_ticks{0};
+    LatencyCounters hold;
+};
+
+struct HeapCounters {
+    ClassCounters small[MAX_NUM_SIZE_CLASSES];
+    ClassCounters medium[MAX_NUM_MEDIUM_CLASSES];
+
+    std::atomic<uint64_t> huge_allocs{0};
+    std::atomic<uint64_t> huge_frees{0};
+    std::atomic<uint64_t> huge_bytes{0};        // mapped bytes of live huge objects
+    std::atomic<uint64_t> segments{0};          // regular 2MB segments owned by the heap
+
+    // Outcomes of reallocate.
+    std::atomic<uint64_t> realloc_in_place{0};      // same pointer returned
+    std::atomic<uint64_t> realloc_remapped{0};      // huge object moved by mremap, nothing copied
+    std::atomic<uint64_t> realloc_copies{0};        // new block allocated and the data copied
+    std::atomic<uint64_t> realloc_copied_bytes{0};
+
+    LatencyCounters slow_paths[NUM_SLOW_PATHS];
+    LockCounters locks[NUM_LOCK_SITES];
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    static void sub(std::atomic<uint64_t>& counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) - delta, std::memory_order_relaxed);
+    }
+};
+
+inline void LatencyCounters::record(uint64_t ticks) {
+    HeapCounters::add(buckets[bucket_of(ticks)], 1);
+    HeapCounters::add(total_ticks, ticks);
+}
+
+// Times one slow path into the heap's histogram. Compiles to nothing
+// unless MY_MALLOC_LATENCY_HISTOGRAMS is defined. Must be destroyed
+// before the heap lock is released.
+class SlowPathTimer {
+public:
+#ifdef MY_MALLOC_LATENCY_HISTOGRAMS
+    SlowPathTimer(HeapCounters& counters, SlowPath path)
+        : counters_(counters.slow_paths[static_cast<size_t>(path)]), start_(read_tick_counter()) {}
+    ~SlowPathTimer() { counters_.record(read_tick_counter() - start_); }
+
+private:
+    LatencyCounters& counters_;
+    uint64_t start_;
+#else
+    SlowPathTimer(HeapCounters&, SlowPath) {}
+#endif
+};
+
+// Snapshot of one size class. live_bytes counts whole blocks (small) or
+// whole spans (medium); slab_bytes is the memory the class holds.
+struct SizeClassStats {
+    size_t block_size = 0;
+    uint64_t allocs = 0;
+    uint64_t frees = 0;
+    uint64_t live_bytes = 0;
+    uint64_t slabs = 0;
+    uint64_t slab_bytes = 0;
+};
+
+struct LatencyHistogram {
+    uint64_t count = 0;
+    uint64_t total_ticks = 0;
+    uint64_t buckets[LATENCY_BUCKETS] = {};
+
+    // Upper bound, in ticks, of the bucket holding the p-quantile (p in
+    // [0, 1]). Resolution is a factor of two.
+    uint64_t percentile(double p) const {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(count) + 0.999999);
+        rank = rank == 0 ? 1 : rank;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return uint64_t{1} << i;
+            }
+        }
+        return uint64_t{1} << (LATENCY_BUCKETS - 1);
+    }
+
+    uint64_t mean() const { return count == 0 ? 0 : total_ticks / count; }
+};
+
+// hold.count equals acquisitions once every holder has released.
+struct LockStats {
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;
+    uint64_t spin_ticks = 0;
+    uint64_t wait_ticks = 0;
+    LatencyHistogram hold;
+};
+
+// Aggregated view over every registered heap. Allocation, free and
+// realloc counts, slow-path latencies and lock counters of destroyed heaps
+// are retained; live quantities are not.
+struct HeapStats {
+    size_t num_heaps = 0;
+
+    size_t num_small_classes = 0;
+    SizeClassStats small_classes[MAX_NUM_SIZE_CLASSES];
+    size_t num_medium_classes = 0;
+    SizeClassStats medium_classes[MAX_NUM_MEDIUM_CLASSES];
+
+    uint64_t huge_allocs = 0;
+    uint64_t huge_frees = 0;
+    uint64_t huge_bytes = 0;
+
+    uint64_t segments = 0;
+    uint64_t segment_bytes = 0;
+
+    uint64_t mmap_calls = 0;
+    uint64_t munmap_calls = 0;
+    uint64_t mremap_calls = 0;
+
+    uint64_t realloc_in_place = 0;
+    uint64_t realloc_remapped = 0;
+    uint64_t realloc_copies = 0;
+    uint64_t realloc_copied_bytes = 0;
+
+    // Totals over small and medium classes.
+    uint64_t live_bytes = 0;
+    uint64_t slab_bytes = 0;
+
+    // Empty unless LATENCY_HISTOGRAMS_ENABLED. Indexed by SlowPath.
+    LatencyHistogram slow_paths[NUM_SLOW_PATHS];
+
+    // Empty unless LOCK_STATS_ENABLED. Indexed by LockSite.
+    LockStats locks[NUM_LOCK_SITES];
+
+    // Share of slab memory not backing a live object.
+    double fragmentation() const {
+        return slab_bytes <= live_bytes ? 0.0 : static_cast<double>(slab_bytes - live_bytes) / static_cast<double>(slab_bytes);
+    }
+};
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_HEAP_STATS_HPP
@@ -0,0 +1,61 @@
+#ifndef MY_MALLOC_ALLOC_INTERNALS_HUGE_SEGMENT_CACHE_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_HUGE_SEGMENT_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <my_malloc/internal/definitions.hpp>
+
+namespace my_malloc {
+
+class MappedSegment;
+
+// Huge mappings are rounded to quarter-power-of-two buckets between 2MB and 1GB,
+// so that a freed mapping can serve any later request in the same bucket.
+constexpr size_t HUGE_CACHE_MIN_SHIFT = 21;
+constexpr size_t HUGE_CACHE_MAX_SHIFT = 30;
+constexpr size_t HUGE_CACHE_STEPS_PER_SHIFT = 4;
+constexpr size_t HUGE_CACHE_NUM_BUCKETS = (HUGE_CACHE_MAX_SHIFT - HUGE_CACHE_MIN_SHIFT + 1) * HUGE_CACHE_STEPS_PER_SHIFT;
+constexpr size_t HUGE_CACHE_MAX_PER_BUCKET = 4;
+
+
+class HugeSegmentCache {
+public:
+    HugeSegmentCache() = default;
+
+    HugeSegmentCache(const HugeSegmentCache&) = delete;
+    HugeSegmentCache& operator=(const HugeSegmentCache&) = delete;
+
+    static size_t round_to_bucket_size(size_t mapping_size);
+    static size_t get_bucket_index(size_t mapping_size);
+
+    static uint64_t now_ms();
+
+    MappedSegment* take(size_t mapping_size, bool aligned_layout, uint64_t now);
+    bool put(MappedSegment* segment, uint64_t now);
+
+    void decay(uint64_t now);
+    void purge_all();
+    void release_all();
+
+    size_t get_cached_bytes() const { return cached_bytes_; }
+    size_t get_dirty_bytes() const { return dirty_bytes_; }
+
+// private:
+
+    void unlink(MappedSegment* segment, size_t bucket);
+    void purge(MappedSegment* segment);
+    void reclaim(MappedSegment* segment, size_t bucket);
+    void release(MappedSegment* segment, size_t bucket);
+    MappedSegment* find_oldest_dirty(size_t* bucket_out) const;
+
+    MappedSegment* buckets_[HUGE_CACHE_NUM_BUCKETS]{};
+    uint16_t bucket_counts_[HUGE_CACHE_NUM_BUCKETS]{};
+
+    size_t cached_bytes_ = 0;
+    size_t dirty_bytes_ = 0;
+};
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_HUGE_SEGMENT_CACHE_HPP
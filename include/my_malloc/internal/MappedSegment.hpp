@@ -13,6 +13,15 @@ namespace my_malloc {
 
 class ThreadHeap;
 
+// Process-wide counters for the mapping layer.
+struct SegmentCounters {
+    std::atomic<uint64_t> hugetlb_hits{0};
+    std::atomic<uint64_t> hugetlb_fallbacks{0};
+    std::atomic<uint64_t> mmap_calls{0};
+    std::atomic<uint64_t> munmap_calls{0};
+    std::atomic<uint64_t> mremap_calls{0};
+};
+
 class MappedSegment {
 public:
     struct ListNode {
@@ -22,10 +31,32 @@ public:
 
     ListNode list_node;
 
-    static MappedSegment* create(size_t segment_size = SEGMENT_SIZE);
+    static MappedSegment* create(size_t segment_size = SEGMENT_SIZE, bool try_hugetlb = false);
+    static MappedSegment* create_huge(size_t mapping_size, bool aligned_layout, bool try_hugetlb);
     static void destroy(MappedSegment* segment);
+    static MappedSegment* remap(MappedSegment* segment, size_t new_size);
 
     static MappedSegment* get_segment(const void* ptr);
+    static MappedSegment* get_owning_segment(const void* ptr);
+
+    static SegmentCounters& get_counters();
+    static size_t get_hugetlb_page_size();
+
+    bool is_hugetlb() const {
+        return (flags_ & FLAG_HUGETLB) != 0;
+    }
+
+    bool is_aligned_huge() const {
+        return (flags_ & FLAG_ALIGNED_HUGE) != 0;
+    }
+
+    bool is_region_backed() const {
+        return (flags_ & FLAG_REGION) != 0;
+    }
+
+    size_t get_huge_user_offset() const;
+    void* get_huge_user_ptr();
+    size_t get_huge_usable_size() const;
 
     ThreadHeap* get_owner_heap() const { 
         return owner_heap_; 
@@ -37,12 +68,21 @@ public:
     
     PageDescriptor* get_page_desc(const void* ptr);
     const PageDescriptor* get_page_desc(const void* ptr) const;
+
+    // Resets every descriptor past the metadata pages to FREE. The
+    // constructor relies on a zero-filled mapping, so this is needed only
+    // when the header lands on memory that was in use before.
+    void clear_page_descriptors();
     
 // private:
 
     MappedSegment();
     ~MappedSegment();
 
+    static void* map_aligned(size_t segment_size, size_t align_offset = 0);
+    static void* map_hugetlb(size_t segment_size, size_t* mapped_size);
+    static MappedSegment* create_mapping(size_t mapping_size, size_t align_offset, bool try_hugetlb);
+
     MappedSegment(const MappedSegment&) = delete;
     MappedSegment& operator=(const MappedSegment&) = delete;
     MappedSegment(MappedSegment&&) = delete;
@@ -53,9 +93,31 @@ public:
     
     size_t total_size_;
 
+    // Bump frontier of a regular segment: pages from this index on have never
+    // been handed out, their descriptors are FREE with a null slab_ptr. Only
+    // the descriptors below it are ever written.
     uint16_t next_free_page_idx_ = 0;
+
+    static constexpr uint8_t FLAG_PURGED = 0x1;
+    static constexpr uint8_t FLAG_HUGETLB = 0x2;
+    static constexpr uint8_t FLAG_ALIGNED_HUGE = 0x4;
+    static constexpr uint8_t FLAG_REGION = 0x8;
+
+    uint8_t flags_ = 0;
+    uint64_t last_used_ms_ = 0;
+
+    // Distance from the start of the mapping to this header. Non-zero only for
+    // hugetlb mappings that carry a 2MB-aligned huge allocation.
+    size_t mapping_offset_ = 0;
 };
 
+// Page-rounded header size. A 2MB-aligned huge allocation starts exactly
+// this far past its MappedSegment.
+constexpr size_t SEGMENT_METADATA_SIZE = (sizeof(MappedSegment) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+// Pages of a regular segment left for slabs after the header.
+constexpr size_t SEGMENT_USABLE_PAGES = (SEGMENT_SIZE - SEGMENT_METADATA_SIZE) / PAGE_SIZE;
+
 
 inline MappedSegment* MappedSegment::get_segment(const void* ptr) {
     return reinterpret_cast<MappedSegment*>(
@@ -63,6 +125,28 @@ inline MappedSegment* MappedSegment::get_segment(const void* ptr) {
     );
 }
 
+// User pointers on a SEGMENT_SIZE boundary only come from the aligned huge
+// layout: every regular segment starts with its own metadata pages.
+inline MappedSegment* MappedSegment::get_owning_segment(const void* ptr) {
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+    if ((addr & (SEGMENT_SIZE - 1)) == 0) {
+        return reinterpret_cast<MappedSegment*>(addr - SEGMENT_METADATA_SIZE);
+    }
+    return get_segment(ptr);
+}
+
+inline size_t MappedSegment::get_huge_user_offset() const {
+    return is_aligned_huge() ? SEGMENT_METADATA_SIZE : sizeof(MappedSegment);
+}
+
+inline void* MappedSegment::get_huge_user_ptr() {
+    return reinterpret_cast<char*>(this) + get_huge_user_offset();
+}
+
+inline size_t MappedSegment::get_huge_usable_size() const {
+    return total_size_ - mapping_offset_ - get_huge_user_offset();
+}
+
 inline PageDescriptor* MappedSegment::get_page_desc(const void* ptr) {
     const size_t page_index = (reinterpret_cast<uintptr_t>(ptr) - reinterpret_cast<uintptr_t>(this)) / PAGE_SIZE;
     return &page_descriptors_[page_index];
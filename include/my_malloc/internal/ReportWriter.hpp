@@ -0,0 +1,136 @@
+// include/my_malloc/internal/ReportWriter.hpp
+#ifndef MY_MALLOC_ALLOC_INTERNALS_REPORT_WRITER_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_REPORT_WRITER_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <unistd.h>
+
+namespace my_malloc {
+
+// Formats into a fixed stack buffer and drains it with write(2). It never
+// allocates, so reports can be produced from a signal handler or while
+// the allocator itself is being inspected.
+class ReportWriter {
+public:
+    explicit ReportWriter(int fd) : fd_(fd) {}
+    ~ReportWriter() { flush(); }
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    // Left-aligned, padded with spaces up to width.
+    ReportWriter& str(const char* s, size_t width = 0) {
+        size_t n = 0;
+        for (; s[n] != '\0'; ++n) {
+            put(s[n]);
+        }
+        pad(n, width);
+        return *this;
+    }
+
+    ReportWriter& bytes(const char* data, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            put(data[i]);
+        }
+        return *this;
+    }
+
+    // Right-aligned.
+    ReportWriter& num(uint64_t value, size_t width = 0) {
+        char digits[20];
+        size_t n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        pad(n, width);
+        while (n > 0) {
+            put(digits[--n]);
+        }
+        return *this;
+    }
+
+    // Prints scaled / 10^decimals with exactly `decimals` fractional digits.
+    ReportWriter& fixed(uint64_t scaled, unsigned decimals, size_t width = 0) {
+        uint64_t divisor = 1;
+        for (unsigned i = 0; i < decimals; ++i) {
+            divisor *= 10;
+        }
+        const uint64_t integral = scaled / divisor;
+        pad(count_digits(integral) + 1 + decimals, width);
+        num(integral);
+        put('.');
+        uint64_t fraction = scaled % divisor;
+        for (unsigned i = 0; i < decimals; ++i) {
+            divisor /= 10;
+            put(static_cast<char>('0' + fraction / divisor));
+            fraction %= divisor;
+        }
+        return *this;
+    }
+
+    ReportWriter& hex(const void* ptr) {
+        static const char kDigits[] = "0123456789abcdef";
+        uintptr_t value = reinterpret_cast<uintptr_t>(ptr);
+        char digits[2 * sizeof(uintptr_t)];
+        size_t n = 0;
+        do {
+            digits[n++] = kDigits[value & 0xF];
+            value >>= 4;
+        } while (value != 0);
+        put('0');
+        put('x');
+        while (n > 0) {
+            put(digits[--n]);
+        }
+        return *this;
+    }
+
+    void flush() {
+        size_t written = 0;
+        while (written < len_) {
+            const ssize_t ret = ::write(fd_, buf_ + written, len_ - written);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                break;
+            }
+            written += static_cast<size_t>(ret);
+        }
+        len_ = 0;
+    }
+
+private:
+    void put(char c) {
+        if (len_ == sizeof(buf_)) {
+            flush();
+        }
+        buf_[len_++] = c;
+    }
+
+    void pad(size_t used, size_t width) {
+        for (size_t i = used; i < width; ++i) {
+            put(' ');
+        }
+    }
+
+    static size_t count_digits(uint64_t value) {
+        size_t n = 1;
+        while (value >= 10) {
+            value /= 10;
+            ++n;
+        }
+        return n;
+    }
+
+    int fd_;
+    char buf_[1024];
+    size_t len_ = 0;
+};
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_REPORT_WRITER_HPP
@@ -0,0 +1,60 @@
+#ifndef MY_MALLOC_ALLOC_INTERNALS_SEGMENT_REGION_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_SEGMENT_REGION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <my_malloc/internal/definitions.hpp>
+
+namespace my_malloc {
+
+class MappedSegment;
+
+// A heap reserves one contiguous, SEGMENT_SIZE-aligned region on first use
+// and hands out runs of whole segments from it. Free segments are tracked
+// in a bitmap, so neighbouring runs merge as soon as they are returned.
+constexpr size_t SEGMENT_REGION_NUM_SEGMENTS = 64;
+
+static_assert(SEGMENT_REGION_NUM_SEGMENTS <= 64, "The free map is a single 64-bit word");
+
+
+class SegmentRegion {
+public:
+    SegmentRegion() = default;
+
+    SegmentRegion(const SegmentRegion&) = delete;
+    SegmentRegion& operator=(const SegmentRegion&) = delete;
+
+    // Returns a run of num_segments segments with a fresh MappedSegment
+    // header at its start, or nullptr if no such run is free.
+    MappedSegment* take(size_t num_segments);
+    void put(MappedSegment* segment);
+
+    bool contains(const void* ptr) const;
+    void release_all();
+
+    // Purges every free segment that may still hold faulted-in pages.
+    void purge_free();
+
+    size_t get_free_segments() const;
+    size_t get_dirty_free_bytes() const;
+
+// private:
+
+    bool reserve();
+    size_t find_free_run(size_t num_segments) const;
+    void purge_run(size_t first, size_t num_segments);
+
+    static uint64_t run_mask(size_t first, size_t num_segments);
+
+    char* base_ = nullptr;
+    bool reserve_failed_ = false;
+
+    uint64_t free_mask_ = 0;   // bit i: segment i is free
+    uint64_t dirty_mask_ = 0;  // bit i: segment i may hold faulted-in pages
+    uint64_t used_mask_ = 0;   // bit i: segment i has been handed out before
+};
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_SEGMENT_REGION_HPP
@@ -12,6 +12,7 @@ namespace my_malloc {
 namespace my_malloc {
 constexpr size_t MAX_SMALL_OBJECT_SIZE = 256 * 1024;
 constexpr size_t MAX_NUM_SIZE_CLASSES = 128;
+constexpr size_t MAX_NUM_MEDIUM_CLASSES = 32;
 
 
 
@@ -34,12 +35,19 @@ public:
 
     size_t get_num_classes() const { return num_classes_; }
 
+    // Medium objects (above MAX_SMALL_OBJECT_SIZE, within one segment) are
+    // rounded up to a page-count class in quarter-power-of-two steps.
+    size_t get_medium_class_index(size_t num_pages) const;
+    uint16_t get_medium_class_pages(size_t index) const;
+    size_t get_num_medium_classes() const { return num_medium_classes_; }
+
 // private:
     SlabConfig(); 
 
     void initialize_size_classes();
     void calculate_derived_parameters();
     void build_lookup_table();
+    void initialize_medium_classes();
     
     SlabConfig(const SlabConfig&) = delete;
     SlabConfig& operator=(const SlabConfig&) = delete;
@@ -50,6 +58,10 @@ public:
     size_t num_classes_;
 
     uint8_t size_to_class_map_[MAX_SMALL_OBJECT_SIZE + 1];
+
+    uint16_t medium_class_pages_[MAX_NUM_MEDIUM_CLASSES];
+    size_t num_medium_classes_;
+    uint8_t pages_to_medium_class_map_[SEGMENT_SIZE / PAGE_SIZE + 1];
 };
 
 } // namespace my_malloc
@@ -0,0 +1,34 @@
+// include/my_malloc/internal/StatsReport.hpp
+#ifndef MY_MALLOC_ALLOC_INTERNALS_STATS_REPORT_HPP
+#define MY_MALLOC_ALLOC_INTERNALS_STATS_REPORT_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+namespace my_malloc {
+
+enum class StatsFormat : uint8_t {
+    TEXT,   // human-readable tables
+    JSON    // one JSON object, for tooling
+};
+
+// Writes a per-class table built from ThreadHeap::get_stats() and the
+// slab configuration, followed by the page occupancy of every segment.
+// Output goes through write(2) from a fixed buffer and no heap memory is
+// allocated. A heap that is busy is reported as such rather than waited
+// for, so this is safe to call from a signal handler.
+void dump_stats(int fd, StatsFormat format = StatsFormat::TEXT);
+
+// Flushes the stream first, then writes to its descriptor.
+void dump_stats(FILE* out, StatsFormat format = StatsFormat::TEXT);
+
+// Dumps to fd whenever signum is delivered. Returns false if the handler
+// could not be installed.
+bool install_stats_signal_handler(int signum, int fd = 2, StatsFormat format = StatsFormat::TEXT);
+
+// Dumps to fd once when the process exits normally.
+bool dump_stats_at_exit(int fd = 2, StatsFormat format = StatsFormat::TEXT);
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_ALLOC_INTERNALS_STATS_REPORT_HPP
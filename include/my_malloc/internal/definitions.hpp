@@ -4,6 +4,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
 
 namespace my_malloc {
     class ThreadHeap;
@@ -19,15 +20,31 @@ enum class PageStatus : uint8_t {
     METADATA,
     LARGE_SLAB,
     SMALL_SLAB,
-    HUGE_SLAB 
+    HUGE_SLAB,
+    CACHED_SLAB   // first page of a medium span parked in its class cache
 };
 
 
+// No member initializers: constructing a MappedSegment must not write all
+// of its descriptors. The all-zero pattern of a fresh mapping is a FREE
+// page with a null slab_ptr; memory that is handed out again without being
+// unmapped is reset with MappedSegment::clear_page_descriptors().
 struct PageDescriptor {
-    PageStatus status = PageStatus::FREE;
-    void* slab_ptr = nullptr;
+    PageStatus status;
+    // Live profiler samples that start on this page, saturating at 255.
+    // free() only consults the profiler when it is non-zero.
+    uint8_t sampled;
+    // Length of a large slab, kept on its first page so that the slab
+    // itself carries no header and its user pointer stays page-aligned.
+    uint16_t num_pages;
+    void* slab_ptr;
 };
 
+static_assert(sizeof(PageDescriptor) == 2 * sizeof(void*), "PageDescriptor must stay two words");
+static_assert(std::is_trivially_default_constructible<PageDescriptor>::value,
+              "PageDescriptor must not be written by the MappedSegment constructor");
+static_assert(static_cast<uint8_t>(PageStatus::FREE) == 0, "A zero-filled descriptor must be FREE");
+
 } // namespace my_malloc
 
 #endif // MY_MALLOC_ALLOC_INTERNALS_DEFINITIONS_HPP
\ No newline at end of file
@@ -18,8 +18,19 @@ extern "C" {
 #define MAP_PRIVATE     0x02
 #define MAP_ANONYMOUS   0x20
 #define MAP_ANON        MAP_ANONYMOUS
+#define MAP_HUGETLB     0x40000
+#define MAP_HUGE_SHIFT  26
+#define MAP_HUGE_MASK   0x3f
+#define MAP_HUGE_2MB    (21 << MAP_HUGE_SHIFT)
+#define MAP_HUGE_1GB    (30 << MAP_HUGE_SHIFT)
 #define MAP_FAILED      (reinterpret_cast<void*>(-1))
 
+#define MADV_DONTNEED   4
+#define MADV_FREE       8
+
+#define MREMAP_MAYMOVE  1
+#define MREMAP_FIXED    2
+
 
 static inline void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
     long ret = SYSCALL6(__NR_mmap, addr, length, prot, flags, fd, offset);
@@ -30,6 +41,15 @@ static inline int munmap(void* addr, size_t length) {
     return static_cast<int>(SYSCALL2(__NR_munmap, addr, length));
 }
 
+static inline void* mremap(void* old_addr, size_t old_size, size_t new_size, int flags, void* new_addr) {
+    long ret = SYSCALL5(__NR_mremap, old_addr, old_size, new_size, flags, new_addr);
+    return reinterpret_cast<void*>(ret);
+}
+
+static inline int madvise(void* addr, size_t length, int advice) {
+    return static_cast<int>(SYSCALL3(__NR_madvise, addr, length, advice));
+}
+
 
 #ifdef __cplusplus
 } // extern "C"
@@ -0,0 +1,41 @@
+#ifndef MY_PERF_EVENT_HPP
+#define MY_PERF_EVENT_HPP
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <my_malloc/sys/syscall.hpp>
+
+// perf_event_open(2) and the calls needed to drive the returned fd, made
+// directly through the raw syscall macros. The names carry a perf_event_
+// prefix so they do not collide with the libc read/close/ioctl
+// declarations of any translation unit that also includes <unistd.h>.
+
+static inline int perf_event_open(struct perf_event_attr* attr, pid_t pid, int cpu, int group_fd,
+                                  unsigned long flags) {
+    return static_cast<int>(SYSCALL5(__NR_perf_event_open, attr, pid, cpu, group_fd, flags));
+}
+
+static inline int perf_event_ioctl(int fd, unsigned long request, unsigned long arg) {
+    return static_cast<int>(SYSCALL3(__NR_ioctl, fd, request, arg));
+}
+
+static inline long perf_event_read(int fd, void* buf, size_t count) {
+    return SYSCALL3(__NR_read, fd, buf, count);
+}
+
+static inline int perf_event_close(int fd) {
+    return static_cast<int>(SYSCALL1(__NR_close, fd));
+}
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // MY_PERF_EVENT_HPP
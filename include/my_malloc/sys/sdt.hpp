@@ -0,0 +1,73 @@
+#ifndef MY_SDT_HPP
+#define MY_SDT_HPP
+
+// USDT probes in the SystemTap v3 note format read by perf, bpftrace and
+// bcc, e.g. `bpftrace -e 'usdt:./app:my_malloc:segment_create { ... }'`.
+// Each probe site is a single nop plus an ELF note outside the loaded
+// image; a tracer that attaches rewrites the nop into a breakpoint.
+// Arguments are only materialized into registers or stack slots.
+//
+// Equivalent to <sys/sdt.h> without the dependency. Semaphores are not
+// emitted, so arguments must be cheap to compute. Define
+// MY_MALLOC_DISABLE_SDT to compile every probe away.
+
+#include <type_traits>
+
+#if !defined(MY_MALLOC_DISABLE_SDT) && defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+
+// Signed arguments are described as -size@location.
+#define MY_SDT_ARG_SIZE(x) \
+    ((std::is_signed<typename std::decay<decltype(x)>::type>::value ? 1 : -1) * static_cast<int>(sizeof(x)))
+
+#define MY_SDT_OPERAND(n, x) [sdt_s##n] "n"(MY_SDT_ARG_SIZE(x)), [sdt_a##n] "nor"(x)
+#define MY_SDT_ARGFMT(n) "%n[sdt_s" #n "]@%[sdt_a" #n "]"
+
+#define MY_SDT_NOTE(provider, name, args)                                        \
+    "990: nop\n"                                                                 \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                                \
+    ".balign 4\n"                                                                \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                           \
+    "991: .asciz \"stapsdt\"\n"                                                  \
+    "992: .balign 4\n"                                                           \
+    "993: .8byte 990b\n"                                                         \
+    ".8byte _.stapsdt.base\n"                                                    \
+    ".8byte 0\n"                                                                 \
+    ".asciz \"" #provider "\"\n"                                                 \
+    ".asciz \"" #name "\"\n"                                                     \
+    ".asciz \"" args "\"\n"                                                      \
+    "994: .balign 4\n"                                                           \
+    ".popsection\n"                                                              \
+    ".ifndef _.stapsdt.base\n"                                                   \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"      \
+    ".weak _.stapsdt.base\n"                                                     \
+    ".hidden _.stapsdt.base\n"                                                   \
+    "_.stapsdt.base: .space 1\n"                                                 \
+    ".size _.stapsdt.base, 1\n"                                                  \
+    ".popsection\n"                                                              \
+    ".endif\n"
+
+#define MY_SDT_PROBE0(provider, name) \
+    __asm__ __volatile__(MY_SDT_NOTE(provider, name, ""))
+
+#define MY_SDT_PROBE1(provider, name, a1) \
+    __asm__ __volatile__(MY_SDT_NOTE(provider, name, MY_SDT_ARGFMT(1)) \
+                         :: MY_SDT_OPERAND(1, a1))
+
+#define MY_SDT_PROBE2(provider, name, a1, a2) \
+    __asm__ __volatile__(MY_SDT_NOTE(provider, name, MY_SDT_ARGFMT(1) " " MY_SDT_ARGFMT(2)) \
+                         :: MY_SDT_OPERAND(1, a1), MY_SDT_OPERAND(2, a2))
+
+#define MY_SDT_PROBE3(provider, name, a1, a2, a3) \
+    __asm__ __volatile__(MY_SDT_NOTE(provider, name, MY_SDT_ARGFMT(1) " " MY_SDT_ARGFMT(2) " " MY_SDT_ARGFMT(3)) \
+                         :: MY_SDT_OPERAND(1, a1), MY_SDT_OPERAND(2, a2), MY_SDT_OPERAND(3, a3))
+
+#else
+
+#define MY_SDT_PROBE0(provider, name) do { } while (0)
+#define MY_SDT_PROBE1(provider, name, a1) do { (void)(a1); } while (0)
+#define MY_SDT_PROBE2(provider, name, a1, a2) do { (void)(a1); (void)(a2); } while (0)
+#define MY_SDT_PROBE3(provider, name, a1, a2, a3) do { (void)(a1); (void)(a2); (void)(a3); } while (0)
+
+#endif
+
+#endif // MY_SDT_HPP
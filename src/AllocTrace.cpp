@@ -0,0 +1,186 @@
+#include <my_malloc/internal/AllocTrace.hpp>
+#include <my_malloc/sys/mman.hpp>
+
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <new>
+#include <unistd.h>
+
+namespace my_malloc {
+
+namespace {
+
+static_assert((TRACE_RING_RECORDS & (TRACE_RING_RECORDS - 1)) == 0, "Ring size must be a power of two");
+
+constexpr size_t RING_HEADER_SIZE = (sizeof(TraceRing) + 63) & ~size_t{63};
+constexpr size_t RING_MAPPING_SIZE = RING_HEADER_SIZE + TRACE_RING_RECORDS * sizeof(TraceRecord);
+
+// 线程退出时把 ring 交还，留给之后的线程复用
+struct TraceThread {
+    TraceRing* ring = nullptr;
+
+    ~TraceThread() {
+        if (ring != nullptr) {
+            AllocTrace::get_instance().release_ring(ring);
+        }
+    }
+};
+
+thread_local TraceThread tls_trace;
+
+uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+bool write_all(int fd, const void* data, size_t len) {
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        const ssize_t n = ::write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+std::atomic<bool> AllocTrace::recording_{false};
+
+AllocTrace& AllocTrace::get_instance() {
+    static AllocTrace instance;
+    return instance;
+}
+
+bool AllocTrace::start(const char* path) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (fd_ >= 0) {
+        return false;
+    }
+
+    const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    const TraceFileHeader header{TRACE_MAGIC, sizeof(TraceRecord), 0};
+    if (!write_all(fd, &header, sizeof(header))) {
+        ::close(fd);
+        return false;
+    }
+
+    // 上次停止后才写入 ring 的记录不属于这次跟踪
+    for (TraceRing* ring = rings_; ring != nullptr; ring = ring->next) {
+        ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    fd_ = fd;
+    write_failed_ = false;
+    recording_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool AllocTrace::stop() {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (fd_ < 0) {
+        return false;
+    }
+    recording_.store(false, std::memory_order_relaxed);
+
+    for (TraceRing* ring = rings_; ring != nullptr; ring = ring->next) {
+        drain(ring);
+    }
+    const bool closed = ::close(fd_) == 0;
+    fd_ = -1;
+    return closed && !write_failed_;
+}
+
+void AllocTrace::record(TraceOp op, const void* ptr, size_t size) {
+    TraceRing* ring = tls_trace.ring;
+    if (ring == nullptr) {
+        ring = tls_trace.ring = acquire_ring();
+        if (ring == nullptr) {
+            dropped_records_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // 只有本线程推进 head；写满时自己落盘
+    const uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) == TRACE_RING_RECORDS) {
+        std::lock_guard<std::mutex> guard(lock_);
+        drain(ring);
+    }
+
+    TraceRecord& rec = ring->records[head & (TRACE_RING_RECORDS - 1)];
+    rec.timestamp_ns = now_ns();
+    rec.address = reinterpret_cast<uintptr_t>(ptr);
+    rec.size = size;
+    rec.thread_id = ring->thread_id;
+    rec.op = op;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+TraceRing* AllocTrace::acquire_ring() {
+    std::lock_guard<std::mutex> guard(lock_);
+    for (TraceRing* ring = rings_; ring != nullptr; ring = ring->next) {
+        if (!ring->in_use) {
+            ring->in_use = true;
+            ring->thread_id = next_thread_id_++;
+            return ring;
+        }
+    }
+
+    void* mem = mmap(nullptr, RING_MAPPING_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        return nullptr;
+    }
+    auto* ring = new (mem) TraceRing();
+    ring->records = reinterpret_cast<TraceRecord*>(static_cast<char*>(mem) + RING_HEADER_SIZE);
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->thread_id = next_thread_id_++;
+    ring->in_use = true;
+    ring->next = rings_;
+    rings_ = ring;
+    return ring;
+}
+
+void AllocTrace::release_ring(TraceRing* ring) {
+    std::lock_guard<std::mutex> guard(lock_);
+    drain(ring);
+    ring->in_use = false;
+}
+
+bool AllocTrace::drain(TraceRing* ring) {
+    const uint64_t head = ring->head.load(std::memory_order_acquire);
+    const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    const uint64_t count = head - tail;
+    if (count == 0) {
+        return true;
+    }
+
+    bool ok = false;
+    if (fd_ >= 0 && !write_failed_) {
+        // 环形区间最多分成两段
+        const size_t first = tail & (TRACE_RING_RECORDS - 1);
+        const size_t part = count < TRACE_RING_RECORDS - first ? count : TRACE_RING_RECORDS - first;
+        ok = write_all(fd_, ring->records + first, part * sizeof(TraceRecord)) &&
+             write_all(fd_, ring->records, (count - part) * sizeof(TraceRecord));
+        write_failed_ = !ok;
+    }
+    if (!ok) {
+        dropped_records_.fetch_add(count, std::memory_order_relaxed);
+    }
+    ring->tail.store(head, std::memory_order_release);
+    return ok;
+}
+
+} // namespace my_malloc
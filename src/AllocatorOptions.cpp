@@ -0,0 +1,219 @@
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace my_malloc {
+
+namespace {
+
+enum class OptionKind : uint8_t {
+    SIZE,
+    HUGETLB_MODE,
+    HUGE_LAYOUT,
+    HUGETLB_PAGE_SIZE,
+    DECAY_MS
+};
+
+struct OptionEntry {
+    const char* name;
+    OptionKind kind;
+    std::atomic<size_t> AllocatorOptions::*field;   // 仅 SIZE 和 HUGETLB_PAGE_SIZE 使用
+};
+
+const OptionEntry OPTIONS[] = {
+    {"huge_cache_budget",       OptionKind::SIZE,              &AllocatorOptions::huge_cache_budget},
+    {"huge_cache_decay_ms",     OptionKind::DECAY_MS,          nullptr},
+    {"hugetlb_mode",            OptionKind::HUGETLB_MODE,      nullptr},
+    {"hugetlb_page_size",       OptionKind::HUGETLB_PAGE_SIZE, &AllocatorOptions::hugetlb_page_size},
+    {"huge_layout",             OptionKind::HUGE_LAYOUT,       nullptr},
+    {"medium_cache_depth",      OptionKind::SIZE,              &AllocatorOptions::medium_cache_depth},
+    {"region_max_segments",     OptionKind::SIZE,              &AllocatorOptions::region_max_segments},
+    {"profile_sample_interval", OptionKind::SIZE,              &AllocatorOptions::profile_sample_interval},
+    {"empty_slab_reserve",      OptionKind::SIZE,              &AllocatorOptions::empty_slab_reserve},
+};
+
+const char* const HUGETLB_MODE_NAMES[] = {"off", "huge_only", "all_segments"};
+const char* const HUGE_LAYOUT_NAMES[] = {"inline", "segment_aligned"};
+
+const OptionEntry* find_option(const char* name, size_t len) {
+    for (const OptionEntry& entry : OPTIONS) {
+        if (std::strlen(entry.name) == len && std::strncmp(entry.name, name, len) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+// 十进制数，可带 k/m/g 后缀
+bool parse_number(const char* text, size_t len, uint64_t& value) {
+    if (len == 0) {
+        return false;
+    }
+    uint64_t result = 0;
+    size_t i = 0;
+    for (; i < len && text[i] >= '0' && text[i] <= '9'; ++i) {
+        const uint64_t digit = static_cast<uint64_t>(text[i] - '0');
+        if (result > (UINT64_MAX - digit) / 10) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    if (i == 0) {
+        return false;
+    }
+    if (i + 1 == len) {
+        unsigned shift;
+        switch (text[i]) {
+            case 'k': case 'K': shift = 10; break;
+            case 'm': case 'M': shift = 20; break;
+            case 'g': case 'G': shift = 30; break;
+            default: return false;
+        }
+        if (result > (UINT64_MAX >> shift)) {
+            return false;
+        }
+        result <<= shift;
+    } else if (i != len) {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+bool parse_enum(const char* text, size_t len, const char* const* names, size_t count, uint64_t& value) {
+    for (size_t i = 0; i < count; ++i) {
+        if (std::strlen(names[i]) == len && std::strncmp(names[i], text, len) == 0) {
+            value = i;
+            return true;
+        }
+    }
+    return parse_number(text, len, value) && value < count;
+}
+
+bool set_entry(AllocatorOptions& options, const OptionEntry& entry, uint64_t value) {
+    switch (entry.kind) {
+        case OptionKind::SIZE:
+            (options.*entry.field).store(static_cast<size_t>(value), std::memory_order_relaxed);
+            return true;
+        case OptionKind::HUGETLB_PAGE_SIZE:
+            if (value < SEGMENT_SIZE || (value & (value - 1)) != 0) {
+                return false;
+            }
+            (options.*entry.field).store(static_cast<size_t>(value), std::memory_order_relaxed);
+            return true;
+        case OptionKind::DECAY_MS:
+            options.huge_cache_decay_ms.store(value, std::memory_order_relaxed);
+            return true;
+        case OptionKind::HUGETLB_MODE:
+            if (value > static_cast<uint64_t>(HugeTlbMode::ALL_SEGMENTS)) {
+                return false;
+            }
+            options.hugetlb_mode.store(static_cast<HugeTlbMode>(value), std::memory_order_relaxed);
+            return true;
+        case OptionKind::HUGE_LAYOUT:
+            if (value > static_cast<uint64_t>(HugeLayout::SEGMENT_ALIGNED)) {
+                return false;
+            }
+            options.huge_layout.store(static_cast<HugeLayout>(value), std::memory_order_relaxed);
+            return true;
+    }
+    return false;
+}
+
+bool set_from_text(AllocatorOptions& options, const char* name, size_t name_len, const char* text, size_t text_len) {
+    const OptionEntry* entry = find_option(name, name_len);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    uint64_t value;
+    bool parsed;
+    switch (entry->kind) {
+        case OptionKind::HUGETLB_MODE:
+            parsed = parse_enum(text, text_len, HUGETLB_MODE_NAMES, 3, value);
+            break;
+        case OptionKind::HUGE_LAYOUT:
+            parsed = parse_enum(text, text_len, HUGE_LAYOUT_NAMES, 2, value);
+            break;
+        default:
+            parsed = parse_number(text, text_len, value);
+            break;
+    }
+    return parsed && set_entry(options, *entry, value);
+}
+
+} // namespace
+
+bool AllocatorOptions::set(const char* name, const char* value) {
+    return set_from_text(*this, name, std::strlen(name), value, std::strlen(value));
+}
+
+bool AllocatorOptions::set(const char* name, uint64_t value) {
+    const OptionEntry* entry = find_option(name, std::strlen(name));
+    return entry != nullptr && set_entry(*this, *entry, value);
+}
+
+bool AllocatorOptions::get(const char* name, uint64_t& value) const {
+    const OptionEntry* entry = find_option(name, std::strlen(name));
+    if (entry == nullptr) {
+        return false;
+    }
+    switch (entry->kind) {
+        case OptionKind::SIZE:
+        case OptionKind::HUGETLB_PAGE_SIZE:
+            value = (this->*entry->field).load(std::memory_order_relaxed);
+            break;
+        case OptionKind::DECAY_MS:
+            value = huge_cache_decay_ms.load(std::memory_order_relaxed);
+            break;
+        case OptionKind::HUGETLB_MODE:
+            value = static_cast<uint64_t>(hugetlb_mode.load(std::memory_order_relaxed));
+            break;
+        case OptionKind::HUGE_LAYOUT:
+            value = static_cast<uint64_t>(huge_layout.load(std::memory_order_relaxed));
+            break;
+    }
+    return true;
+}
+
+bool AllocatorOptions::apply_conf(const char* conf) {
+    if (conf == nullptr) {
+        return true;
+    }
+
+    bool ok = true;
+    const char* entry = conf;
+    while (*entry != '\0') {
+        const char* end = std::strchr(entry, ',');
+        if (end == nullptr) {
+            end = entry + std::strlen(entry);
+        }
+        const char* colon = static_cast<const char*>(std::memchr(entry, ':', static_cast<size_t>(end - entry)));
+        if (colon == nullptr ||
+            !set_from_text(*this, entry, static_cast<size_t>(colon - entry), colon + 1, static_cast<size_t>(end - colon - 1))) {
+            ok = false;
+        }
+        entry = *end == ',' ? end + 1 : end;
+    }
+    return ok;
+}
+
+void AllocatorOptions::for_each_name(void (*fn)(const char* name, void* arg), void* arg) {
+    for (const OptionEntry& entry : OPTIONS) {
+        fn(entry.name, arg);
+    }
+}
+
+AllocatorOptions& AllocatorOptions::get_instance() {
+    // 直接在局部对象上解析，避免初始化过程中递归调用 get_instance
+    static AllocatorOptions* instance = [] {
+        static AllocatorOptions options;
+        options.apply_conf(std::getenv("MY_MALLOC_CONF"));
+        return &options;
+    }();
+    return *instance;
+}
+
+} // namespace my_malloc
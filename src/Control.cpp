@@ -0,0 +1,287 @@
+#include <my_malloc/internal/Control.hpp>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocTrace.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/HeapProfiler.hpp>
+#include <my_malloc/internal/HeapStats.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace my_malloc {
+
+namespace {
+
+struct StatsSnapshot {
+    std::mutex lock;
+    uint64_t epoch = 0;
+    HeapStats stats;
+    uint64_t live_samples = 0;
+    uint64_t dropped_samples = 0;
+    uint64_t dropped_records = 0;
+};
+
+// 与注册表一样不析构，退出过程中仍可读取
+StatsSnapshot& get_snapshot() {
+    alignas(StatsSnapshot) static unsigned char storage[sizeof(StatsSnapshot)];
+    static StatsSnapshot* snapshot = new (storage) StatsSnapshot();
+    return *snapshot;
+}
+
+void refresh(StatsSnapshot& snapshot) {
+    snapshot.stats = ThreadHeap::get_stats();
+    snapshot.live_samples = HeapProfiler::get_instance().get_live_samples();
+    snapshot.dropped_samples = HeapProfiler::get_instance().get_dropped_samples();
+    snapshot.dropped_records = AllocTrace::get_instance().get_dropped_records();
+    snapshot.epoch++;
+}
+
+// name 以 word 开头且后面紧跟 '.' 时返回 '.' 之后的部分
+const char* child(const char* name, const char* word) {
+    const size_t len = std::strlen(word);
+    return std::strncmp(name, word, len) == 0 && name[len] == '.' ? name + len + 1 : nullptr;
+}
+
+bool is(const char* name, const char* word) {
+    return std::strcmp(name, word) == 0;
+}
+
+const char* const CLASS_FIELDS[] = {"block_size", "allocs", "frees", "live_bytes", "slabs", "slab_bytes"};
+const char* const LATENCY_FIELDS[] = {"count", "total_ticks", "p50", "p99", "p999"};
+const char* const LOCK_FIELDS[] = {"acquisitions", "contended", "spin_ticks", "wait_ticks", "hold_p50", "hold_p99", "hold_p999"};
+
+bool read_class(const char* name, const SizeClassStats* classes, size_t num_classes, uint64_t& value) {
+    if (is(name, "num_classes")) {
+        value = num_classes;
+        return true;
+    }
+
+    size_t index = 0;
+    size_t digits = 0;
+    for (; name[digits] >= '0' && name[digits] <= '9'; ++digits) {
+        index = index * 10 + static_cast<size_t>(name[digits] - '0');
+    }
+    if (digits == 0 || name[digits] != '.' || index >= num_classes) {
+        return false;
+    }
+
+    const SizeClassStats& cls = classes[index];
+    const char* field = name + digits + 1;
+    if (is(field, "block_size")) { value = cls.block_size; return true; }
+    if (is(field, "allocs")) { value = cls.allocs; return true; }
+    if (is(field, "frees")) { value = cls.frees; return true; }
+    if (is(field, "live_bytes")) { value = cls.live_bytes; return true; }
+    if (is(field, "slabs")) { value = cls.slabs; return true; }
+    if (is(field, "slab_bytes")) { value = cls.slab_bytes; return true; }
+    return false;
+}
+
+bool read_slow_path(const char* name, const HeapStats& stats, uint64_t& value) {
+    for (size_t i = 0; i < NUM_SLOW_PATHS; ++i) {
+        const char* field = child(name, slow_path_name(static_cast<SlowPath>(i)));
+        if (field == nullptr) {
+            continue;
+        }
+        const LatencyHistogram& histogram = stats.slow_paths[i];
+        if (is(field, "count")) { value = histogram.count; return true; }
+        if (is(field, "total_ticks")) { value = histogram.total_ticks; return true; }
+        if (is(field, "p50")) { value = histogram.percentile(0.5); return true; }
+        if (is(field, "p99")) { value = histogram.percentile(0.99); return true; }
+        if (is(field, "p999")) { value = histogram.percentile(0.999); return true; }
+        return false;
+    }
+    return false;
+}
+
+bool read_lock(const char* name, const HeapStats& stats, uint64_t& value) {
+    for (size_t i = 0; i < NUM_LOCK_SITES; ++i) {
+        const char* field = child(name, lock_site_name(static_cast<LockSite>(i)));
+        if (field == nullptr) {
+            continue;
+        }
+        const LockStats& lock = stats.locks[i];
+        if (is(field, "acquisitions")) { value = lock.acquisitions; return true; }
+        if (is(field, "contended")) { value = lock.contended; return true; }
+        if (is(field, "spin_ticks")) { value = lock.spin_ticks; return true; }
+        if (is(field, "wait_ticks")) { value = lock.wait_ticks; return true; }
+        if (is(field, "hold_p50")) { value = lock.hold.percentile(0.5); return true; }
+        if (is(field, "hold_p99")) { value = lock.hold.percentile(0.99); return true; }
+        if (is(field, "hold_p999")) { value = lock.hold.percentile(0.999); return true; }
+        return false;
+    }
+    return false;
+}
+
+bool read_stats(const char* name, const StatsSnapshot& snapshot, uint64_t& value) {
+    const HeapStats& stats = snapshot.stats;
+    const char* rest;
+
+    if (is(name, "heaps")) { value = stats.num_heaps; return true; }
+    if (is(name, "live_bytes")) { value = stats.live_bytes; return true; }
+    if (is(name, "slab_bytes")) { value = stats.slab_bytes; return true; }
+    if (is(name, "fragmentation_ppm")) {
+        value = static_cast<uint64_t>(stats.fragmentation() * 1000000 + 0.5);
+        return true;
+    }
+    if ((rest = child(name, "huge")) != nullptr) {
+        if (is(rest, "allocs")) { value = stats.huge_allocs; return true; }
+        if (is(rest, "frees")) { value = stats.huge_frees; return true; }
+        if (is(rest, "bytes")) { value = stats.huge_bytes; return true; }
+        return false;
+    }
+    if ((rest = child(name, "segments")) != nullptr) {
+        if (is(rest, "count")) { value = stats.segments; return true; }
+        if (is(rest, "bytes")) { value = stats.segment_bytes; return true; }
+        return false;
+    }
+    if ((rest = child(name, "realloc")) != nullptr) {
+        if (is(rest, "in_place")) { value = stats.realloc_in_place; return true; }
+        if (is(rest, "remapped")) { value = stats.realloc_remapped; return true; }
+        if (is(rest, "copies")) { value = stats.realloc_copies; return true; }
+        if (is(rest, "copied_bytes")) { value = stats.realloc_copied_bytes; return true; }
+        return false;
+    }
+    if ((rest = child(name, "syscalls")) != nullptr) {
+        if (is(rest, "mmap")) { value = stats.mmap_calls; return true; }
+        if (is(rest, "munmap")) { value = stats.munmap_calls; return true; }
+        if (is(rest, "mremap")) { value = stats.mremap_calls; return true; }
+        return false;
+    }
+    if ((rest = child(name, "small")) != nullptr) {
+        return read_class(rest, stats.small_classes, stats.num_small_classes, value);
+    }
+    if ((rest = child(name, "medium")) != nullptr) {
+        return read_class(rest, stats.medium_classes, stats.num_medium_classes, value);
+    }
+    if ((rest = child(name, "slow_paths")) != nullptr) {
+        return read_slow_path(rest, stats, value);
+    }
+    if ((rest = child(name, "locks")) != nullptr) {
+        return read_lock(rest, stats, value);
+    }
+    if ((rest = child(name, "prof")) != nullptr) {
+        if (is(rest, "live_samples")) { value = snapshot.live_samples; return true; }
+        if (is(rest, "dropped_samples")) { value = snapshot.dropped_samples; return true; }
+        return false;
+    }
+    if (is(name, "trace.dropped_records")) {
+        value = snapshot.dropped_records;
+        return true;
+    }
+    return false;
+}
+
+struct NameContext {
+    void (*fn)(const char* name, void* arg);
+    void* arg;
+};
+
+void emit_option(const char* option, void* arg) {
+    auto* ctx = static_cast<NameContext*>(arg);
+    char name[96];
+    std::snprintf(name, sizeof(name), "opt.%s", option);
+    ctx->fn(name, ctx->arg);
+}
+
+} // namespace
+
+bool ctl_read(const char* name, uint64_t& value) {
+    const char* rest;
+    if ((rest = child(name, "opt")) != nullptr) {
+        return AllocatorOptions::get_instance().get(rest, value);
+    }
+
+    StatsSnapshot& snapshot = get_snapshot();
+    std::lock_guard<std::mutex> guard(snapshot.lock);
+    if (is(name, "epoch")) {
+        value = snapshot.epoch;
+        return true;
+    }
+    if ((rest = child(name, "stats")) != nullptr) {
+        if (snapshot.epoch == 0) {
+            refresh(snapshot);
+        }
+        return read_stats(rest, snapshot, value);
+    }
+    return false;
+}
+
+bool ctl_write(const char* name, uint64_t value) {
+    const char* rest;
+    if ((rest = child(name, "opt")) != nullptr) {
+        return AllocatorOptions::get_instance().set(rest, value);
+    }
+    if (is(name, "epoch")) {
+        StatsSnapshot& snapshot = get_snapshot();
+        std::lock_guard<std::mutex> guard(snapshot.lock);
+        refresh(snapshot);
+        return true;
+    }
+    if (is(name, "heap.purge")) {
+        ThreadHeap::purge_all_heaps();
+        return true;
+    }
+    if (is(name, "prof.reset")) {
+        HeapProfiler::get_instance().reset_cumulative();
+        return true;
+    }
+    return false;
+}
+
+bool ctl_write(const char* name, const char* value) {
+    const char* rest = child(name, "opt");
+    if (rest != nullptr) {
+        return AllocatorOptions::get_instance().set(rest, value);
+    }
+    // 动作类的键忽略取值
+    return ctl_write(name, uint64_t{0});
+}
+
+void ctl_for_each_name(void (*fn)(const char* name, void* arg), void* arg) {
+    NameContext ctx{fn, arg};
+    AllocatorOptions::for_each_name(emit_option, &ctx);
+
+    const char* const leaves[] = {
+        "epoch", "stats.heaps", "stats.live_bytes", "stats.slab_bytes", "stats.fragmentation_ppm",
+        "stats.huge.allocs", "stats.huge.frees", "stats.huge.bytes",
+        "stats.segments.count", "stats.segments.bytes",
+        "stats.syscalls.mmap", "stats.syscalls.munmap", "stats.syscalls.mremap",
+        "stats.realloc.in_place", "stats.realloc.remapped", "stats.realloc.copies", "stats.realloc.copied_bytes",
+        "stats.small.num_classes", "stats.medium.num_classes",
+        "stats.prof.live_samples", "stats.prof.dropped_samples", "stats.trace.dropped_records",
+    };
+    for (const char* leaf : leaves) {
+        fn(leaf, arg);
+    }
+
+    const auto& config = SlabConfig::get_instance();
+    char name[96];
+    for (size_t i = 0; i < config.get_num_classes(); ++i) {
+        for (const char* field : CLASS_FIELDS) {
+            std::snprintf(name, sizeof(name), "stats.small.%zu.%s", i, field);
+            fn(name, arg);
+        }
+    }
+    for (size_t i = 0; i < config.get_num_medium_classes(); ++i) {
+        for (const char* field : CLASS_FIELDS) {
+            std::snprintf(name, sizeof(name), "stats.medium.%zu.%s", i, field);
+            fn(name, arg);
+        }
+    }
+    for (size_t i = 0; i < NUM_SLOW_PATHS; ++i) {
+        for (const char* field : LATENCY_FIELDS) {
+            std::snprintf(name, sizeof(name), "stats.slow_paths.%s.%s", slow_path_name(static_cast<SlowPath>(i)), field);
+            fn(name, arg);
+        }
+    }
+    for (size_t i = 0; i < NUM_LOCK_SITES; ++i) {
+        for (const char* field : LOCK_FIELDS) {
+            std::snprintf(name, sizeof(name), "stats.locks.%s.%s", lock_site_name(static_cast<LockSite>(i)), field);
+            fn(name, arg);
+        }
+    }
+}
+
+} // namespace my_malloc
@@ -0,0 +1,198 @@
+#include <my_malloc/internal/HeapInspector.hpp>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocSlab.hpp>
+#include <my_malloc/internal/HeapLock.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/ReportWriter.hpp>
+#include <my_malloc/internal/SlabConfig.hpp>
+#include <my_malloc/sys/mman.hpp>
+
+#include <mutex>
+
+namespace my_malloc {
+
+namespace {
+
+constexpr size_t HEAT_MAP_ROW = 64;
+
+char utilization_cell(uint16_t used, uint16_t capacity) {
+    if (capacity == 0 || used >= capacity) {
+        return HEAT_FULL;
+    }
+    return static_cast<char>('0' + used * 10 / capacity);
+}
+
+} // namespace
+
+HeapSnapshot::~HeapSnapshot() {
+    release();
+}
+
+void HeapSnapshot::release() {
+    if (segments_ != nullptr) {
+        munmap(segments_, mapped_size_);
+    }
+    segments_ = nullptr;
+    num_segments_ = 0;
+    mapped_size_ = 0;
+    heap_ = nullptr;
+}
+
+bool HeapSnapshot::capture(ThreadHeap& heap, bool blocking) {
+    release();
+
+    HeapLockGuard guard(heap.lock_, heap.stats_, LockSite::INSPECT, std::defer_lock);
+    if (blocking) {
+        guard.lock();
+    } else if (!guard.try_lock()) {
+        return false;
+    }
+
+    size_t count = 0;
+    for (const MappedSegment* seg = heap.active_segments_; seg != nullptr; seg = seg->list_node.next) {
+        count++;
+    }
+
+    // 快照本身不走分配器，避免在持有 heap 锁时重入
+    heap_ = &heap;
+    if (count == 0) {
+        return true;
+    }
+    const size_t size = (count * sizeof(SegmentSnapshot) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        heap_ = nullptr;
+        return false;
+    }
+    segments_ = static_cast<SegmentSnapshot*>(mem);
+    mapped_size_ = size;
+
+    for (const MappedSegment* seg = heap.active_segments_; seg != nullptr; seg = seg->list_node.next) {
+        fill(seg, segments_[num_segments_++]);
+    }
+    return true;
+}
+
+void HeapSnapshot::fill(const MappedSegment* segment, SegmentSnapshot& out) {
+    out.address = segment;
+    out.frontier = segment->next_free_page_idx_;
+
+    // 同一个 slab/span 的后续页都指向首页，沿用首页算出的格子
+    const void* run_owner = nullptr;
+    char run_cell = HEAT_FREE;
+
+    for (size_t i = 0; i < SEGMENT_NUM_PAGES; ++i) {
+        const PageDescriptor& desc = segment->page_descriptors_[i];
+        char cell;
+        if (i >= out.frontier) {
+            cell = HEAT_UNTOUCHED;
+        } else if (desc.status == PageStatus::METADATA) {
+            cell = HEAT_METADATA;
+        } else if (desc.status == PageStatus::FREE) {
+            cell = HEAT_FREE;
+        } else if (desc.slab_ptr == run_owner) {
+            cell = run_cell;
+        } else if (desc.status == PageStatus::SMALL_SLAB) {
+            const auto* header = static_cast<const SmallSlabHeader*>(desc.slab_ptr);
+            const auto& info = SlabConfig::get_instance().get_info(header->slab_class_id_);
+            SlabSnapshot& slab = out.slabs[out.num_slabs++];
+            slab.first_page = static_cast<uint16_t>(i);
+            slab.class_id = header->slab_class_id_;
+            slab.capacity = static_cast<uint16_t>(info.slab_capacity);
+            slab.used = static_cast<uint16_t>(info.slab_capacity - header->free_count_);
+            cell = utilization_cell(slab.used, slab.capacity);
+        } else {
+            // 缓存中的 span 只有首页标记为 CACHED_SLAB
+            const PageDescriptor* head = segment->get_page_desc(desc.slab_ptr);
+            cell = head->status == PageStatus::CACHED_SLAB ? HEAT_CACHED : HEAT_LARGE;
+        }
+        if (desc.slab_ptr != nullptr && cell != HEAT_FREE && cell != HEAT_UNTOUCHED && cell != HEAT_METADATA) {
+            run_owner = desc.slab_ptr;
+            run_cell = cell;
+        }
+
+        out.heat_map[i] = cell;
+        switch (cell) {
+            case HEAT_METADATA:  out.metadata_pages++; break;
+            case HEAT_FREE:      out.free_pages++; break;
+            case HEAT_UNTOUCHED: out.untouched_pages++; break;
+            case HEAT_LARGE:     out.large_pages++; break;
+            case HEAT_CACHED:    out.cached_pages++; break;
+            default:             out.small_pages++; break;
+        }
+    }
+
+    uint16_t run = 0;
+    for (size_t i = 0; i < SEGMENT_NUM_PAGES; ++i) {
+        const char cell = out.heat_map[i];
+        run = (cell == HEAT_FREE || cell == HEAT_UNTOUCHED) ? static_cast<uint16_t>(run + 1) : 0;
+        if (run > out.largest_free_span) {
+            out.largest_free_span = run;
+        }
+    }
+}
+
+void HeapSnapshot::write(int fd, StatsFormat format) const {
+    ReportWriter out(fd);
+
+    if (format == StatsFormat::JSON) {
+        out.str("{\"heap\": \"").hex(heap_).str("\", \"segments\": [");
+        for (size_t s = 0; s < num_segments_; ++s) {
+            const SegmentSnapshot& seg = segments_[s];
+            out.str(s == 0 ? "\n  " : ",\n  ")
+               .str("{\"address\": \"").hex(seg.address)
+               .str("\", \"frontier\": ").num(seg.frontier)
+               .str(", \"pages\": {\"metadata\": ").num(seg.metadata_pages)
+               .str(", \"small\": ").num(seg.small_pages)
+               .str(", \"large\": ").num(seg.large_pages)
+               .str(", \"cached\": ").num(seg.cached_pages)
+               .str(", \"free\": ").num(seg.free_pages)
+               .str(", \"untouched\": ").num(seg.untouched_pages)
+               .str("}, \"largest_free_span\": ").num(seg.largest_free_span)
+               .str(",\n   \"small_slabs\": [");
+            for (size_t i = 0; i < seg.num_slabs; ++i) {
+                const SlabSnapshot& slab = seg.slabs[i];
+                out.str(i == 0 ? "" : ", ")
+                   .str("{\"first_page\": ").num(slab.first_page)
+                   .str(", \"class\": ").num(slab.class_id)
+                   .str(", \"used\": ").num(slab.used)
+                   .str(", \"capacity\": ").num(slab.capacity)
+                   .str("}");
+            }
+            out.str("],\n   \"heat_map\": [");
+            for (size_t row = 0; row < SEGMENT_NUM_PAGES; row += HEAT_MAP_ROW) {
+                out.str(row == 0 ? "\"" : ", \"").bytes(seg.heat_map + row, HEAT_MAP_ROW).str("\"");
+            }
+            out.str("]}");
+        }
+        out.str(num_segments_ == 0 ? "]}\n" : "\n]}\n");
+        return;
+    }
+
+    out.str("heap ").hex(heap_).str(": ").num(num_segments_).str(" segments\n")
+       .str("legend: M metadata  _ free  . untouched  L large  C cached  0-9 small slab utilization (decile)  # full\n");
+    for (size_t s = 0; s < num_segments_; ++s) {
+        const SegmentSnapshot& seg = segments_[s];
+
+        uint64_t used = 0;
+        uint64_t capacity = 0;
+        for (size_t i = 0; i < seg.num_slabs; ++i) {
+            used += seg.slabs[i].used;
+            capacity += seg.slabs[i].capacity;
+        }
+
+        out.str("\nsegment ").hex(seg.address)
+           .str("  small ").num(seg.small_pages)
+           .str("  large ").num(seg.large_pages)
+           .str("  cached ").num(seg.cached_pages)
+           .str("  free ").num(seg.free_pages)
+           .str("  untouched ").num(seg.untouched_pages)
+           .str("  largest free span ").num(seg.largest_free_span)
+           .str("  slab utilization ").fixed(capacity == 0 ? 0 : used * 1000 / capacity, 1).str("%\n");
+        for (size_t row = 0; row < SEGMENT_NUM_PAGES; row += HEAT_MAP_ROW) {
+            out.str("  ").num(row, 3).str(" |").bytes(seg.heat_map + row, HEAT_MAP_ROW).str("|\n");
+        }
+    }
+}
+
+} // namespace my_malloc
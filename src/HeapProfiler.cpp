@@ -0,0 +1,357 @@
+#include <my_malloc/internal/HeapProfiler.hpp>
+#include <my_malloc/internal/ReportWriter.hpp>
+#include <my_malloc/sys/mman.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace my_malloc {
+
+namespace {
+
+// 与 gperftools 的帧指针回溯相同的合理性检查
+constexpr uintptr_t MAX_FRAME_SIZE = 100000;
+
+constexpr size_t MAX_BUCKETS = PROFILE_BUCKET_SLOTS * 3 / 4;
+constexpr size_t MAX_LIVE_SAMPLES = PROFILE_LIVE_SLOTS * 3 / 4;
+
+static_assert((PROFILE_BUCKET_SLOTS & (PROFILE_BUCKET_SLOTS - 1)) == 0, "Bucket slots must be a power of two");
+static_assert((PROFILE_LIVE_SLOTS & (PROFILE_LIVE_SLOTS - 1)) == 0, "Live slots must be a power of two");
+
+uint64_t hash_stack(void* const* stack, size_t depth) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < depth; ++i) {
+        hash = (hash ^ reinterpret_cast<uintptr_t>(stack[i])) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void* map_zeroed(size_t size) {
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+} // namespace
+
+HeapProfiler& HeapProfiler::get_instance() {
+    static HeapProfiler instance;
+    return instance;
+}
+
+size_t HeapProfiler::capture_stack(void** frames, size_t max_depth, size_t skip) {
+    // 每个栈帧：[fp] 是调用者的 fp，[fp + 1] 是返回地址
+    auto* fp = static_cast<void**>(__builtin_frame_address(0));
+    size_t depth = 0;
+    while (fp != nullptr && depth < max_depth) {
+        void* return_address = fp[1];
+        if (return_address == nullptr) {
+            break;
+        }
+        if (skip > 0) {
+            --skip;
+        } else {
+            frames[depth++] = return_address;
+        }
+
+        auto* next = static_cast<void**>(fp[0]);
+        const uintptr_t fp_addr = reinterpret_cast<uintptr_t>(fp);
+        const uintptr_t next_addr = reinterpret_cast<uintptr_t>(next);
+        if (next_addr <= fp_addr || next_addr - fp_addr > MAX_FRAME_SIZE || (next_addr & (sizeof(void*) - 1)) != 0) {
+            break;
+        }
+        fp = next;
+    }
+    return depth;
+}
+
+int64_t HeapProfiler::next_sample_distance(uint64_t* rng_state, size_t interval) {
+    uint64_t x = *rng_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *rng_state = x;
+
+    // 53 位随机数映射到 (0, 1]，-ln(u) 服从均值为 1 的指数分布
+    const double u = (static_cast<double>(x >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+    const double distance = -std::log(u) * static_cast<double>(interval);
+    if (distance >= static_cast<double>(INT64_MAX / 2)) {
+        return INT64_MAX / 2;
+    }
+    return static_cast<int64_t>(distance);
+}
+
+bool HeapProfiler::map_tables() {
+    if (live_ != nullptr) {
+        return true;
+    }
+    buckets_ = static_cast<ProfileBucket*>(map_zeroed(PROFILE_BUCKET_SLOTS * sizeof(ProfileBucket)));
+    live_ = static_cast<LiveSample*>(map_zeroed(PROFILE_LIVE_SLOTS * sizeof(LiveSample)));
+    if (buckets_ == nullptr || live_ == nullptr) {
+        if (buckets_ != nullptr) {
+            munmap(buckets_, PROFILE_BUCKET_SLOTS * sizeof(ProfileBucket));
+        }
+        if (live_ != nullptr) {
+            munmap(live_, PROFILE_LIVE_SLOTS * sizeof(LiveSample));
+        }
+        buckets_ = nullptr;
+        live_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+size_t HeapProfiler::find_or_add_bucket(void* const* stack, size_t depth) {
+    const uint64_t hash = hash_stack(stack, depth);
+    size_t slot = static_cast<size_t>(hash) & (PROFILE_BUCKET_SLOTS - 1);
+
+    while (buckets_[slot].used) {
+        const ProfileBucket& bucket = buckets_[slot];
+        if (bucket.hash == hash && bucket.depth == depth
+            && memcmp(bucket.stack, stack, depth * sizeof(void*)) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & (PROFILE_BUCKET_SLOTS - 1);
+    }
+
+    if (num_buckets_ >= MAX_BUCKETS) {
+        return SIZE_MAX;
+    }
+    ProfileBucket& bucket = buckets_[slot];
+    bucket.hash = hash;
+    bucket.depth = static_cast<uint32_t>(depth);
+    bucket.used = true;
+    memcpy(bucket.stack, stack, depth * sizeof(void*));
+    num_buckets_++;
+    return slot;
+}
+
+size_t HeapProfiler::live_slot_of(const void* ptr) {
+    // 对象至少 8 字节对齐，低位没有信息
+    const uint64_t key = reinterpret_cast<uintptr_t>(ptr) >> 3;
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (PROFILE_LIVE_SLOTS - 1);
+}
+
+size_t HeapProfiler::find_live(const void* ptr) const {
+    size_t slot = live_slot_of(ptr);
+    while (live_[slot].ptr != nullptr) {
+        if (live_[slot].ptr == ptr) {
+            return slot;
+        }
+        slot = (slot + 1) & (PROFILE_LIVE_SLOTS - 1);
+    }
+    return SIZE_MAX;
+}
+
+void HeapProfiler::erase_live(size_t slot) {
+    // 线性探测的反向移位删除：把后面探测链上的元素前移填洞，不留墓碑
+    size_t hole = slot;
+    size_t next = (hole + 1) & (PROFILE_LIVE_SLOTS - 1);
+    while (live_[next].ptr != nullptr) {
+        const size_t home = live_slot_of(live_[next].ptr);
+        // home 不在 (hole, next] 内时，这个元素可以移到 hole
+        const bool movable = hole <= next ? (home <= hole || home > next)
+                                          : (home <= hole && home > next);
+        if (movable) {
+            live_[hole] = live_[next];
+            hole = next;
+        }
+        next = (next + 1) & (PROFILE_LIVE_SLOTS - 1);
+    }
+    live_[hole] = LiveSample{};
+    num_live_--;
+}
+
+bool HeapProfiler::record_allocation(const void* ptr, size_t size, const ThreadHeap* heap,
+                                     void* const* stack, size_t depth, size_t interval, PageDescriptor* desc) {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    if (!map_tables() || num_live_ >= MAX_LIVE_SAMPLES) {
+        dropped_samples_++;
+        return false;
+    }
+    const size_t bucket_idx = find_or_add_bucket(stack, depth);
+    if (bucket_idx == SIZE_MAX) {
+        dropped_samples_++;
+        return false;
+    }
+
+    ProfileBucket& bucket = buckets_[bucket_idx];
+    bucket.inuse_objects++;
+    bucket.inuse_bytes += size;
+    bucket.alloc_objects++;
+    bucket.alloc_bytes += size;
+
+    size_t slot = live_slot_of(ptr);
+    while (live_[slot].ptr != nullptr) {
+        slot = (slot + 1) & (PROFILE_LIVE_SLOTS - 1);
+    }
+    live_[slot] = LiveSample{ptr, heap, size, bucket_idx};
+    num_live_++;
+    last_interval_ = interval;
+
+    if (desc->sampled != UINT8_MAX) {
+        desc->sampled++;
+    }
+    return true;
+}
+
+bool HeapProfiler::record_free(const void* ptr, PageDescriptor* desc) {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    if (live_ == nullptr) {
+        return false;
+    }
+    const size_t slot = find_live(ptr);
+    if (slot == SIZE_MAX) {
+        return false;
+    }
+
+    ProfileBucket& bucket = buckets_[live_[slot].bucket];
+    bucket.inuse_objects--;
+    bucket.inuse_bytes -= live_[slot].size;
+    erase_live(slot);
+
+    // 饱和后不再递减：该页之后的释放都会多查一次表，但不会漏掉样本
+    if (desc->sampled != UINT8_MAX && desc->sampled != 0) {
+        desc->sampled--;
+    }
+    return true;
+}
+
+void HeapProfiler::record_move(const void* old_ptr, const void* new_ptr, size_t new_size) {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    if (live_ == nullptr) {
+        return;
+    }
+    const size_t slot = find_live(old_ptr);
+    if (slot == SIZE_MAX) {
+        return;
+    }
+
+    LiveSample sample = live_[slot];
+    erase_live(slot);
+
+    ProfileBucket& bucket = buckets_[sample.bucket];
+    bucket.inuse_bytes = bucket.inuse_bytes - sample.size + new_size;
+    sample.ptr = new_ptr;
+    sample.size = new_size;
+
+    size_t new_slot = live_slot_of(new_ptr);
+    while (live_[new_slot].ptr != nullptr) {
+        new_slot = (new_slot + 1) & (PROFILE_LIVE_SLOTS - 1);
+    }
+    live_[new_slot] = sample;
+    num_live_++;
+}
+
+void HeapProfiler::retire_heap(const ThreadHeap* heap) {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    if (live_ == nullptr) {
+        return;
+    }
+    // 删除会把后面的元素移到当前位置，所以删除后不前进
+    size_t slot = 0;
+    while (slot < PROFILE_LIVE_SLOTS) {
+        if (live_[slot].ptr != nullptr && live_[slot].heap == heap) {
+            ProfileBucket& bucket = buckets_[live_[slot].bucket];
+            bucket.inuse_objects--;
+            bucket.inuse_bytes -= live_[slot].size;
+            erase_live(slot);
+        } else {
+            ++slot;
+        }
+    }
+}
+
+void HeapProfiler::reset_cumulative() {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    if (buckets_ == nullptr) {
+        return;
+    }
+    // 桶还被存活样本引用，只清零累计值
+    for (size_t i = 0; i < PROFILE_BUCKET_SLOTS; ++i) {
+        buckets_[i].alloc_objects = 0;
+        buckets_[i].alloc_bytes = 0;
+    }
+}
+
+size_t HeapProfiler::get_live_samples() {
+    std::lock_guard<std::mutex> guard(lock_);
+    return num_live_;
+}
+
+uint64_t HeapProfiler::get_dropped_samples() {
+    std::lock_guard<std::mutex> guard(lock_);
+    return dropped_samples_;
+}
+
+bool HeapProfiler::write_profile(int fd) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        ReportWriter out(fd);
+
+        uint64_t inuse_objects = 0;
+        uint64_t inuse_bytes = 0;
+        uint64_t alloc_objects = 0;
+        uint64_t alloc_bytes = 0;
+        const size_t num_slots = buckets_ != nullptr ? PROFILE_BUCKET_SLOTS : 0;
+        for (size_t i = 0; i < num_slots; ++i) {
+            inuse_objects += buckets_[i].inuse_objects;
+            inuse_bytes += buckets_[i].inuse_bytes;
+            alloc_objects += buckets_[i].alloc_objects;
+            alloc_bytes += buckets_[i].alloc_bytes;
+        }
+
+        // pprof 按 heap_v2 后面的采样间隔对每行做反采样
+        out.str("heap profile: ").num(inuse_objects).str(": ").num(inuse_bytes)
+           .str(" [").num(alloc_objects).str(": ").num(alloc_bytes)
+           .str("] @ heap_v2/").num(last_interval_).str("\n");
+
+        for (size_t i = 0; i < num_slots; ++i) {
+            const ProfileBucket& bucket = buckets_[i];
+            if (bucket.alloc_objects == 0 && bucket.inuse_objects == 0) {
+                continue;
+            }
+            out.num(bucket.inuse_objects).str(": ").num(bucket.inuse_bytes)
+               .str(" [").num(bucket.alloc_objects).str(": ").num(bucket.alloc_bytes).str("] @");
+            for (uint32_t d = 0; d < bucket.depth; ++d) {
+                out.str(" ").hex(bucket.stack[d]);
+            }
+            out.str("\n");
+        }
+        out.str("\nMAPPED_LIBRARIES:\n");
+    }
+
+    // 附上 /proc/self/maps，pprof 据此把地址对应到二进制和共享库
+    const int maps_fd = ::open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (maps_fd < 0) {
+        return false;
+    }
+    char buf[4096];
+    bool ok = true;
+    ssize_t n;
+    while ((n = ::read(maps_fd, buf, sizeof(buf))) > 0) {
+        ReportWriter(fd).bytes(buf, static_cast<size_t>(n));
+    }
+    if (n < 0) {
+        ok = false;
+    }
+    ::close(maps_fd);
+    return ok;
+}
+
+bool HeapProfiler::write_profile(const char* path) {
+    const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = write_profile(fd);
+    return ::close(fd) == 0 && ok;
+}
+
+} // namespace my_malloc
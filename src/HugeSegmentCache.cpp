@@ -0,0 +1,256 @@
+#include <my_malloc/internal/HugeSegmentCache.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/sys/mman.hpp>
+
+#include <cassert>
+#include <chrono>
+
+namespace my_malloc {
+
+// 缓存中保留的总字节数 (含已 purge 的映射) 不超过预算的这个倍数
+constexpr size_t HUGE_CACHE_RETAIN_FACTOR = 4;
+
+namespace {
+
+size_t floor_log2(size_t value) {
+    return 63 - static_cast<size_t>(__builtin_clzll(value));
+}
+
+} // namespace
+
+size_t HugeSegmentCache::round_to_bucket_size(size_t mapping_size) {
+    const size_t min_size = static_cast<size_t>(1) << HUGE_CACHE_MIN_SHIFT;
+    const size_t max_size = static_cast<size_t>(1) << HUGE_CACHE_MAX_SHIFT;
+
+    if (mapping_size <= min_size) {
+        return min_size;
+    }
+    if (mapping_size > max_size) {
+        // 超过 1GB 的映射不做取整，也不进入缓存
+        return mapping_size;
+    }
+
+    const size_t step = static_cast<size_t>(1) << (floor_log2(mapping_size) - 2);
+    return (mapping_size + step - 1) & ~(step - 1);
+}
+
+size_t HugeSegmentCache::get_bucket_index(size_t mapping_size) {
+    if (mapping_size == 0) {
+        return static_cast<size_t>(-1);
+    }
+
+    const size_t shift = floor_log2(mapping_size);
+    if (shift < HUGE_CACHE_MIN_SHIFT || shift > HUGE_CACHE_MAX_SHIFT) {
+        return static_cast<size_t>(-1);
+    }
+    if (mapping_size > (static_cast<size_t>(1) << HUGE_CACHE_MAX_SHIFT)) {
+        return static_cast<size_t>(-1);
+    }
+
+    const size_t step_shift = shift - 2;
+    if ((mapping_size & ((static_cast<size_t>(1) << step_shift) - 1)) != 0) {
+        return static_cast<size_t>(-1);
+    }
+
+    return (shift - HUGE_CACHE_MIN_SHIFT) * HUGE_CACHE_STEPS_PER_SHIFT
+         + (mapping_size >> step_shift) - HUGE_CACHE_STEPS_PER_SHIFT;
+}
+
+uint64_t HugeSegmentCache::now_ms() {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+MappedSegment* HugeSegmentCache::take(size_t mapping_size, bool aligned_layout, uint64_t now) {
+    const size_t bucket = get_bucket_index(mapping_size);
+    if (bucket >= HUGE_CACHE_NUM_BUCKETS) {
+        return nullptr;
+    }
+
+    // 从链表头部找，即最近放入、最可能仍驻留在内存中的映射；布局必须一致
+    MappedSegment* segment = buckets_[bucket];
+    while (segment != nullptr && segment->is_aligned_huge() != aligned_layout) {
+        segment = segment->list_node.next;
+    }
+    if (segment != nullptr) {
+        unlink(segment, bucket);
+        segment->last_used_ms_ = now;
+    }
+
+    decay(now);
+    return segment;
+}
+
+bool HugeSegmentCache::put(MappedSegment* segment, uint64_t now) {
+    const auto& options = AllocatorOptions::get_instance();
+    const size_t budget = options.huge_cache_budget.load(std::memory_order_relaxed);
+    const size_t size = segment->total_size_;
+
+    const size_t bucket = get_bucket_index(size);
+    if (bucket >= HUGE_CACHE_NUM_BUCKETS || size > budget) {
+        return false;
+    }
+
+    if (bucket_counts_[bucket] >= HUGE_CACHE_MAX_PER_BUCKET) {
+        MappedSegment* oldest = buckets_[bucket];
+        while (oldest->list_node.next != nullptr) {
+            oldest = oldest->list_node.next;
+        }
+        release(oldest, bucket);
+    }
+
+    // 缓存中的映射不再是 HUGE_SLAB，对它的重复释放会被当作无效指针忽略
+    segment->page_descriptors_[0].status = PageStatus::METADATA;
+    segment->flags_ &= static_cast<uint8_t>(~MappedSegment::FLAG_PURGED);
+    segment->last_used_ms_ = now;
+
+    segment->list_node.prev = nullptr;
+    segment->list_node.next = buckets_[bucket];
+    if (buckets_[bucket] != nullptr) {
+        buckets_[bucket]->list_node.prev = segment;
+    }
+    buckets_[bucket] = segment;
+
+    bucket_counts_[bucket]++;
+    cached_bytes_ += size;
+    dirty_bytes_ += size;
+
+    // 内存压力：脏字节超过预算时，用 MADV_FREE 归还最久未用的映射的物理页
+    while (dirty_bytes_ > budget) {
+        size_t victim_bucket = 0;
+        MappedSegment* victim = find_oldest_dirty(&victim_bucket);
+        assert(victim != nullptr);
+        reclaim(victim, victim_bucket);
+    }
+
+    // 保留的虚拟映射同样有上限，超出时才真正 munmap
+    while (cached_bytes_ > budget * HUGE_CACHE_RETAIN_FACTOR) {
+        size_t victim_bucket = 0;
+        MappedSegment* victim = nullptr;
+        for (size_t i = 0; i < HUGE_CACHE_NUM_BUCKETS; ++i) {
+            for (MappedSegment* cur = buckets_[i]; cur != nullptr; cur = cur->list_node.next) {
+                if (victim == nullptr || cur->last_used_ms_ <= victim->last_used_ms_) {
+                    victim = cur;
+                    victim_bucket = i;
+                }
+            }
+        }
+        release(victim, victim_bucket);
+    }
+
+    decay(now);
+    return true;
+}
+
+void HugeSegmentCache::decay(uint64_t now) {
+    if (dirty_bytes_ == 0) {
+        return;
+    }
+
+    const uint64_t decay_ms = AllocatorOptions::get_instance().huge_cache_decay_ms.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < HUGE_CACHE_NUM_BUCKETS; ++i) {
+        MappedSegment* cur = buckets_[i];
+        while (cur != nullptr) {
+            MappedSegment* next = cur->list_node.next;
+            const uint64_t idle = now > cur->last_used_ms_ ? now - cur->last_used_ms_ : 0;
+            if (!(cur->flags_ & MappedSegment::FLAG_PURGED) && idle >= decay_ms) {
+                reclaim(cur, i);
+            }
+            cur = next;
+        }
+    }
+}
+
+void HugeSegmentCache::purge_all() {
+    for (size_t i = 0; i < HUGE_CACHE_NUM_BUCKETS; ++i) {
+        MappedSegment* cur = buckets_[i];
+        while (cur != nullptr) {
+            MappedSegment* next = cur->list_node.next;
+            if (!(cur->flags_ & MappedSegment::FLAG_PURGED)) {
+                reclaim(cur, i);
+            }
+            cur = next;
+        }
+    }
+}
+
+void HugeSegmentCache::release_all() {
+    for (size_t i = 0; i < HUGE_CACHE_NUM_BUCKETS; ++i) {
+        while (buckets_[i] != nullptr) {
+            release(buckets_[i], i);
+        }
+    }
+    assert(cached_bytes_ == 0 && dirty_bytes_ == 0);
+}
+
+void HugeSegmentCache::unlink(MappedSegment* segment, size_t bucket) {
+    MappedSegment* prev_node = segment->list_node.prev;
+    MappedSegment* next_node = segment->list_node.next;
+
+    if (prev_node != nullptr) {
+        prev_node->list_node.next = next_node;
+    } else {
+        assert(buckets_[bucket] == segment);
+        buckets_[bucket] = next_node;
+    }
+    if (next_node != nullptr) {
+        next_node->list_node.prev = prev_node;
+    }
+
+    segment->list_node.next = nullptr;
+    segment->list_node.prev = nullptr;
+
+    bucket_counts_[bucket]--;
+    cached_bytes_ -= segment->total_size_;
+    if (!(segment->flags_ & MappedSegment::FLAG_PURGED)) {
+        dirty_bytes_ -= segment->total_size_;
+    }
+}
+
+void HugeSegmentCache::purge(MappedSegment* segment) {
+    // 元数据页必须保留，只归还用户数据部分的物理页
+    char* data_start = reinterpret_cast<char*>(segment) + SEGMENT_METADATA_SIZE;
+    const size_t data_size = segment->total_size_ - segment->mapping_offset_ - SEGMENT_METADATA_SIZE;
+
+    if (madvise(data_start, data_size, MADV_FREE) != 0) {
+        // 旧内核 (< 4.5) 不支持 MADV_FREE
+        madvise(data_start, data_size, MADV_DONTNEED);
+    }
+
+    segment->flags_ |= MappedSegment::FLAG_PURGED;
+    dirty_bytes_ -= segment->total_size_;
+}
+
+void HugeSegmentCache::reclaim(MappedSegment* segment, size_t bucket) {
+    // hugetlb 页不支持 MADV_FREE，只有 munmap 才能把它们还给大页池
+    if (segment->is_hugetlb()) {
+        release(segment, bucket);
+    } else {
+        purge(segment);
+    }
+}
+
+void HugeSegmentCache::release(MappedSegment* segment, size_t bucket) {
+    unlink(segment, bucket);
+    MappedSegment::destroy(segment);
+}
+
+MappedSegment* HugeSegmentCache::find_oldest_dirty(size_t* bucket_out) const {
+    MappedSegment* oldest = nullptr;
+    for (size_t i = 0; i < HUGE_CACHE_NUM_BUCKETS; ++i) {
+        for (MappedSegment* cur = buckets_[i]; cur != nullptr; cur = cur->list_node.next) {
+            if (cur->flags_ & MappedSegment::FLAG_PURGED) {
+                continue;
+            }
+            if (oldest == nullptr || cur->last_used_ms_ <= oldest->last_used_ms_) {
+                oldest = cur;
+                *bucket_out = i;
+            }
+        }
+    }
+    return oldest;
+}
+
+} // namespace my_malloc
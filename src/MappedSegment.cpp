@@ -1,13 +1,17 @@
 #include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/sys/sdt.hpp>
 
 #include <new>
 #include <cassert>
+#include <cstring>
 
 namespace my_malloc {
 
 constexpr size_t MMAP_BUFFER_SIZE = SEGMENT_SIZE + (SEGMENT_SIZE - PAGE_SIZE);
 
 
+// 只写元数据页的描述符；其余描述符来自全零的新映射，即 FREE 且 slab_ptr 为空
 MappedSegment::MappedSegment() : owner_heap_(nullptr) {
     const size_t metadata_size = sizeof(MappedSegment);
     const size_t num_metadata_pages = (metadata_size + PAGE_SIZE - 1) / PAGE_SIZE;
@@ -19,48 +23,195 @@ MappedSegment::MappedSegment() : owner_heap_(nullptr) {
         page_descriptors_[i].status = PageStatus::METADATA;
         page_descriptors_[i].slab_ptr = this;
     }
+
+    next_free_page_idx_ = static_cast<uint16_t>(num_metadata_pages);
 }
 
 
 MappedSegment::~MappedSegment() {
 }
 
-MappedSegment* MappedSegment::create(size_t segment_size /* = SEGMENT_SIZE */) {
+void MappedSegment::clear_page_descriptors() {
+    const size_t num_pages = SEGMENT_SIZE / PAGE_SIZE - next_free_page_idx_;
+    std::memset(static_cast<void*>(&page_descriptors_[next_free_page_idx_]), 0, num_pages * sizeof(PageDescriptor));
+}
+
+void* MappedSegment::map_aligned(size_t segment_size, size_t align_offset /* = 0 */) {
     const size_t mmap_buffer_size = segment_size + (SEGMENT_SIZE - PAGE_SIZE);
 
+    SegmentCounters& counters = get_counters();
+    counters.mmap_calls.fetch_add(1, std::memory_order_relaxed);
     void* base_ptr = mmap(nullptr, mmap_buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
     if (base_ptr == MAP_FAILED) {
         return nullptr;
     }
 
+    // 返回的地址加上 align_offset 后落在 SEGMENT_SIZE 边界上
     uintptr_t base_addr_val = reinterpret_cast<uintptr_t>(base_ptr);
-    uintptr_t aligned_addr_val = (base_addr_val + SEGMENT_SIZE - 1) & ~(SEGMENT_SIZE - 1);
+    uintptr_t aligned_addr_val = ((base_addr_val + align_offset + SEGMENT_SIZE - 1) & ~(SEGMENT_SIZE - 1)) - align_offset;
     void* aligned_ptr = reinterpret_cast<void*>(aligned_addr_val);
 
     size_t head_trim_size = aligned_addr_val - base_addr_val;
     if (head_trim_size > 0) {
+        counters.munmap_calls.fetch_add(1, std::memory_order_relaxed);
         munmap(base_ptr, head_trim_size);
     }
     
     size_t tail_trim_size = (base_addr_val + mmap_buffer_size) - (aligned_addr_val + segment_size);
     if (tail_trim_size > 0) {
         void* tail_start = reinterpret_cast<void*>(aligned_addr_val + segment_size);
+        counters.munmap_calls.fetch_add(1, std::memory_order_relaxed);
         munmap(tail_start, tail_trim_size);
     }
 
-    MappedSegment* segment = new (aligned_ptr) MappedSegment();
+    return aligned_ptr;
+}
+
+size_t MappedSegment::get_hugetlb_page_size() {
+    const size_t page_size = AllocatorOptions::get_instance().hugetlb_page_size.load(std::memory_order_relaxed);
+    if (page_size < SEGMENT_SIZE || (page_size & (page_size - 1)) != 0) {
+        return 0;
+    }
+    return page_size;
+}
+
+void* MappedSegment::map_hugetlb(size_t segment_size, size_t* mapped_size) {
+    const size_t page_size = get_hugetlb_page_size();
+    if (page_size == 0) {
+        return nullptr;
+    }
+
+    const int page_shift = __builtin_ctzll(page_size);
+    const size_t length = (segment_size + page_size - 1) & ~(page_size - 1);
+
+    // hugetlb 池在 mmap 时就完成预留，池耗尽会在这里直接失败，而不是在缺页时 SIGBUS
+    get_counters().mmap_calls.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (page_shift << MAP_HUGE_SHIFT), -1, 0);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+
+    // 大页映射天然按页大小对齐，而页大小不小于 SEGMENT_SIZE
+    assert((reinterpret_cast<uintptr_t>(ptr) & (SEGMENT_SIZE - 1)) == 0);
+
+    *mapped_size = length;
+    return ptr;
+}
+
+MappedSegment* MappedSegment::create(size_t segment_size /* = SEGMENT_SIZE */, bool try_hugetlb /* = false */) {
+    return create_mapping(segment_size, 0, try_hugetlb);
+}
+
+MappedSegment* MappedSegment::create_huge(size_t mapping_size, bool aligned_layout, bool try_hugetlb) {
+    MappedSegment* segment = create_mapping(mapping_size, aligned_layout ? SEGMENT_METADATA_SIZE : 0, try_hugetlb);
+    if (segment != nullptr && aligned_layout) {
+        segment->flags_ |= FLAG_ALIGNED_HUGE;
+    }
+    return segment;
+}
+
+MappedSegment* MappedSegment::create_mapping(size_t mapping_size, size_t align_offset, bool try_hugetlb) {
+    size_t mapped_size = mapping_size;
+    size_t mapping_offset = 0;
+    void* base_ptr = nullptr;
+
+    if (try_hugetlb) {
+        base_ptr = map_hugetlb(mapping_size, &mapped_size);
+        if (base_ptr != nullptr) {
+            get_counters().hugetlb_hits.fetch_add(1, std::memory_order_relaxed);
+            // 大页映射的起点无法挪动，只能把头部放到第一个 SEGMENT_SIZE 区间的末尾
+            mapping_offset = align_offset == 0 ? 0 : SEGMENT_SIZE - align_offset;
+        } else {
+            get_counters().hugetlb_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    const bool hugetlb_backed = base_ptr != nullptr;
+
+    if (base_ptr == nullptr) {
+        base_ptr = map_aligned(mapping_size, align_offset);
+        mapped_size = mapping_size;
+    }
+    if (base_ptr == nullptr) {
+        return nullptr;
+    }
 
-    segment->total_size_ = segment_size;
+    MappedSegment* segment = new (static_cast<char*>(base_ptr) + mapping_offset) MappedSegment();
 
+    segment->total_size_ = mapped_size;
+    segment->mapping_offset_ = mapping_offset;
+    if (hugetlb_backed) {
+        segment->flags_ |= FLAG_HUGETLB;
+    }
+
+    MY_SDT_PROBE3(my_malloc, segment_create, segment, mapped_size, hugetlb_backed);
     return segment;
 }
 
 
+MappedSegment* MappedSegment::remap(MappedSegment* segment, size_t new_size) {
+    const size_t old_size = segment->total_size_;
+    if (new_size == old_size) {
+        return segment;
+    }
+
+    // hugetlb 映射的长度必须是大页的整数倍；区域中的 Segment 不能被搬出区域。
+    // 两者都交给调用者走拷贝路径
+    if (segment->is_hugetlb() || segment->is_region_backed()) {
+        return nullptr;
+    }
+
+    // 1. 先尝试原地缩小或扩展，地址不变
+    SegmentCounters& counters = get_counters();
+    counters.mremap_calls.fetch_add(1, std::memory_order_relaxed);
+    void* ret = mremap(segment, old_size, new_size, 0, nullptr);
+    if (ret != MAP_FAILED) {
+        segment->total_size_ = new_size;
+        return segment;
+    }
+
+    // 2. 原地扩展失败：预留一块按 SEGMENT_SIZE 对齐的新区间，再用 MREMAP_FIXED
+    //    把页表项整体搬过去，数据不发生拷贝。目标区间上的旧映射会被内核原子地替换。
+    const size_t align_offset = (segment->flags_ & FLAG_ALIGNED_HUGE) ? SEGMENT_METADATA_SIZE : 0;
+    void* target = map_aligned(new_size, align_offset);
+    if (target == nullptr) {
+        return nullptr;
+    }
+
+    counters.mremap_calls.fetch_add(1, std::memory_order_relaxed);
+    ret = mremap(segment, old_size, new_size, MREMAP_MAYMOVE | MREMAP_FIXED, target);
+    if (ret == MAP_FAILED) {
+        counters.munmap_calls.fetch_add(1, std::memory_order_relaxed);
+        munmap(target, new_size);
+        return nullptr;
+    }
+
+    MappedSegment* moved = static_cast<MappedSegment*>(ret);
+    moved->total_size_ = new_size;
+
+    // 元数据页的 slab_ptr 记录的是旧地址
+    const size_t num_metadata_pages = (sizeof(MappedSegment) + PAGE_SIZE - 1) / PAGE_SIZE;
+    for (size_t i = 0; i < num_metadata_pages; ++i) {
+        moved->page_descriptors_[i].slab_ptr = moved;
+    }
+
+    return moved;
+}
+
+
+SegmentCounters& MappedSegment::get_counters() {
+    static SegmentCounters counters;
+    return counters;
+}
+
 void MappedSegment::destroy(MappedSegment* segment) {
     if (segment) {
         size_t total_size = segment->total_size_;
+        char* mapping_base = reinterpret_cast<char*>(segment) - segment->mapping_offset_;
+        MY_SDT_PROBE2(my_malloc, segment_destroy, segment, total_size);
         segment->~MappedSegment();
-        ::munmap(segment, total_size);
+        get_counters().munmap_calls.fetch_add(1, std::memory_order_relaxed);
+        ::munmap(mapping_base, total_size);
     }
 }
 
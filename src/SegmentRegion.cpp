@@ -0,0 +1,142 @@
+#include <my_malloc/internal/SegmentRegion.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/sys/mman.hpp>
+
+#include <cassert>
+#include <new>
+
+namespace my_malloc {
+
+constexpr size_t SEGMENT_REGION_SIZE = SEGMENT_REGION_NUM_SEGMENTS * SEGMENT_SIZE;
+
+uint64_t SegmentRegion::run_mask(size_t first, size_t num_segments) {
+    const uint64_t bits = num_segments >= 64 ? ~static_cast<uint64_t>(0)
+                                             : (static_cast<uint64_t>(1) << num_segments) - 1;
+    return bits << first;
+}
+
+bool SegmentRegion::reserve() {
+    if (base_ != nullptr) {
+        return true;
+    }
+    if (reserve_failed_) {
+        return false;
+    }
+
+    // 只预留地址空间：未触碰的页不占物理内存
+    void* base = MappedSegment::map_aligned(SEGMENT_REGION_SIZE);
+    if (base == nullptr) {
+        reserve_failed_ = true;
+        return false;
+    }
+
+    base_ = static_cast<char*>(base);
+    free_mask_ = run_mask(0, SEGMENT_REGION_NUM_SEGMENTS);
+    dirty_mask_ = 0;
+    used_mask_ = 0;
+    return true;
+}
+
+size_t SegmentRegion::find_free_run(size_t num_segments) const {
+    // 第 i 位保留下来，当且仅当从 i 开始的 num_segments 个 Segment 都空闲
+    uint64_t candidates = free_mask_;
+    for (size_t k = 1; k < num_segments && candidates != 0; ++k) {
+        candidates &= free_mask_ >> k;
+    }
+    if (candidates == 0) {
+        return SIZE_MAX;
+    }
+    return static_cast<size_t>(__builtin_ctzll(candidates));
+}
+
+MappedSegment* SegmentRegion::take(size_t num_segments) {
+    if (num_segments == 0 || num_segments > SEGMENT_REGION_NUM_SEGMENTS || !reserve()) {
+        return nullptr;
+    }
+
+    const size_t first = find_free_run(num_segments);
+    if (first == SIZE_MAX) {
+        return nullptr;
+    }
+
+    const uint64_t mask = run_mask(first, num_segments);
+    free_mask_ &= ~mask;
+    dirty_mask_ |= mask;
+
+    // 用过的 Segment 即使已经 MADV_FREE，内容也可能还在，头部位置上是旧的描述符或用户数据
+    const bool reused = (used_mask_ & run_mask(first, 1)) != 0;
+    used_mask_ |= mask;
+
+    MappedSegment* segment = new (base_ + first * SEGMENT_SIZE) MappedSegment();
+    if (reused) {
+        segment->clear_page_descriptors();
+    }
+    segment->total_size_ = num_segments * SEGMENT_SIZE;
+    segment->flags_ |= MappedSegment::FLAG_REGION;
+    return segment;
+}
+
+void SegmentRegion::put(MappedSegment* segment) {
+    assert(contains(segment) && segment->is_region_backed());
+
+    const size_t first = static_cast<size_t>(reinterpret_cast<char*>(segment) - base_) / SEGMENT_SIZE;
+    const size_t num_segments = segment->total_size_ / SEGMENT_SIZE;
+
+    // 释放后对同一指针的重复 free 会被当作无效指针忽略
+    segment->page_descriptors_[0].status = PageStatus::METADATA;
+    segment->~MappedSegment();
+
+    free_mask_ |= run_mask(first, num_segments);
+
+    // 空闲 Segment 中的脏页与 Huge 缓存共用同一预算
+    const size_t budget = AllocatorOptions::get_instance().huge_cache_budget.load(std::memory_order_relaxed);
+    if (get_dirty_free_bytes() > budget) {
+        purge_run(first, num_segments);
+    }
+}
+
+void SegmentRegion::purge_run(size_t first, size_t num_segments) {
+    char* start = base_ + first * SEGMENT_SIZE;
+    const size_t length = num_segments * SEGMENT_SIZE;
+
+    if (madvise(start, length, MADV_FREE) != 0) {
+        madvise(start, length, MADV_DONTNEED);
+    }
+    dirty_mask_ &= ~run_mask(first, num_segments);
+}
+
+bool SegmentRegion::contains(const void* ptr) const {
+    const char* p = static_cast<const char*>(ptr);
+    return base_ != nullptr && p >= base_ && p < base_ + SEGMENT_REGION_SIZE;
+}
+
+void SegmentRegion::release_all() {
+    if (base_ != nullptr) {
+        MappedSegment::get_counters().munmap_calls.fetch_add(1, std::memory_order_relaxed);
+        munmap(base_, SEGMENT_REGION_SIZE);
+    }
+    base_ = nullptr;
+    free_mask_ = 0;
+    dirty_mask_ = 0;
+    used_mask_ = 0;
+}
+
+void SegmentRegion::purge_free() {
+    const uint64_t dirty_free = free_mask_ & dirty_mask_;
+    for (size_t i = 0; i < SEGMENT_REGION_NUM_SEGMENTS; ++i) {
+        if (dirty_free & run_mask(i, 1)) {
+            purge_run(i, 1);
+        }
+    }
+}
+
+size_t SegmentRegion::get_free_segments() const {
+    return static_cast<size_t>(__builtin_popcountll(free_mask_));
+}
+
+size_t SegmentRegion::get_dirty_free_bytes() const {
+    return static_cast<size_t>(__builtin_popcountll(free_mask_ & dirty_mask_)) * SEGMENT_SIZE;
+}
+
+} // namespace my_malloc
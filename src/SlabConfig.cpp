@@ -1,5 +1,6 @@
 #include <my_malloc/internal/SlabConfig.hpp>
 #include <my_malloc/internal/AllocSlab.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
 #include <cassert>
 #include <algorithm> // for std::min/max
 #include <stddef.h> // For offsetof
@@ -27,10 +28,23 @@ const SlabConfigInfo& SlabConfig::get_info(size_t index) const {
     return slab_class_infos_[index];
 }
 
-SlabConfig::SlabConfig() : num_classes_(0) {
+size_t SlabConfig::get_medium_class_index(size_t num_pages) const {
+    if (num_pages > SEGMENT_USABLE_PAGES) {
+        return static_cast<size_t>(-1);
+    }
+    return pages_to_medium_class_map_[num_pages];
+}
+
+uint16_t SlabConfig::get_medium_class_pages(size_t index) const {
+    assert(index < num_medium_classes_ && "Medium class index out of bounds.");
+    return medium_class_pages_[index];
+}
+
+SlabConfig::SlabConfig() : num_classes_(0), num_medium_classes_(0) {
     initialize_size_classes();
     calculate_derived_parameters();
     build_lookup_table();
+    initialize_medium_classes();
 }
 
 
@@ -136,4 +150,35 @@ void SlabConfig::build_lookup_table() {
     size_to_class_map_[0] = 0;
 }
 
+
+void SlabConfig::initialize_medium_classes() {
+    // 每个 2 的幂区间四等分：80, 96, 112, 128, 160, ... 页，最后一档截断到 Segment 的可用页数
+    const size_t min_pages = MAX_SMALL_OBJECT_SIZE / PAGE_SIZE;
+    for (size_t base = min_pages; num_medium_classes_ < MAX_NUM_MEDIUM_CLASSES; base *= 2) {
+        bool reached_end = false;
+        for (size_t step = 1; step <= 4; ++step) {
+            size_t pages = base + base / 4 * step;
+            if (pages >= SEGMENT_USABLE_PAGES) {
+                pages = SEGMENT_USABLE_PAGES;
+                reached_end = true;
+            }
+            medium_class_pages_[num_medium_classes_++] = static_cast<uint16_t>(pages);
+            if (reached_end) {
+                break;
+            }
+        }
+        if (reached_end) {
+            break;
+        }
+    }
+
+    size_t current_class = 0;
+    for (size_t pages = 0; pages <= SEGMENT_USABLE_PAGES; ++pages) {
+        if (pages > medium_class_pages_[current_class]) {
+            current_class++;
+        }
+        pages_to_medium_class_map_[pages] = static_cast<uint8_t>(current_class);
+    }
+}
+
 } // namespace my_malloc
\ No newline at end of file
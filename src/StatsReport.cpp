@@ -0,0 +1,396 @@
+#include <my_malloc/internal/StatsReport.hpp>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/HeapLock.hpp>
+#include <my_malloc/internal/HeapStats.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/ReportWriter.hpp>
+#include <my_malloc/internal/SlabConfig.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <mutex>
+
+namespace my_malloc {
+
+namespace {
+
+uint64_t scaled_ratio(uint64_t numerator, uint64_t denominator, uint64_t scale) {
+    return denominator == 0 ? 0 : numerator * scale / denominator;
+}
+
+uint64_t wasted_bytes(const SizeClassStats& cls) {
+    return cls.slab_bytes > cls.live_bytes ? cls.slab_bytes - cls.live_bytes : 0;
+}
+
+struct PageOccupancy {
+    size_t metadata = 0;
+    size_t small = 0;
+    size_t large = 0;
+    size_t cached = 0;
+    size_t free = 0;
+    size_t untouched = 0;   // 边界之后从未切出的页
+};
+
+PageOccupancy count_pages(const MappedSegment* segment) {
+    PageOccupancy pages;
+    const size_t total_pages = SEGMENT_SIZE / PAGE_SIZE;
+    for (size_t i = 0; i < total_pages; ++i) {
+        if (i >= segment->next_free_page_idx_) {
+            pages.untouched++;
+            continue;
+        }
+        switch (segment->page_descriptors_[i].status) {
+            case PageStatus::METADATA:    pages.metadata++; break;
+            case PageStatus::SMALL_SLAB:  pages.small++; break;
+            case PageStatus::LARGE_SLAB:  pages.large++; break;
+            case PageStatus::CACHED_SLAB: pages.cached++; break;
+            default:                      pages.free++; break;
+        }
+    }
+    return pages;
+}
+
+struct SegmentDumpContext {
+    ReportWriter* out;
+    StatsFormat format;
+    bool first_heap;
+};
+
+void dump_heap_segments(ThreadHeap& heap, void* arg) {
+    auto* ctx = static_cast<SegmentDumpContext*>(arg);
+    ReportWriter& out = *ctx->out;
+    const bool json = ctx->format == StatsFormat::JSON;
+
+    if (json) {
+        out.str(ctx->first_heap ? "\n    " : ",\n    ").str("{\"heap\": \"").hex(&heap).str("\"");
+    } else {
+        out.str("heap ").hex(&heap).str(":");
+    }
+    ctx->first_heap = false;
+
+    // 锁计数器是原子量，不持锁也能读，正忙的 heap 同样能看出争用情况
+    uint64_t lock_acquisitions = 0;
+    uint64_t lock_contended = 0;
+    for (const LockCounters& lock : heap.stats_.locks) {
+        lock_acquisitions += lock.acquisitions.load(std::memory_order_relaxed);
+        lock_contended += lock.contended.load(std::memory_order_relaxed);
+    }
+    if (LOCK_STATS_ENABLED && json) {
+        out.str(", \"lock_acquisitions\": ").num(lock_acquisitions).str(", \"lock_contended\": ").num(lock_contended);
+    }
+    auto write_lock_line = [&] {
+        if (LOCK_STATS_ENABLED && !json) {
+            out.str("  lock ").num(lock_acquisitions).str(" acquisitions, ").num(lock_contended).str(" contended\n");
+        }
+    };
+
+    // 正在被所属线程使用的 heap 不等待，只标记为 busy
+    HeapLockGuard guard(heap.lock_, heap.stats_, LockSite::INSPECT, std::defer_lock);
+    if (!guard.try_lock()) {
+        out.str(json ? ", \"busy\": true}" : " busy\n");
+        write_lock_line();
+        return;
+    }
+
+    if (json) {
+        out.str(", \"busy\": false, \"segments\": [");
+    } else {
+        out.str("\n");
+        write_lock_line();
+    }
+
+    bool first_segment = true;
+    for (const MappedSegment* seg = heap.active_segments_; seg != nullptr; seg = seg->list_node.next) {
+        const PageOccupancy pages = count_pages(seg);
+        if (json) {
+            out.str(first_segment ? "\n      " : ",\n      ")
+               .str("{\"address\": \"").hex(seg)
+               .str("\", \"metadata\": ").num(pages.metadata)
+               .str(", \"small\": ").num(pages.small)
+               .str(", \"large\": ").num(pages.large)
+               .str(", \"cached\": ").num(pages.cached)
+               .str(", \"free\": ").num(pages.free)
+               .str(", \"untouched\": ").num(pages.untouched)
+               .str("}");
+        } else {
+            out.str("  segment ").hex(seg)
+               .str("  metadata ").num(pages.metadata, 3)
+               .str("  small ").num(pages.small, 3)
+               .str("  large ").num(pages.large, 3)
+               .str("  cached ").num(pages.cached, 3)
+               .str("  free ").num(pages.free, 3)
+               .str("  untouched ").num(pages.untouched, 3)
+               .str("\n");
+        }
+        first_segment = false;
+    }
+
+    size_t huge_count = 0;
+    size_t huge_bytes = 0;
+    for (const MappedSegment* seg = heap.huge_segments_; seg != nullptr; seg = seg->list_node.next) {
+        huge_count++;
+        huge_bytes += seg->total_size_;
+    }
+
+    if (json) {
+        out.str(first_segment ? "]" : "\n    ]")
+           .str(", \"huge_segments\": ").num(huge_count)
+           .str(", \"huge_bytes\": ").num(huge_bytes)
+           .str("}");
+    } else {
+        out.str("  huge segments ").num(huge_count).str(" (").num(huge_bytes).str(" bytes)\n");
+    }
+}
+
+void write_class_row_text(ReportWriter& out, size_t class_id, const SizeClassStats& cls,
+                          uint16_t slab_pages, size_t capacity) {
+    out.num(class_id, 5)
+       .num(cls.block_size, 10)
+       .num(slab_pages, 7)
+       .num(capacity, 10)
+       .num(cls.allocs, 13)
+       .num(cls.frees, 13)
+       .num(cls.slabs, 8)
+       .num(cls.live_bytes, 14)
+       .fixed(scaled_ratio(cls.live_bytes, cls.slab_bytes, 1000), 1, 8).str("%")
+       .num(wasted_bytes(cls), 13)
+       .str("\n");
+}
+
+void write_class_row_json(ReportWriter& out, bool first, size_t class_id, const SizeClassStats& cls,
+                          uint16_t slab_pages, size_t capacity) {
+    out.str(first ? "\n    " : ",\n    ")
+       .str("{\"class\": ").num(class_id)
+       .str(", \"block_size\": ").num(cls.block_size)
+       .str(", \"slab_pages\": ").num(slab_pages)
+       .str(", \"capacity\": ").num(capacity)
+       .str(", \"allocs\": ").num(cls.allocs)
+       .str(", \"frees\": ").num(cls.frees)
+       .str(", \"slabs\": ").num(cls.slabs)
+       .str(", \"live_bytes\": ").num(cls.live_bytes)
+       .str(", \"slab_bytes\": ").num(cls.slab_bytes)
+       .str(", \"utilization\": ").fixed(scaled_ratio(cls.live_bytes, cls.slab_bytes, 10000), 4)
+       .str(", \"wasted_bytes\": ").num(wasted_bytes(cls))
+       .str("}");
+}
+
+const char* const TABLE_HEADER =
+    "class     block  pages  capacity       allocs        frees   slabs    live_bytes    util       wasted\n";
+
+void dump_text(ReportWriter& out, const HeapStats& stats) {
+    const auto& config = SlabConfig::get_instance();
+
+    out.str("___ my_malloc statistics ___\n")
+       .str("heaps:          ").num(stats.num_heaps).str("\n")
+       .str("live bytes:     ").num(stats.live_bytes).str("\n")
+       .str("slab bytes:     ").num(stats.slab_bytes).str("\n")
+       .str("fragmentation:  ").fixed(static_cast<uint64_t>(stats.fragmentation() * 1000 + 0.5), 1).str("%\n")
+       .str("huge:           ").num(stats.huge_allocs).str(" allocs, ").num(stats.huge_frees).str(" frees, ")
+       .num(stats.huge_bytes).str(" bytes mapped\n")
+       .str("segments:       ").num(stats.segments).str(" (").num(stats.segment_bytes).str(" bytes)\n")
+       .str("system calls:   mmap ").num(stats.mmap_calls).str(", munmap ").num(stats.munmap_calls)
+       .str(", mremap ").num(stats.mremap_calls).str("\n")
+       .str("realloc:        ").num(stats.realloc_in_place).str(" in place, ").num(stats.realloc_remapped)
+       .str(" remapped, ").num(stats.realloc_copies).str(" copied (").num(stats.realloc_copied_bytes).str(" bytes)\n");
+
+    // 只列出用过的类，表格才不会被 100 多行空行淹没
+    out.str("\nsmall classes:\n").str(TABLE_HEADER);
+    for (size_t i = 0; i < stats.num_small_classes; ++i) {
+        const SizeClassStats& cls = stats.small_classes[i];
+        if (cls.allocs != 0 || cls.slabs != 0) {
+            const auto& info = config.get_info(i);
+            write_class_row_text(out, i, cls, info.slab_pages, info.slab_capacity);
+        }
+    }
+
+    out.str("\nmedium classes:\n").str(TABLE_HEADER);
+    for (size_t i = 0; i < stats.num_medium_classes; ++i) {
+        const SizeClassStats& cls = stats.medium_classes[i];
+        if (cls.allocs != 0 || cls.slabs != 0) {
+            write_class_row_text(out, i, cls, config.get_medium_class_pages(i), 1);
+        }
+    }
+
+    // 分位数取所在 log2 桶的上界，只有编译时打开直方图才有数据
+    if (LATENCY_HISTOGRAMS_ENABLED) {
+        out.str("\nslow paths (ticks):\n")
+           .str("path                   count        mean         p50         p99       p99.9\n");
+        for (size_t i = 0; i < NUM_SLOW_PATHS; ++i) {
+            const LatencyHistogram& histogram = stats.slow_paths[i];
+            out.str(slow_path_name(static_cast<SlowPath>(i)), 16)
+               .num(histogram.count, 12)
+               .num(histogram.mean(), 12)
+               .num(histogram.percentile(0.5), 12)
+               .num(histogram.percentile(0.99), 12)
+               .num(histogram.percentile(0.999), 12)
+               .str("\n");
+        }
+    }
+
+    if (LOCK_STATS_ENABLED) {
+        out.str("\nheap locks (ticks):\n")
+           .str("site               acquisitions   contended  spin_ticks  wait_ticks    hold p50    hold p99\n");
+        for (size_t i = 0; i < NUM_LOCK_SITES; ++i) {
+            const LockStats& lock = stats.locks[i];
+            out.str(lock_site_name(static_cast<LockSite>(i)), 16)
+               .num(lock.acquisitions, 15)
+               .num(lock.contended, 12)
+               .num(lock.spin_ticks, 12)
+               .num(lock.wait_ticks, 12)
+               .num(lock.hold.percentile(0.5), 12)
+               .num(lock.hold.percentile(0.99), 12)
+               .str("\n");
+        }
+    }
+    out.str("\n");
+}
+
+void dump_json(ReportWriter& out, const HeapStats& stats) {
+    const auto& config = SlabConfig::get_instance();
+
+    out.str("{\n  \"heaps\": ").num(stats.num_heaps)
+       .str(",\n  \"live_bytes\": ").num(stats.live_bytes)
+       .str(",\n  \"slab_bytes\": ").num(stats.slab_bytes)
+       .str(",\n  \"fragmentation\": ").fixed(static_cast<uint64_t>(stats.fragmentation() * 10000 + 0.5), 4)
+       .str(",\n  \"huge\": {\"allocs\": ").num(stats.huge_allocs)
+       .str(", \"frees\": ").num(stats.huge_frees)
+       .str(", \"bytes\": ").num(stats.huge_bytes).str("}")
+       .str(",\n  \"segments\": {\"count\": ").num(stats.segments)
+       .str(", \"bytes\": ").num(stats.segment_bytes).str("}")
+       .str(",\n  \"system_calls\": {\"mmap\": ").num(stats.mmap_calls)
+       .str(", \"munmap\": ").num(stats.munmap_calls)
+       .str(", \"mremap\": ").num(stats.mremap_calls).str("}")
+       .str(",\n  \"realloc\": {\"in_place\": ").num(stats.realloc_in_place)
+       .str(", \"remapped\": ").num(stats.realloc_remapped)
+       .str(", \"copies\": ").num(stats.realloc_copies)
+       .str(", \"copied_bytes\": ").num(stats.realloc_copied_bytes).str("}");
+
+    out.str(",\n  \"small_classes\": [");
+    bool first = true;
+    for (size_t i = 0; i < stats.num_small_classes; ++i) {
+        const SizeClassStats& cls = stats.small_classes[i];
+        if (cls.allocs != 0 || cls.slabs != 0) {
+            const auto& info = config.get_info(i);
+            write_class_row_json(out, first, i, cls, info.slab_pages, info.slab_capacity);
+            first = false;
+        }
+    }
+    out.str(first ? "]" : "\n  ]");
+
+    out.str(",\n  \"medium_classes\": [");
+    first = true;
+    for (size_t i = 0; i < stats.num_medium_classes; ++i) {
+        const SizeClassStats& cls = stats.medium_classes[i];
+        if (cls.allocs != 0 || cls.slabs != 0) {
+            write_class_row_json(out, first, i, cls, config.get_medium_class_pages(i), 1);
+            first = false;
+        }
+    }
+    out.str(first ? "]" : "\n  ]");
+
+    if (LATENCY_HISTOGRAMS_ENABLED) {
+        out.str(",\n  \"slow_paths\": {");
+        for (size_t i = 0; i < NUM_SLOW_PATHS; ++i) {
+            const LatencyHistogram& histogram = stats.slow_paths[i];
+            out.str(i == 0 ? "\n    \"" : ",\n    \"").str(slow_path_name(static_cast<SlowPath>(i)))
+               .str("\": {\"count\": ").num(histogram.count)
+               .str(", \"total_ticks\": ").num(histogram.total_ticks)
+               .str(", \"buckets\": [");
+            for (size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+                out.str(b == 0 ? "" : ", ").num(histogram.buckets[b]);
+            }
+            out.str("]}");
+        }
+        out.str("\n  }");
+    }
+
+    if (LOCK_STATS_ENABLED) {
+        out.str(",\n  \"locks\": {");
+        for (size_t i = 0; i < NUM_LOCK_SITES; ++i) {
+            const LockStats& lock = stats.locks[i];
+            out.str(i == 0 ? "\n    \"" : ",\n    \"").str(lock_site_name(static_cast<LockSite>(i)))
+               .str("\": {\"acquisitions\": ").num(lock.acquisitions)
+               .str(", \"contended\": ").num(lock.contended)
+               .str(", \"spin_ticks\": ").num(lock.spin_ticks)
+               .str(", \"wait_ticks\": ").num(lock.wait_ticks)
+               .str(", \"hold_total_ticks\": ").num(lock.hold.total_ticks)
+               .str(", \"hold_buckets\": [");
+            for (size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+                out.str(b == 0 ? "" : ", ").num(lock.hold.buckets[b]);
+            }
+            out.str("]}");
+        }
+        out.str("\n  }");
+    }
+}
+
+std::atomic<int> g_signal_fd{2};
+std::atomic<StatsFormat> g_signal_format{StatsFormat::TEXT};
+std::atomic<int> g_exit_fd{2};
+std::atomic<StatsFormat> g_exit_format{StatsFormat::TEXT};
+
+void stats_signal_handler(int /*signum*/) {
+    const int saved_errno = errno;
+    dump_stats(g_signal_fd.load(std::memory_order_relaxed), g_signal_format.load(std::memory_order_relaxed));
+    errno = saved_errno;
+}
+
+void stats_at_exit() {
+    dump_stats(g_exit_fd.load(std::memory_order_relaxed), g_exit_format.load(std::memory_order_relaxed));
+}
+
+} // namespace
+
+void dump_stats(int fd, StatsFormat format) {
+    ReportWriter out(fd);
+    const bool json = format == StatsFormat::JSON;
+
+    HeapStats stats;
+    if (!ThreadHeap::try_get_stats(stats)) {
+        out.str(json ? "{\"busy\": true}\n" : "my_malloc statistics: heap registry busy\n");
+        return;
+    }
+
+    if (json) {
+        dump_json(out, stats);
+        out.str(",\n  \"heap_segments\": [");
+    } else {
+        dump_text(out, stats);
+    }
+
+    SegmentDumpContext ctx{&out, format, true};
+    ThreadHeap::for_each_heap(dump_heap_segments, &ctx, false);
+
+    if (json) {
+        out.str(ctx.first_heap ? "]\n}\n" : "\n  ]\n}\n");
+    }
+}
+
+void dump_stats(FILE* out, StatsFormat format) {
+    fflush(out);
+    dump_stats(fileno(out), format);
+}
+
+bool install_stats_signal_handler(int signum, int fd, StatsFormat format) {
+    g_signal_fd.store(fd, std::memory_order_relaxed);
+    g_signal_format.store(format, std::memory_order_relaxed);
+
+    struct sigaction action = {};
+    action.sa_handler = stats_signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    return sigaction(signum, &action, nullptr) == 0;
+}
+
+bool dump_stats_at_exit(int fd, StatsFormat format) {
+    g_exit_fd.store(fd, std::memory_order_relaxed);
+    g_exit_format.store(format, std::memory_order_relaxed);
+
+    // 多次调用只登记一次
+    static const bool registered = std::atexit(stats_at_exit) == 0;
+    return registered;
+}
+
+} // namespace my_malloc
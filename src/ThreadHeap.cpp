@@ -1,8 +1,13 @@
 #include <my_malloc/ThreadHeap.hpp>
 
 #include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
 #include <my_malloc/internal/AllocSlab.hpp>
+#include <my_malloc/internal/AllocTrace.hpp>
+#include <my_malloc/internal/HeapLock.hpp>
+#include <my_malloc/internal/HeapProfiler.hpp>
 #include <my_malloc/internal/SlabConfig.hpp>
+#include <my_malloc/sys/sdt.hpp>
 
 #include <cassert>
 #include <new>
@@ -11,10 +16,142 @@
 
 namespace my_malloc {
 
-ThreadHeap::ThreadHeap() {
+namespace {
+
+constexpr size_t get_huge_object_threshold() {
+    const size_t segment_header_pages = (sizeof(MappedSegment) + PAGE_SIZE - 1) / PAGE_SIZE;
+    const size_t max_pages_in_segment = (SEGMENT_SIZE / PAGE_SIZE) - segment_header_pages;
+    return max_pages_in_segment * PAGE_SIZE;
+}
+
+// 所有存活的 ThreadHeap 串成一条链表，供 get_stats() 遍历。
+// 不析构：线程退出时的 heap 可能晚于静态对象析构才注销
+struct HeapRegistry {
+    std::mutex lock;
+    ThreadHeap* head = nullptr;
+    HeapCounters retired;   // 已销毁 heap 的累计分配/释放次数和慢路径延迟
+};
+
+HeapRegistry& get_registry() {
+    alignas(HeapRegistry) static unsigned char storage[sizeof(HeapRegistry)];
+    static HeapRegistry* registry = new (storage) HeapRegistry();
+    return *registry;
+}
+
+void retire_counters(const HeapCounters& from, HeapCounters& to) {
+    auto fold = [](const ClassCounters& src, ClassCounters& dst) {
+        HeapCounters::add(dst.allocs, src.allocs.load(std::memory_order_relaxed));
+        HeapCounters::add(dst.frees, src.frees.load(std::memory_order_relaxed));
+    };
+    for (size_t i = 0; i < MAX_NUM_SIZE_CLASSES; ++i) {
+        fold(from.small[i], to.small[i]);
+    }
+    for (size_t i = 0; i < MAX_NUM_MEDIUM_CLASSES; ++i) {
+        fold(from.medium[i], to.medium[i]);
+    }
+    HeapCounters::add(to.huge_allocs, from.huge_allocs.load(std::memory_order_relaxed));
+    HeapCounters::add(to.huge_frees, from.huge_frees.load(std::memory_order_relaxed));
+    HeapCounters::add(to.realloc_in_place, from.realloc_in_place.load(std::memory_order_relaxed));
+    HeapCounters::add(to.realloc_remapped, from.realloc_remapped.load(std::memory_order_relaxed));
+    HeapCounters::add(to.realloc_copies, from.realloc_copies.load(std::memory_order_relaxed));
+    HeapCounters::add(to.realloc_copied_bytes, from.realloc_copied_bytes.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < NUM_SLOW_PATHS; ++i) {
+        for (size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+            HeapCounters::add(to.slow_paths[i].buckets[b], from.slow_paths[i].buckets[b].load(std::memory_order_relaxed));
+        }
+        HeapCounters::add(to.slow_paths[i].total_ticks, from.slow_paths[i].total_ticks.load(std::memory_order_relaxed));
+    }
+    for (size_t i = 0; i < NUM_LOCK_SITES; ++i) {
+        const LockCounters& src = from.locks[i];
+        LockCounters& dst = to.locks[i];
+        HeapCounters::add(dst.acquisitions, src.acquisitions.load(std::memory_order_relaxed));
+        HeapCounters::add(dst.contended, src.contended.load(std::memory_order_relaxed));
+        HeapCounters::add(dst.spin_ticks, src.spin_ticks.load(std::memory_order_relaxed));
+        HeapCounters::add(dst.wait_ticks, src.wait_ticks.load(std::memory_order_relaxed));
+        for (size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+            HeapCounters::add(dst.hold.buckets[b], src.hold.buckets[b].load(std::memory_order_relaxed));
+        }
+        HeapCounters::add(dst.hold.total_ticks, src.hold.total_ticks.load(std::memory_order_relaxed));
+    }
+}
+
+void accumulate_counters(const HeapCounters& counters, HeapStats& stats) {
+    auto sum = [](const ClassCounters& src, SizeClassStats& dst) {
+        dst.allocs += src.allocs.load(std::memory_order_relaxed);
+        dst.frees += src.frees.load(std::memory_order_relaxed);
+        dst.slabs += src.slabs.load(std::memory_order_relaxed);
+    };
+    for (size_t i = 0; i < MAX_NUM_SIZE_CLASSES; ++i) {
+        sum(counters.small[i], stats.small_classes[i]);
+    }
+    for (size_t i = 0; i < MAX_NUM_MEDIUM_CLASSES; ++i) {
+        sum(counters.medium[i], stats.medium_classes[i]);
+    }
+    stats.huge_allocs += counters.huge_allocs.load(std::memory_order_relaxed);
+    stats.huge_frees += counters.huge_frees.load(std::memory_order_relaxed);
+    stats.huge_bytes += counters.huge_bytes.load(std::memory_order_relaxed);
+    stats.segments += counters.segments.load(std::memory_order_relaxed);
+    stats.realloc_in_place += counters.realloc_in_place.load(std::memory_order_relaxed);
+    stats.realloc_remapped += counters.realloc_remapped.load(std::memory_order_relaxed);
+    stats.realloc_copies += counters.realloc_copies.load(std::memory_order_relaxed);
+    stats.realloc_copied_bytes += counters.realloc_copied_bytes.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < NUM_SLOW_PATHS; ++i) {
+        LatencyHistogram& histogram = stats.slow_paths[i];
+        for (size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+            const uint64_t n = counters.slow_paths[i].buckets[b].load(std::memory_order_relaxed);
+            histogram.buckets[b] += n;
+            histogram.count += n;
+        }
+        histogram.total_ticks += counters.slow_paths[i].total_ticks.load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < NUM_LOCK_SITES; ++i) {
+        const LockCounters& src = counters.locks[i];
+        LockStats& dst = stats.locks[i];
+        dst.acquisitions += src.acquisitions.load(std::memory_order_relaxed);
+        dst.contended += src.contended.load(std::memory_order_relaxed);
+        dst.spin_ticks += src.spin_ticks.load(std::memory_order_relaxed);
+        dst.wait_ticks += src.wait_ticks.load(std::memory_order_relaxed);
+        for (size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+            const uint64_t n = src.hold.buckets[b].load(std::memory_order_relaxed);
+            dst.hold.buckets[b] += n;
+            dst.hold.count += n;
+        }
+        dst.hold.total_ticks += src.hold.total_ticks.load(std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+ThreadHeap::ThreadHeap()
+    : sample_rng_state_(reinterpret_cast<uintptr_t>(this) | 1) {
+    HeapRegistry& registry = get_registry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    registry_next_ = registry.head;
+    if (registry.head != nullptr) {
+        registry.head->registry_prev_ = this;
+    }
+    registry.head = this;
 }
 
 ThreadHeap::~ThreadHeap() {
+    // 先从注册表摘下再拆除：for_each_heap 遍历期间一直持有 registry.lock，
+    // 摘下之后 dump_stats、purge_all_heaps 都不会再碰到这个正在析构的 heap
+    {
+        HeapRegistry& registry = get_registry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+
+        if (registry_prev_ != nullptr) {
+            registry_prev_->registry_next_ = registry_next_;
+        } else {
+            registry.head = registry_next_;
+        }
+        if (registry_next_ != nullptr) {
+            registry_next_->registry_prev_ = registry_prev_;
+        }
+        retire_counters(stats_, registry.retired);
+    }
+
     auto destroy_segment_list = [](MappedSegment* list_head) {
         MappedSegment* current = list_head;
         while (current) {
@@ -27,8 +164,95 @@ ThreadHeap::~ThreadHeap() {
     destroy_segment_list(active_segments_);
     active_segments_ = nullptr;
 
-    destroy_segment_list(huge_segments_);
+    // 区域中的 Huge 对象随整个区域一起释放
+    MappedSegment* current = huge_segments_;
+    while (current) {
+        MappedSegment* next = current->list_node.next;
+        if (!current->is_region_backed()) {
+            MappedSegment::destroy(current);
+        }
+        current = next;
+    }
     huge_segments_ = nullptr;
+
+    huge_cache_.release_all();
+    segment_region_.release_all();
+
+    HeapProfiler::get_instance().retire_heap(this);
+}
+
+HeapStats ThreadHeap::get_stats() {
+    HeapStats stats;
+    collect_stats(stats, true);
+    return stats;
+}
+
+bool ThreadHeap::try_get_stats(HeapStats& stats) {
+    return collect_stats(stats, false);
+}
+
+bool ThreadHeap::for_each_heap(void (*fn)(ThreadHeap& heap, void* arg), void* arg, bool blocking) {
+    HeapRegistry& registry = get_registry();
+    std::unique_lock<std::mutex> guard(registry.lock, std::defer_lock);
+    if (blocking) {
+        guard.lock();
+    } else if (!guard.try_lock()) {
+        return false;
+    }
+
+    for (ThreadHeap* heap = registry.head; heap != nullptr; heap = heap->registry_next_) {
+        fn(*heap, arg);
+    }
+    return true;
+}
+
+bool ThreadHeap::collect_stats(HeapStats& stats, bool blocking) {
+    stats = HeapStats();
+    {
+        HeapRegistry& registry = get_registry();
+        std::unique_lock<std::mutex> guard(registry.lock, std::defer_lock);
+        if (blocking) {
+            guard.lock();
+        } else if (!guard.try_lock()) {
+            return false;
+        }
+
+        // 计数器只由所属线程写入，这里不加 heap 锁，读到的是各计数器某一时刻的值
+        accumulate_counters(registry.retired, stats);
+        for (const ThreadHeap* heap = registry.head; heap != nullptr; heap = heap->registry_next_) {
+            accumulate_counters(heap->stats_, stats);
+            stats.num_heaps++;
+        }
+    }
+
+    const auto& config = SlabConfig::get_instance();
+    auto finish = [&stats](SizeClassStats& cls, size_t block_size, size_t bytes_per_slab) {
+        cls.block_size = block_size;
+        // 并发读取时 frees 可能比 allocs 新
+        cls.live_bytes = cls.allocs > cls.frees ? (cls.allocs - cls.frees) * block_size : 0;
+        cls.slab_bytes = cls.slabs * bytes_per_slab;
+        stats.live_bytes += cls.live_bytes;
+        stats.slab_bytes += cls.slab_bytes;
+    };
+
+    stats.num_small_classes = config.get_num_classes();
+    for (size_t i = 0; i < stats.num_small_classes; ++i) {
+        const auto& info = config.get_info(i);
+        finish(stats.small_classes[i], info.block_size, info.slab_pages * PAGE_SIZE);
+    }
+    stats.num_medium_classes = config.get_num_medium_classes();
+    for (size_t i = 0; i < stats.num_medium_classes; ++i) {
+        const size_t span_size = config.get_medium_class_pages(i) * PAGE_SIZE;
+        finish(stats.medium_classes[i], span_size, span_size);
+    }
+
+    stats.segment_bytes = stats.segments * SEGMENT_SIZE;
+
+    const SegmentCounters& segment_counters = MappedSegment::get_counters();
+    stats.mmap_calls = segment_counters.mmap_calls.load(std::memory_order_relaxed);
+    stats.munmap_calls = segment_counters.munmap_calls.load(std::memory_order_relaxed);
+    stats.mremap_calls = segment_counters.mremap_calls.load(std::memory_order_relaxed);
+    return true;
 }
 
 void* ThreadHeap::allocate_from_small_slab_cache(size_t class_id) {
@@ -48,9 +272,16 @@ void* ThreadHeap::allocate_from_small_slab_cache(size_t class_id) {
         return ptr;
     }
 
-    SmallSlabHeader* new_slab = allocate_small_slab(class_id);
-    if (new_slab == nullptr) {
-        return nullptr;
+    // 先复用预留的空 slab，它的页描述符和位图都还有效
+    SmallSlabHeader* new_slab = cache.empty_slabs;
+    if (new_slab != nullptr) {
+        cache.empty_slabs = new_slab->next_;
+        cache.num_empty--;
+    } else {
+        new_slab = allocate_small_slab(class_id);
+        if (new_slab == nullptr) {
+            return nullptr;
+        }
     }
 
     new_slab->next_ = cache.list_head.next_;
@@ -71,10 +302,42 @@ void* ThreadHeap::allocate_from_small_slab_cache(size_t class_id) {
 
 
 void* ThreadHeap::allocate_huge_slab(size_t size) {
-    const size_t segment_header_size = sizeof(MappedSegment);
-    const size_t total_alloc_size = (segment_header_size + size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
-    
-    MappedSegment* huge_seg = MappedSegment::create(total_alloc_size);
+    const auto& options = AllocatorOptions::get_instance();
+    const bool aligned_layout = options.huge_layout.load(std::memory_order_relaxed) == HugeLayout::SEGMENT_ALIGNED;
+
+    const size_t segment_header_size = aligned_layout ? SEGMENT_METADATA_SIZE : sizeof(MappedSegment);
+    size_t total_alloc_size = (segment_header_size + size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+    const size_t hugetlb_page_size = MappedSegment::get_hugetlb_page_size();
+    const bool try_hugetlb = hugetlb_page_size != 0
+        && options.hugetlb_mode.load(std::memory_order_relaxed) != HugeTlbMode::OFF;
+    if (try_hugetlb) {
+        // 先按大页取整，让缓存的桶大小与真实映射长度一致。
+        // 对齐布局下头部独占映射开头的一个 SEGMENT_SIZE 区间。
+        if (aligned_layout) {
+            total_alloc_size = SEGMENT_SIZE + size;
+        }
+        total_alloc_size = (total_alloc_size + hugetlb_page_size - 1) & ~(hugetlb_page_size - 1);
+    }
+
+    // 不超过几个 Segment 的请求优先从连续区域中取整段 Segment，空闲的相邻 Segment 在位图中天然合并
+    MappedSegment* huge_seg = nullptr;
+    const size_t region_max_segments = options.region_max_segments.load(std::memory_order_relaxed);
+    if (!aligned_layout && !try_hugetlb && region_max_segments != 0) {
+        const size_t num_segments = (segment_header_size + size + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+        if (num_segments <= region_max_segments) {
+            huge_seg = segment_region_.take(num_segments);
+        }
+    }
+
+    if (huge_seg == nullptr) {
+        const size_t mapping_size = HugeSegmentCache::round_to_bucket_size(total_alloc_size);
+        huge_seg = huge_cache_.take(mapping_size, aligned_layout, HugeSegmentCache::now_ms());
+        if (huge_seg == nullptr) {
+            SlowPathTimer timer(stats_, SlowPath::HUGE_MAP);
+            huge_seg = MappedSegment::create_huge(mapping_size, aligned_layout, try_hugetlb);
+        }
+    }
     if (huge_seg == nullptr) { 
         return nullptr; // OOM
     }
@@ -90,8 +353,10 @@ void* ThreadHeap::allocate_huge_slab(size_t size) {
     }
     huge_segments_ = huge_seg;
 
-
-    return reinterpret_cast<char*>(huge_seg) + segment_header_size;
+    HeapCounters::add(stats_.huge_allocs, 1);
+    HeapCounters::add(stats_.huge_bytes, huge_seg->total_size_);
+    MY_SDT_PROBE3(my_malloc, huge_alloc, huge_seg->get_huge_user_ptr(), size, huge_seg->total_size_);
+    return huge_seg->get_huge_user_ptr();
 }
 
 
@@ -100,30 +365,211 @@ void* ThreadHeap::allocate(size_t size) {
         return nullptr;
     }
 
-    std::lock_guard<std::mutex> guard(lock_);
-
-    const size_t segment_header_pages = (sizeof(MappedSegment) + PAGE_SIZE - 1) / PAGE_SIZE;
-    const size_t max_pages_in_segment = (SEGMENT_SIZE / PAGE_SIZE) - segment_header_pages;
-    const size_t huge_object_threshold = max_pages_in_segment * PAGE_SIZE - sizeof(LargeSlabHeader);
+    HeapLockGuard guard(lock_, stats_, LockSite::ALLOCATE);
+    return allocate_locked(size);
+}
 
-    if (size > huge_object_threshold) {
-        return allocate_huge_slab(size);
+// 调用者持有 lock_。强制内联，采样时跳过的两帧仍是 sample_allocation 与 allocate/reallocate
+__attribute__((always_inline))
+inline void* ThreadHeap::allocate_locked(size_t size) {
+    void* ptr;
+    if (size > get_huge_object_threshold()) {
+        ptr = allocate_huge_slab(size);
     }
     else if (size > MAX_SMALL_OBJECT_SIZE) { 
-        const size_t total_size = size + sizeof(LargeSlabHeader);
-        const size_t num_pages = (total_size + PAGE_SIZE - 1) / PAGE_SIZE;
-        return allocate_large_slab(static_cast<uint16_t>(num_pages));
+        const auto& config = SlabConfig::get_instance();
+        const size_t num_pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+        const size_t class_id = config.get_medium_class_index(num_pages);
+        ptr = allocate_medium_slab(class_id);
+        if (ptr != nullptr) {
+            HeapCounters::add(stats_.medium[class_id].allocs, 1);
+        }
     }
     else {
         const auto& config = SlabConfig::get_instance();
         size_t class_id = config.get_size_class_index(size);
-        return allocate_from_small_slab_cache(class_id);
+        ptr = allocate_from_small_slab_cache(class_id);
+        if (ptr != nullptr) {
+            HeapCounters::add(stats_.small[class_id].allocs, 1);
+        }
+    }
+
+    // 不采样时只有这一个分支
+    bytes_until_sample_ -= static_cast<int64_t>(size);
+    if (__builtin_expect(bytes_until_sample_ < 0, 0)) {
+        sample_allocation(ptr, size);
+    }
+    if (__builtin_expect(AllocTrace::is_recording(), 0) && ptr != nullptr) {
+        AllocTrace::get_instance().record(TraceOp::ALLOC, ptr, size);
+    }
+    return ptr;
+}
+
+__attribute__((noinline))
+void ThreadHeap::sample_allocation(void* ptr, size_t size) {
+    const size_t interval = AllocatorOptions::get_instance().profile_sample_interval.load(std::memory_order_relaxed);
+    if (interval == 0) {
+        sampling_armed_ = false;
+        bytes_until_sample_ = PROFILE_RECHECK_BYTES;
+        return;
+    }
+
+    // 刚从关闭状态切换过来的这次分配不算样本，只抽取第一个间隔
+    const bool take_sample = sampling_armed_ && ptr != nullptr;
+    sampling_armed_ = true;
+    bytes_until_sample_ = HeapProfiler::next_sample_distance(&sample_rng_state_, interval);
+    if (!take_sample) {
+        return;
+    }
+
+    // 跳过本函数和 allocate 两帧，第一帧就是调用者
+    void* stack[PROFILE_MAX_DEPTH];
+    const size_t depth = HeapProfiler::capture_stack(stack, PROFILE_MAX_DEPTH, 2);
+    HeapProfiler::get_instance().record_allocation(ptr, size, this, stack, depth, interval, get_sample_desc(ptr));
+}
+
+PageDescriptor* ThreadHeap::get_sample_desc(void* ptr) {
+    // Huge 对象的标记放在首个描述符上，free 时也只看这一个
+    MappedSegment* segment = MappedSegment::get_owning_segment(ptr);
+    if (segment->page_descriptors_[0].status == PageStatus::HUGE_SLAB) {
+        return &segment->page_descriptors_[0];
+    }
+    return segment->get_page_desc(ptr);
+}
+
+void* ThreadHeap::reallocate_huge_slab(MappedSegment* segment, size_t size) {
+    const size_t segment_header_size = segment->get_huge_user_offset();
+    const size_t required_size = ((segment_header_size + size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1))
+                               + segment->mapping_offset_;
+
+    HeapLockGuard guard(lock_, stats_, LockSite::REALLOC);
+
+    const size_t old_size = segment->total_size_;
+
+    // 取整后的桶内余量足够时直接复用；缩小到一半以下时才归还尾部
+    size_t new_size = segment->total_size_;
+    if (required_size > segment->total_size_ || required_size <= segment->total_size_ / 2) {
+        new_size = HugeSegmentCache::round_to_bucket_size(required_size);
+    }
+
+    MappedSegment* moved = MappedSegment::remap(segment, new_size);
+    if (moved == nullptr) {
+        return nullptr;
+    }
+    // 原地伸缩也要更新样本的大小，否则桶的 inuse_bytes 会一直停在旧值
+    if (moved->page_descriptors_[0].sampled != 0) {
+        HeapProfiler::get_instance().record_move(
+            reinterpret_cast<char*>(segment) + moved->get_huge_user_offset(), moved->get_huge_user_ptr(), size);
+    }
+    HeapCounters::sub(stats_.huge_bytes, old_size);
+    HeapCounters::add(stats_.huge_bytes, moved->total_size_);
+    HeapCounters::add(moved == segment ? stats_.realloc_in_place : stats_.realloc_remapped, 1);
+
+    if (moved != segment) {
+        MappedSegment* prev_node = moved->list_node.prev;
+        MappedSegment* next_node = moved->list_node.next;
+
+        if (prev_node != nullptr) {
+            prev_node->list_node.next = moved;
+        } else {
+            assert(huge_segments_ == segment);
+            huge_segments_ = moved;
+        }
+
+        if (next_node != nullptr) {
+            next_node->list_node.prev = moved;
+        }
+    }
+
+    return moved->get_huge_user_ptr();
+}
+
+void* ThreadHeap::reallocate(void* ptr, size_t size) {
+    if (ptr == nullptr) {
+        return allocate(size);
+    }
+    if (size == 0) {
+        free(ptr);
+        return nullptr;
+    }
+
+    MappedSegment* segment = MappedSegment::get_owning_segment(ptr);
+    if (segment->page_descriptors_[0].status == PageStatus::HUGE_SLAB && size > get_huge_object_threshold()) {
+        void* new_ptr = reallocate_huge_slab(segment, size);
+        if (new_ptr != nullptr) {
+            // 原地 realloc 不经过 allocate/free，按释放加分配记录
+            if (__builtin_expect(AllocTrace::is_recording(), 0)) {
+                AllocTrace::get_instance().record(TraceOp::FREE, ptr, 0);
+                AllocTrace::get_instance().record(TraceOp::ALLOC, new_ptr, size);
+            }
+            return new_ptr;
+        }
+    }
+
+    const size_t old_size = get_usable_size(ptr);
+    if (old_size == 0) {
+        return nullptr;
+    }
+
+    if (size <= old_size && size > old_size / 2) {
+        HeapLockGuard guard(lock_, stats_, LockSite::REALLOC);
+        HeapCounters::add(stats_.realloc_in_place, 1);
+        return ptr;
+    }
+
+    // 复制的计数与新块的分配放在同一个临界区里
+    const size_t copy_size = size < old_size ? size : old_size;
+    void* new_ptr;
+    {
+        HeapLockGuard guard(lock_, stats_, LockSite::ALLOCATE);
+        new_ptr = allocate_locked(size);
+        if (new_ptr == nullptr) {
+            return nullptr;
+        }
+        HeapCounters::add(stats_.realloc_copies, 1);
+        HeapCounters::add(stats_.realloc_copied_bytes, copy_size);
+    }
+
+    memcpy(new_ptr, ptr, copy_size);
+    free(ptr);
+    return new_ptr;
+}
+
+size_t ThreadHeap::get_usable_size(const void* ptr) {
+    if (ptr == nullptr) {
+        return 0;
+    }
+
+    const MappedSegment* segment = MappedSegment::get_owning_segment(ptr);
+    if (segment->page_descriptors_[0].status == PageStatus::HUGE_SLAB) {
+        return segment->get_huge_usable_size();
+    }
+
+    const void* slab_header_ptr = segment->get_page_desc(ptr)->slab_ptr;
+    if (slab_header_ptr == nullptr) {
+        return 0;
+    }
+
+    switch (segment->get_page_desc(slab_header_ptr)->status) {
+        case PageStatus::LARGE_SLAB: {
+            return segment->get_page_desc(slab_header_ptr)->num_pages * PAGE_SIZE;
+        }
+        case PageStatus::SMALL_SLAB: {
+            const auto* header = static_cast<const SmallSlabHeader*>(slab_header_ptr);
+            return SlabConfig::get_instance().get_info(header->slab_class_id_).block_size;
+        }
+        default:
+            return 0;
     }
 }
 
 void ThreadHeap::free_huge_slab(MappedSegment* segment) {
     {
-        std::lock_guard<std::mutex> guard(lock_);
+        HeapLockGuard guard(lock_, stats_, LockSite::HUGE_FREE);
+
+        HeapCounters::add(stats_.huge_frees, 1);
+        HeapCounters::sub(stats_.huge_bytes, segment->total_size_);
+        MY_SDT_PROBE2(my_malloc, huge_free, segment->get_huge_user_ptr(), segment->total_size_);
 
         MappedSegment* prev_node = segment->list_node.prev;
         MappedSegment* next_node = segment->list_node.next;
@@ -138,29 +584,81 @@ void ThreadHeap::free_huge_slab(MappedSegment* segment) {
         if (next_node != nullptr) {
             next_node->list_node.prev = prev_node;
         }
+
+        if (segment->is_region_backed()) {
+            segment_region_.put(segment);
+            return;
+        }
+
+        if (huge_cache_.put(segment, HugeSegmentCache::now_ms())) {
+            return;
+        }
     }
 
     MappedSegment::destroy(segment);
 }
 
 void ThreadHeap::free_large_slab(void* slab_ptr) {
-    auto* header = static_cast<LargeSlabHeader*>(slab_ptr);
-    release_slab(slab_ptr, header->num_pages_);
+    const MappedSegment* segment = MappedSegment::get_segment(slab_ptr);
+    const uint16_t num_pages = segment->get_page_desc(slab_ptr)->num_pages;
+
+    const auto& config = SlabConfig::get_instance();
+    const size_t class_id = config.get_medium_class_index(num_pages);
+    if (class_id < config.get_num_medium_classes() && config.get_medium_class_pages(class_id) == num_pages) {
+        ClassCounters& counters = stats_.medium[class_id];
+        HeapCounters::add(counters.frees, 1);
+        if (cache_medium_slab(slab_ptr, class_id)) {
+            return;
+        }
+        HeapCounters::sub(counters.slabs, 1);
+    }
+    release_slab(slab_ptr, num_pages);
+}
+
+bool ThreadHeap::cache_medium_slab(void* slab_ptr, size_t class_id) {
+    MediumSpanCache& cache = medium_caches_[class_id];
+    const size_t depth = AllocatorOptions::get_instance().medium_cache_depth.load(std::memory_order_relaxed);
+    if (cache.count >= depth) {
+        return false;
+    }
+
+    // 只改首页状态：其余页仍指向首页，重复释放会在首页状态检查处被忽略，
+    // 相邻 span 合并时也不会把它当作空闲页吞掉
+    MappedSegment* segment = MappedSegment::get_segment(slab_ptr);
+    segment->get_page_desc(slab_ptr)->status = PageStatus::CACHED_SLAB;
+
+    auto* node = static_cast<MediumSpanNode*>(slab_ptr);
+    node->next = cache.head;
+    cache.head = node;
+    cache.count++;
+    return true;
 }
 
 
 void ThreadHeap::free_in_small_slab(void* ptr, SmallSlabHeader* header) {
     const bool was_full = header->is_full();
     header->free_block(ptr);
+    HeapCounters::add(stats_.small[header->slab_class_id_].frees, 1);
 
     if (header->is_empty()) {
         if (header->prev_ != nullptr && header->next_ != nullptr) {
             header->prev_->next_ = header->next_;
             header->next_->prev_ = header->prev_;
         }
-        
+
+        SlabCache& cache = slab_caches_[header->slab_class_id_];
+        const size_t reserve = AllocatorOptions::get_instance().empty_slab_reserve.load(std::memory_order_relaxed);
+        if (cache.num_empty < reserve) {
+            header->prev_ = nullptr;
+            header->next_ = cache.empty_slabs;
+            cache.empty_slabs = header;
+            cache.num_empty++;
+            return;
+        }
+
         const auto& config = SlabConfig::get_instance();
         const auto& info = config.get_info(header->slab_class_id_);
+        HeapCounters::sub(stats_.small[header->slab_class_id_].slabs, 1);
         release_slab(header, info.slab_pages);
 
     } else if (was_full) {
@@ -179,9 +677,16 @@ void ThreadHeap::free(void* ptr) {
         return; 
     }
 
-    MappedSegment* segment = MappedSegment::get_segment(ptr);
+    if (__builtin_expect(AllocTrace::is_recording(), 0)) {
+        AllocTrace::get_instance().record(TraceOp::FREE, ptr, 0);
+    }
+
+    MappedSegment* segment = MappedSegment::get_owning_segment(ptr);
     
     if (segment->page_descriptors_[0].status == PageStatus::HUGE_SLAB) {
+        if (segment->page_descriptors_[0].sampled != 0) {
+            HeapProfiler::get_instance().record_free(ptr, &segment->page_descriptors_[0]);
+        }
         free_huge_slab(segment);
         return;
     }
@@ -189,12 +694,17 @@ void ThreadHeap::free(void* ptr) {
     PageDescriptor* desc_at_ptr = segment->get_page_desc(ptr);
     void* slab_header_ptr = desc_at_ptr->slab_ptr;
 
+    // 必须在真正释放之前注销样本，否则同一地址可能先被重新分配并采样
+    if (desc_at_ptr->sampled != 0) {
+        HeapProfiler::get_instance().record_free(ptr, desc_at_ptr);
+    }
+
 
     if (slab_header_ptr == nullptr) {
         return;
     }
     
-    std::lock_guard<std::mutex> guard(lock_);
+    HeapLockGuard guard(lock_, stats_, LockSite::FREE);
     
     PageDescriptor* desc_at_header = segment->get_page_desc(slab_header_ptr);
 
@@ -214,6 +724,95 @@ void ThreadHeap::free(void* ptr) {
 }
 
 
+void ThreadHeap::purge() {
+    HeapLockGuard guard(lock_, stats_, LockSite::PURGE);
+    const auto& config = SlabConfig::get_instance();
+
+    for (size_t class_id = 0; class_id < MAX_NUM_SIZE_CLASSES; ++class_id) {
+        SlabCache& cache = slab_caches_[class_id];
+        while (cache.empty_slabs != nullptr) {
+            SmallSlabHeader* header = cache.empty_slabs;
+            cache.empty_slabs = header->next_;
+            HeapCounters::sub(stats_.small[class_id].slabs, 1);
+            release_slab(header, config.get_info(class_id).slab_pages);
+        }
+        cache.num_empty = 0;
+    }
+
+    for (size_t class_id = 0; class_id < MAX_NUM_MEDIUM_CLASSES; ++class_id) {
+        MediumSpanCache& cache = medium_caches_[class_id];
+        while (cache.head != nullptr) {
+            MediumSpanNode* node = cache.head;
+            cache.head = node->next;
+            HeapCounters::sub(stats_.medium[class_id].slabs, 1);
+            release_slab(node, config.get_medium_class_pages(class_id));
+        }
+        cache.count = 0;
+    }
+
+    huge_cache_.purge_all();
+    segment_region_.purge_free();
+}
+
+void ThreadHeap::purge_all_heaps() {
+    for_each_heap([](ThreadHeap& heap, void*) { heap.purge(); }, nullptr);
+}
+
+bool ThreadHeap::heap_walk(void (*fn)(const HeapBlock& block, void* arg), void* arg, bool blocking) {
+    HeapLockGuard guard(lock_, stats_, LockSite::INSPECT, std::defer_lock);
+    if (blocking) {
+        guard.lock();
+    } else if (!guard.try_lock()) {
+        return false;
+    }
+
+    const auto& config = SlabConfig::get_instance();
+    for (MappedSegment* segment = active_segments_; segment != nullptr; segment = segment->list_node.next) {
+        // 每次跳过一整个 slab 或 span，边界之后的页从未使用过
+        size_t page = 0;
+        while (page < segment->next_free_page_idx_) {
+            const PageDescriptor& desc = segment->page_descriptors_[page];
+            char* page_ptr = reinterpret_cast<char*>(segment) + page * PAGE_SIZE;
+
+            if (desc.status == PageStatus::SMALL_SLAB) {
+                const auto* header = static_cast<const SmallSlabHeader*>(desc.slab_ptr);
+                const auto& info = config.get_info(header->slab_class_id_);
+                char* blocks = reinterpret_cast<char*>(desc.slab_ptr) + info.slab_metadata_size;
+
+                // 位图中 1 表示空闲，反过来就是存活的块
+                const size_t num_words = (info.slab_capacity + 63) / 64;
+                for (size_t w = 0; w < num_words && header->free_count_ < info.slab_capacity; ++w) {
+                    uint64_t live = ~header->bitmap[w];
+                    const size_t valid_bits = info.slab_capacity - w * 64;
+                    if (valid_bits < 64) {
+                        live &= (uint64_t{1} << valid_bits) - 1;
+                    }
+                    while (live != 0) {
+                        const size_t index = w * 64 + static_cast<size_t>(__builtin_ctzll(live));
+                        live &= live - 1;
+                        fn(HeapBlock{blocks + index * info.block_size, info.block_size, BlockKind::SMALL}, arg);
+                    }
+                }
+                page += info.slab_pages;
+            } else if (desc.status == PageStatus::LARGE_SLAB) {
+                fn(HeapBlock{page_ptr, desc.num_pages * PAGE_SIZE, BlockKind::LARGE}, arg);
+                page += desc.num_pages;
+            } else if (desc.status == PageStatus::CACHED_SLAB) {
+                page += desc.num_pages;
+            } else if (desc.status == PageStatus::FREE && desc.slab_ptr == page_ptr) {
+                page += static_cast<const LargeSlabHeader*>(desc.slab_ptr)->num_pages_;
+            } else {
+                page++;
+            }
+        }
+    }
+
+    for (MappedSegment* segment = huge_segments_; segment != nullptr; segment = segment->list_node.next) {
+        fn(HeapBlock{segment->get_huge_user_ptr(), segment->get_huge_usable_size(), BlockKind::HUGE}, arg);
+    }
+    return true;
+}
+
 void ThreadHeap::push_pending_free(void* /*ptr*/) {
 }
 
@@ -223,28 +822,49 @@ void ThreadHeap::process_pending_frees() {
 }
 
 void* ThreadHeap::allocate_large_slab(uint16_t num_pages) {
-    void* header_ptr = acquire_pages(num_pages);
-    if (header_ptr == nullptr) {
+    void* slab_ptr = acquire_pages(num_pages);
+    if (slab_ptr == nullptr) {
         return nullptr;
     }
 
-    MappedSegment* segment = MappedSegment::get_segment(header_ptr);
+    // 元数据只记录在 PageDescriptor 中，整个 slab 都交给用户，用户指针按页对齐
+    MappedSegment* segment = MappedSegment::get_segment(slab_ptr);
     for (uint16_t i = 0; i < num_pages; ++i) {
         PageDescriptor* desc = segment->get_page_desc(
-            reinterpret_cast<char*>(header_ptr) + i * PAGE_SIZE
+            static_cast<char*>(slab_ptr) + i * PAGE_SIZE
         );
         desc->status = PageStatus::LARGE_SLAB;
-        desc->slab_ptr = header_ptr;
+        desc->slab_ptr = slab_ptr;
+        desc->num_pages = 0;
+        desc->sampled = 0;
     }
-    
-    auto* header = static_cast<LargeSlabHeader*>(header_ptr);
-    header->num_pages_ = num_pages;
-    header->prev = nullptr;
-    header->next_ = nullptr;
+    segment->get_page_desc(slab_ptr)->num_pages = num_pages;
 
-    void* user_ptr = static_cast<char*>(header_ptr) + sizeof(LargeSlabHeader);
-    
-    return user_ptr;
+    return slab_ptr;
+}
+
+void* ThreadHeap::allocate_medium_slab(size_t class_id) {
+    const auto& config = SlabConfig::get_instance();
+    const uint16_t num_pages = config.get_medium_class_pages(class_id);
+
+    MediumSpanCache& cache = medium_caches_[class_id];
+    if (cache.head != nullptr) {
+        MediumSpanNode* node = cache.head;
+        cache.head = node->next;
+        cache.count--;
+
+        MappedSegment* segment = MappedSegment::get_segment(node);
+        PageDescriptor* desc = segment->get_page_desc(node);
+        assert(desc->status == PageStatus::CACHED_SLAB && desc->num_pages == num_pages);
+        desc->status = PageStatus::LARGE_SLAB;
+        return node;
+    }
+
+    void* slab_ptr = allocate_large_slab(num_pages);
+    if (slab_ptr != nullptr) {
+        HeapCounters::add(stats_.medium[class_id].slabs, 1);
+    }
+    return slab_ptr;
 }
 
 SmallSlabHeader* ThreadHeap::allocate_small_slab(size_t class_id) {
@@ -260,6 +880,7 @@ SmallSlabHeader* ThreadHeap::allocate_small_slab(size_t class_id) {
         return nullptr;
     }
     
+    SlowPathTimer timer(stats_, SlowPath::SMALL_SLAB_INIT);
     MappedSegment* segment = MappedSegment::get_segment(slab_ptr);
     SmallSlabHeader* slab_header = new (slab_ptr) SmallSlabHeader(class_id);
 
@@ -269,12 +890,16 @@ SmallSlabHeader* ThreadHeap::allocate_small_slab(size_t class_id) {
         );
         desc->status = PageStatus::SMALL_SLAB;
         desc->slab_ptr = slab_header;
+        desc->sampled = 0;
     }
 
+    HeapCounters::add(stats_.small[class_id].slabs, 1);
+    MY_SDT_PROBE3(my_malloc, slab_create, slab_header, class_id, num_pages);
     return slab_header;
 }
 
 void* ThreadHeap::split_slab(LargeSlabHeader* slab_to_split, uint16_t required_pages) {
+    SlowPathTimer timer(stats_, SlowPath::SPAN_SPLIT);
     uint16_t total_pages = slab_to_split->num_pages_;
     
     uint16_t remaining_pages = total_pages - required_pages;
@@ -320,7 +945,24 @@ void* ThreadHeap::acquire_pages(uint16_t num_pages) {
         }
     }
 
-    MappedSegment* new_seg = MappedSegment::create();
+    // freelist 中没有合适的 span 时，从当前 Segment 未触碰的尾部按需切出
+    if (active_segments_ != nullptr) {
+        void* carved = carve_pages(active_segments_, num_pages);
+        if (carved != nullptr) {
+            return carved;
+        }
+        // 当前 Segment 的尾部不够用了，把剩余部分交给 freelist，之后只在新 Segment 上推进
+        retire_frontier(active_segments_);
+    }
+
+    // 普通 Segment 只使用与其等大的大页，1GB 大页只服务 Huge 对象
+    const bool try_hugetlb = MappedSegment::get_hugetlb_page_size() == SEGMENT_SIZE
+        && AllocatorOptions::get_instance().hugetlb_mode.load(std::memory_order_relaxed) == HugeTlbMode::ALL_SEGMENTS;
+    MappedSegment* new_seg;
+    {
+        SlowPathTimer timer(stats_, SlowPath::SEGMENT_CREATE);
+        new_seg = MappedSegment::create(SEGMENT_SIZE, try_hugetlb);
+    }
     if (new_seg == nullptr) {
         return nullptr;
     }
@@ -334,22 +976,33 @@ void* ThreadHeap::acquire_pages(uint16_t num_pages) {
         active_segments_->list_node.prev = new_seg;
     }
     active_segments_ = new_seg;
+    HeapCounters::add(stats_.segments, 1);
 
-    const size_t metadata_pages = (sizeof(MappedSegment) + PAGE_SIZE - 1) / PAGE_SIZE;
-    void* slab_start_ptr = reinterpret_cast<char*>(new_seg) + metadata_pages * PAGE_SIZE;
-    const uint16_t available_pages = (SEGMENT_SIZE / PAGE_SIZE) - metadata_pages;
-    
-    LargeSlabHeader* large_slab = initialize_as_free_slab(slab_start_ptr, available_pages);
+    return carve_pages(new_seg, num_pages);
+}
 
-    void* ret_slab = split_slab(large_slab, num_pages);
-    
-    if (ret_slab == nullptr) {
-        active_segments_ = new_seg->list_node.next;
-        MappedSegment::destroy(new_seg);
+void* ThreadHeap::carve_pages(MappedSegment* segment, uint16_t num_pages) {
+    const size_t total_pages = SEGMENT_SIZE / PAGE_SIZE;
+    if (segment->next_free_page_idx_ + num_pages > total_pages) {
         return nullptr;
     }
-    
-    return ret_slab;
+
+    // 只移动边界，页描述符由调用者在真正使用这些页时写入
+    void* slab_ptr = reinterpret_cast<char*>(segment) + segment->next_free_page_idx_ * PAGE_SIZE;
+    segment->next_free_page_idx_ = static_cast<uint16_t>(segment->next_free_page_idx_ + num_pages);
+    return slab_ptr;
+}
+
+void ThreadHeap::retire_frontier(MappedSegment* segment) {
+    const size_t total_pages = SEGMENT_SIZE / PAGE_SIZE;
+    const uint16_t remaining_pages = static_cast<uint16_t>(total_pages - segment->next_free_page_idx_);
+    if (remaining_pages == 0) {
+        return;
+    }
+
+    void* tail_ptr = reinterpret_cast<char*>(segment) + segment->next_free_page_idx_ * PAGE_SIZE;
+    segment->next_free_page_idx_ = static_cast<uint16_t>(total_pages);
+    prepend_to_freelist(initialize_as_free_slab(tail_ptr, remaining_pages));
 }
 
 void ThreadHeap::prepend_to_freelist(LargeSlabHeader* node_to_add) {
@@ -390,13 +1043,15 @@ LargeSlabHeader* ThreadHeap::initialize_as_free_slab(void* slab_ptr, uint16_t nu
 }
 
 void ThreadHeap::release_slab(void* slab_ptr, uint16_t num_pages) {
+    SlowPathTimer timer(stats_, SlowPath::SPAN_RELEASE);
+    MY_SDT_PROBE2(my_malloc, slab_release, slab_ptr, num_pages);
     MappedSegment* segment = MappedSegment::get_segment(slab_ptr);
     const size_t segment_start_addr = reinterpret_cast<size_t>(segment);
-    const size_t segment_end_addr = segment_start_addr + SEGMENT_SIZE;
+    const size_t frontier_addr = segment_start_addr + segment->next_free_page_idx_ * PAGE_SIZE;
     const size_t metadata_end_addr = segment_start_addr + (sizeof(MappedSegment) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
 
     void* next_page_ptr = static_cast<char*>(slab_ptr) + num_pages * PAGE_SIZE;
-    if (reinterpret_cast<size_t>(next_page_ptr) < segment_end_addr) {
+    if (reinterpret_cast<size_t>(next_page_ptr) < frontier_addr) {
         PageDescriptor* next_desc = segment->get_page_desc(next_page_ptr);
         if (next_desc->status == PageStatus::FREE) {
             auto* next_slab_header = static_cast<LargeSlabHeader*>(next_desc->slab_ptr);
@@ -416,6 +1071,19 @@ void ThreadHeap::release_slab(void* slab_ptr, uint16_t num_pages) {
         }
     }
 
+    // 紧挨着当前 Segment 的边界：直接退回边界，而不是形成一个空闲 span
+    const size_t slab_end_addr = reinterpret_cast<size_t>(slab_ptr) + num_pages * PAGE_SIZE;
+    if (segment == active_segments_ && slab_end_addr == frontier_addr) {
+        for (uint16_t i = 0; i < num_pages; ++i) {
+            PageDescriptor* desc = segment->get_page_desc(static_cast<char*>(slab_ptr) + i * PAGE_SIZE);
+            desc->status = PageStatus::FREE;
+            desc->num_pages = 0;
+            desc->slab_ptr = nullptr;
+        }
+        segment->next_free_page_idx_ = static_cast<uint16_t>((reinterpret_cast<size_t>(slab_ptr) - segment_start_addr) / PAGE_SIZE);
+        return;
+    }
+
     LargeSlabHeader* final_slab = initialize_as_free_slab(slab_ptr, num_pages);
     prepend_to_freelist(final_slab);
 }
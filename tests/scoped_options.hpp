@@ -0,0 +1,35 @@
+// tests/scoped_options.hpp
+#ifndef MY_MALLOC_TESTS_SCOPED_OPTIONS_HPP
+#define MY_MALLOC_TESTS_SCOPED_OPTIONS_HPP
+
+#include <cstddef>
+
+#include <my_malloc/internal/AllocatorOptions.hpp>
+
+namespace my_malloc {
+
+// Sets medium_cache_depth for the lifetime of the object and puts the
+// previous value back on destruction. Fixtures that check how medium
+// spans return to the freelists hold one with a depth of 0, so freed
+// spans are not kept in the span cache.
+class ScopedMediumCacheDepth {
+public:
+    explicit ScopedMediumCacheDepth(size_t depth)
+        : saved_(AllocatorOptions::get_instance().medium_cache_depth.load()) {
+        AllocatorOptions::get_instance().medium_cache_depth = depth;
+    }
+
+    ~ScopedMediumCacheDepth() {
+        AllocatorOptions::get_instance().medium_cache_depth = saved_;
+    }
+
+    ScopedMediumCacheDepth(const ScopedMediumCacheDepth&) = delete;
+    ScopedMediumCacheDepth& operator=(const ScopedMediumCacheDepth&) = delete;
+
+private:
+    size_t saved_;
+};
+
+} // namespace my_malloc
+
+#endif // MY_MALLOC_TESTS_SCOPED_OPTIONS_HPP
@@ -43,14 +43,42 @@ TEST_F(AcquireSlabTest, CreateNewSegmentWhenFreeListIsEmpty) {
     ASSERT_NE(seg1, nullptr);
     EXPECT_EQ(MappedSegment::get_segment(slab10_header), seg1);
 
-    // 2. freelist 中应该有一个大的剩余块
+    // 2. 剩余部分留在分配边界之后，不进入 freelist
     const size_t metadata_pages = (sizeof(MappedSegment) + PAGE_SIZE - 1) / PAGE_SIZE;
     const uint16_t available_pages = (SEGMENT_SIZE / PAGE_SIZE) - metadata_pages;
     const uint16_t remaining_pages = available_pages - 10;
     
-    LargeSlabHeader* remainder = heap_->get_freelist_head(remaining_pages);
-    ASSERT_NE(remainder, nullptr);
-    EXPECT_EQ(remainder->num_pages_, remaining_pages);
+    EXPECT_EQ(heap_->get_freelist_head(remaining_pages), nullptr);
+    EXPECT_EQ(seg1->next_free_page_idx_, metadata_pages + 10);
+}
+
+// ===================================================================================
+// 测试 4: 当前 Segment 的尾部不够用时，剩余部分进入 freelist，再创建新 Segment
+// ===================================================================================
+TEST_F(AcquireSlabTest, ExhaustedFrontierIsRetiredToFreeList) {
+    const size_t metadata_pages = (sizeof(MappedSegment) + PAGE_SIZE - 1) / PAGE_SIZE;
+    const uint16_t available_pages = (SEGMENT_SIZE / PAGE_SIZE) - metadata_pages;
+
+    void* first = heap_->test_acquire_pages(400);
+    ASSERT_NE(first, nullptr);
+    MappedSegment* seg1 = heap_->get_active_segments();
+
+    // 剩余 available_pages - 400 页放不下 200 页
+    void* second = heap_->test_acquire_pages(200);
+    ASSERT_NE(second, nullptr);
+    MappedSegment* seg2 = heap_->get_active_segments();
+    EXPECT_NE(seg1, seg2);
+    EXPECT_EQ(MappedSegment::get_segment(second), seg2);
+
+    const uint16_t tail_pages = available_pages - 400;
+    LargeSlabHeader* tail = heap_->get_freelist_head(tail_pages);
+    ASSERT_NE(tail, nullptr);
+    EXPECT_EQ(tail->num_pages_, tail_pages);
+    EXPECT_EQ(seg1->next_free_page_idx_, SEGMENT_SIZE / PAGE_SIZE);
+
+    // 之后能放进旧尾部的请求优先复用它
+    void* third = heap_->test_acquire_pages(tail_pages);
+    EXPECT_EQ(third, static_cast<void*>(tail));
 }
 
 
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocTrace.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace my_malloc {
+
+class AllocTraceTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+    AllocTrace& trace_ = AllocTrace::get_instance();
+    std::string path_;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+        char path[] = "/tmp/my_malloc_trace_XXXXXX";
+        const int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        path_ = path;
+    }
+
+    void TearDown() override {
+        if (AllocTrace::is_recording()) {
+            trace_.stop();
+        }
+        delete heap_;
+        unlink(path_.c_str());
+    }
+
+    std::vector<TraceRecord> read_records() {
+        std::vector<TraceRecord> records;
+        FILE* in = fopen(path_.c_str(), "rb");
+        EXPECT_NE(in, nullptr);
+        TraceFileHeader header{};
+        EXPECT_EQ(fread(&header, sizeof(header), 1, in), 1u);
+        EXPECT_EQ(header.magic, TRACE_MAGIC);
+        EXPECT_EQ(header.record_size, sizeof(TraceRecord));
+        TraceRecord rec;
+        while (fread(&rec, sizeof(rec), 1, in) == 1) {
+            records.push_back(rec);
+        }
+        fclose(in);
+        return records;
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 分配与释放按顺序写入文件，时间戳单调
+// ===================================================================================
+TEST_F(AllocTraceTest, RecordsAllocationsAndFrees) {
+    ASSERT_TRUE(trace_.start(path_.c_str()));
+    EXPECT_FALSE(trace_.start(path_.c_str()));
+
+    void* small = heap_->allocate(100);
+    void* medium = heap_->allocate(MAX_SMALL_OBJECT_SIZE + PAGE_SIZE);
+    heap_->free(small);
+    heap_->free(medium);
+    ASSERT_TRUE(trace_.stop());
+    EXPECT_FALSE(trace_.stop());
+
+    const std::vector<TraceRecord> records = read_records();
+    ASSERT_EQ(records.size(), 4u);
+    EXPECT_EQ(records[0].op, TraceOp::ALLOC);
+    EXPECT_EQ(records[0].address, reinterpret_cast<uintptr_t>(small));
+    EXPECT_EQ(records[0].size, 100u);
+    EXPECT_EQ(records[1].size, MAX_SMALL_OBJECT_SIZE + PAGE_SIZE);
+    EXPECT_EQ(records[2].op, TraceOp::FREE);
+    EXPECT_EQ(records[2].address, reinterpret_cast<uintptr_t>(small));
+    EXPECT_EQ(records[3].address, reinterpret_cast<uintptr_t>(medium));
+    for (size_t i = 1; i < records.size(); ++i) {
+        EXPECT_LE(records[i - 1].timestamp_ns, records[i].timestamp_ns);
+        EXPECT_EQ(records[i].thread_id, records[0].thread_id);
+    }
+}
+
+// ===================================================================================
+// 测试用例 2: 停止录制后不再追加记录
+// ===================================================================================
+TEST_F(AllocTraceTest, IdleWhenNotRecording) {
+    ASSERT_TRUE(trace_.start(path_.c_str()));
+    heap_->free(heap_->allocate(64));
+    ASSERT_TRUE(trace_.stop());
+
+    heap_->free(heap_->allocate(64));
+    EXPECT_EQ(read_records().size(), 2u);
+}
+
+// ===================================================================================
+// 测试用例 3: ring 写满时自动落盘，记录不丢失
+// ===================================================================================
+TEST_F(AllocTraceTest, FullRingIsFlushed) {
+    const uint64_t dropped = trace_.get_dropped_records();
+    ASSERT_TRUE(trace_.start(path_.c_str()));
+
+    const size_t rounds = TRACE_RING_RECORDS + 100;
+    for (size_t i = 0; i < rounds; ++i) {
+        heap_->free(heap_->allocate(32));
+    }
+    ASSERT_TRUE(trace_.stop());
+
+    const std::vector<TraceRecord> records = read_records();
+    ASSERT_EQ(records.size(), 2 * rounds);
+    for (size_t i = 0; i < records.size(); ++i) {
+        ASSERT_EQ(records[i].op, i % 2 == 0 ? TraceOp::ALLOC : TraceOp::FREE);
+    }
+    EXPECT_EQ(trace_.get_dropped_records(), dropped);
+}
+
+// ===================================================================================
+// 测试用例 4: 每个线程有自己的编号，退出后 ring 被复用
+// ===================================================================================
+TEST_F(AllocTraceTest, ThreadsGetOwnRings) {
+    ASSERT_TRUE(trace_.start(path_.c_str()));
+    heap_->free(heap_->allocate(16));
+
+    auto worker = [] {
+        ThreadHeap heap;
+        heap.free(heap.allocate(48));
+    };
+    std::thread(worker).join();
+
+    size_t rings_before = 0;
+    for (TraceRing* ring = trace_.rings_; ring != nullptr; ring = ring->next) {
+        rings_before++;
+    }
+    std::thread(worker).join();
+    size_t rings_after = 0;
+    for (TraceRing* ring = trace_.rings_; ring != nullptr; ring = ring->next) {
+        rings_after++;
+    }
+    EXPECT_EQ(rings_after, rings_before);
+    ASSERT_TRUE(trace_.stop());
+
+    const std::vector<TraceRecord> records = read_records();
+    ASSERT_EQ(records.size(), 6u);
+    std::vector<uint32_t> ids;
+    for (const TraceRecord& rec : records) {
+        if (std::find(ids.begin(), ids.end(), rec.thread_id) == ids.end()) {
+            ids.push_back(rec.thread_id);
+        }
+    }
+    EXPECT_EQ(ids.size(), 3u);
+}
+
+} // namespace my_malloc
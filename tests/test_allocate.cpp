@@ -10,7 +10,6 @@ namespace my_malloc {
 class AllocateTest : public ::testing::Test {
 protected:
     ThreadHeap* heap_ = nullptr;
-    const size_t header_size = sizeof(LargeSlabHeader);
 
     void SetUp() override {
         heap_ = new ThreadHeap();
@@ -18,19 +17,6 @@ protected:
     void TearDown() override {
         delete heap_;
     }
-
-    // 辅助函数：从用户指针反向计算头部指针
-    static void* get_header_from_user_ptr(void* user_ptr) {
-        if (!user_ptr) return nullptr;
-        // Huge objects have no header, user_ptr is inside the MappedSegment header space
-        // A bit of a hack to distinguish, a better way would be a magic number or type field.
-        // For now, let's assume if it's not a standard segment, it might be huge.
-        auto* seg = MappedSegment::get_segment(user_ptr);
-        if (seg->page_descriptors_[0].status == PageStatus::HUGE_SLAB) {
-            return seg; // For huge objects, the "header" is the segment itself
-        }
-        return static_cast<char*>(user_ptr) - sizeof(LargeSlabHeader);
-    }
 };
 
 // ===================================================================================
@@ -41,29 +27,48 @@ TEST_F(AllocateTest, AllocateAndVerifyMultiPageLargeObject) {
     void* user_ptr = heap_->allocate(user_size);
     ASSERT_NE(user_ptr, nullptr);
 
-    // 1. 获取头部信息
-    void* header_ptr = get_header_from_user_ptr(user_ptr);
-    const size_t total_alloc_size = user_size + header_size;
-    const uint16_t expected_pages = (total_alloc_size + PAGE_SIZE - 1) / PAGE_SIZE;
+    // 1. 大对象没有内嵌头部，用户指针按页对齐；页数向上取整到所在的中等对象档位
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(user_ptr) % PAGE_SIZE, 0u);
+    const auto& config = SlabConfig::get_instance();
+    const uint16_t expected_pages = config.get_medium_class_pages(
+        config.get_medium_class_index((user_size + PAGE_SIZE - 1) / PAGE_SIZE));
 
-    // 2. 验证嵌入的头部元数据
-    auto* header = static_cast<LargeSlabHeader*>(header_ptr);
-    EXPECT_EQ(header->num_pages_, expected_pages);
+    // 2. 验证首页 PageDescriptor 中记录的页数
+    MappedSegment* seg = MappedSegment::get_segment(user_ptr);
+    EXPECT_EQ(seg->get_page_desc(user_ptr)->num_pages, expected_pages);
 
     // 3. 验证每一页的 PageDescriptor
-    MappedSegment* seg = MappedSegment::get_segment(header_ptr);
     for (uint16_t i = 0; i < expected_pages; ++i) {
         SCOPED_TRACE("Verifying page " + std::to_string(i));
-        void* current_page_ptr = static_cast<char*>(header_ptr) + i * PAGE_SIZE;
+        void* current_page_ptr = static_cast<char*>(user_ptr) + i * PAGE_SIZE;
         PageDescriptor* desc = seg->get_page_desc(current_page_ptr);
         
         EXPECT_EQ(desc->status, PageStatus::LARGE_SLAB);
-        EXPECT_EQ(desc->slab_ptr, header_ptr);
+        EXPECT_EQ(desc->slab_ptr, user_ptr);
     }
+    EXPECT_EQ(ThreadHeap::get_usable_size(user_ptr), expected_pages * PAGE_SIZE);
     
     heap_->free(user_ptr);
 }
 
+// ===================================================================================
+// 测试用例 2b: 页整数倍的请求不产生额外的页
+// ===================================================================================
+TEST_F(AllocateTest, PageMultipleLargeObjectHasNoOverhead) {
+    const size_t user_size = 512 * 1024;
+    void* user_ptr = heap_->allocate(user_size);
+    ASSERT_NE(user_ptr, nullptr);
+
+    MappedSegment* seg = MappedSegment::get_segment(user_ptr);
+    EXPECT_EQ(seg->get_page_desc(user_ptr)->num_pages, user_size / PAGE_SIZE);
+    EXPECT_EQ(ThreadHeap::get_usable_size(user_ptr), user_size);
+
+    // 紧随其后的下一页不属于这个对象
+    PageDescriptor* next_desc = seg->get_page_desc(static_cast<char*>(user_ptr) + user_size);
+    EXPECT_NE(next_desc->slab_ptr, user_ptr);
+
+    heap_->free(user_ptr);
+}
 
 // ===================================================================================
 // 测试用例 3: 分配占满 Segment 的对象以触发新 Segment
@@ -73,7 +78,7 @@ TEST_F(AllocateTest, AllocationSpansAcrossSegments) {
     const size_t available_pages = (SEGMENT_SIZE / PAGE_SIZE) - metadata_pages;
     
     // 请求一个几乎占满整个 Segment 可用空间的用户区
-    const size_t user_size1 = available_pages * PAGE_SIZE - header_size;
+    const size_t user_size1 = available_pages * PAGE_SIZE;
     
     void* user_ptr1 = heap_->allocate(user_size1);
     ASSERT_NE(user_ptr1, nullptr);
@@ -118,10 +123,8 @@ TEST_F(AllocateTest, AllocateObjectAtHugeThreshold) {
     const size_t header_size_seg = sizeof(MappedSegment);
     const size_t metadata_pages = (header_size_seg + PAGE_SIZE - 1) / PAGE_SIZE;
 
-    const size_t header_size_large = sizeof(LargeSlabHeader);
-    const size_t large_metadata_pages = (header_size_large + PAGE_SIZE - 1) / PAGE_SIZE;  
-
-    const size_t available_pages = (SEGMENT_SIZE / PAGE_SIZE) - metadata_pages - large_metadata_pages;
+    // 大对象不再占用额外的头部页，整个可用区间都能作为一个大对象
+    const size_t available_pages = (SEGMENT_SIZE / PAGE_SIZE) - metadata_pages;
     const size_t huge_object_threshold = available_pages * PAGE_SIZE;
     
     void* user_ptr = heap_->allocate(huge_object_threshold);
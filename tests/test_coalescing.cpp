@@ -5,6 +5,8 @@
 #include "my_malloc/internal/AllocSlab.hpp"
 #include "my_malloc/internal/SlabConfig.hpp"
 
+#include "scoped_options.hpp"
+
 namespace my_malloc {
 
 class ThreadHeapFriend : public ThreadHeap {
@@ -19,22 +21,15 @@ public:
     // 辅助函数，用于获取一个 user_ptr 对应的 slab 大小（页数）
     uint16_t get_slab_pages(void* user_ptr) {
         if (!user_ptr) return 0;
-        
-        // --- 【修复点】: 加上  命名空间前缀 ---
-        void* header_ptr = static_cast<char*>(user_ptr) - sizeof(LargeSlabHeader);
-        auto* header = static_cast<LargeSlabHeader*>(header_ptr);
-        // --- 【修复结束】 ---
-        
-        return header->num_pages_;
+        return MappedSegment::get_segment(user_ptr)->get_page_desc(user_ptr)->num_pages;
     }
 };
 
 class CoalescingTest : public ::testing::Test {
 protected:
+    // 这些用例验证的是归还到 freelist 的路径，关闭中等对象的 span 缓存
+    ScopedMediumCacheDepth medium_cache_depth_{0};
     ThreadHeapFriend* heap_ = nullptr;
-    
-    // --- 【修复点】: 同样加上  ---
-    const size_t header_size = sizeof(LargeSlabHeader);
 
     void SetUp() override {
         heap_ = new ThreadHeapFriend();
@@ -59,8 +54,6 @@ protected:
 // ===================================================================================
 TEST_F(CoalescingTest, NoCoalescingWhenNeighborsAreAllocated) {
     const size_t user_size = MAX_SMALL_OBJECT_SIZE + 1;
-    const size_t total_alloc_size = user_size + header_size;
-    const uint16_t expected_pages = (total_alloc_size + PAGE_SIZE - 1) / PAGE_SIZE;
     
     void* user_ptr_a = heap_->allocate(user_size);
     void* user_ptr_b = heap_->allocate(user_size);
@@ -69,6 +62,7 @@ TEST_F(CoalescingTest, NoCoalescingWhenNeighborsAreAllocated) {
     ASSERT_NE(user_ptr_a, nullptr);
     ASSERT_NE(user_ptr_b, nullptr);
     ASSERT_NE(user_ptr_c, nullptr);
+    const uint16_t expected_pages = heap_->get_slab_pages(user_ptr_b);
     
     heap_->free(user_ptr_b);
 
@@ -88,20 +82,25 @@ TEST_F(CoalescingTest, CoalesceWithNextBlock) {
     void* user_ptr_a = allocate_large(10 * PAGE_SIZE);
     void* user_ptr_b = allocate_large(20 * PAGE_SIZE);
     void* user_ptr_c = allocate_large(30 * PAGE_SIZE);
+    // D 挡在 C 与 Segment 的分配边界之间，使 C 释放后形成空闲 span
+    void* user_ptr_d = allocate_large(10 * PAGE_SIZE);
+    ASSERT_NE(user_ptr_d, nullptr);
     
     uint16_t pages_a = heap_->get_slab_pages(user_ptr_a);
     uint16_t pages_b = heap_->get_slab_pages(user_ptr_b);
+    uint16_t pages_c = heap_->get_slab_pages(user_ptr_c);
     
     heap_->free(user_ptr_c);
 
     heap_->free(user_ptr_b);
 
-    ASSERT_NE(heap_->get_freelist_head(349 + pages_b), nullptr);
+    ASSERT_NE(heap_->get_freelist_head(pages_c + pages_b), nullptr);
 
     heap_->free(user_ptr_a);
 
-    ASSERT_NE(heap_->get_freelist_head(349 + pages_b + pages_a), nullptr);
+    ASSERT_NE(heap_->get_freelist_head(pages_c + pages_b + pages_a), nullptr);
 
+    heap_->free(user_ptr_d);
 }
 
 // in tests/test_coalescing.cpp
@@ -151,8 +150,7 @@ TEST_F(CoalescingTest, CoalesceWithPreviousBlock) {
     EXPECT_EQ(merged_slab->num_pages_, merged_pages);
 
     // d. 【关键】验证合并后的块头部是 A 的头部
-    void* header_ptr_a = static_cast<char*>(user_ptr_a) - header_size;
-    EXPECT_EQ(static_cast<void*>(merged_slab), header_ptr_a);
+    EXPECT_EQ(static_cast<void*>(merged_slab), user_ptr_a);
     
     // 4. 【清理】: 释放最后的 C
     heap_->free(user_ptr_c);
@@ -164,14 +162,18 @@ TEST_F(CoalescingTest, CoalesceWithPreviousBlock) {
 // 场景 4: 双向合并 (最终修正版)
 // ===================================================================================
 TEST_F(CoalescingTest, CoalesceWithBothNeighbors) {
-    // 1. 准备布局: [Allocated A | Allocated B | Allocated C]
-    //    由于是从一个大的空闲块中连续分裂出来的，它们在物理上是连续的。
+    // 1. 准备布局: [Allocated A | Allocated B | Allocated C | Allocated D]
+    //    由于是从 Segment 的分配边界上连续切出来的，它们在物理上是连续的。
+    //    D 把 C 与分配边界隔开。
     void* user_ptr_a = allocate_large(10 * PAGE_SIZE);
     void* user_ptr_b = allocate_large(20 * PAGE_SIZE);
-    void* user_ptr_c = allocate_large(30 * PAGE_SIZE);
+    // C 取一个与 B 不同的中等对象档位，便于区分各自的 freelist
+    void* user_ptr_c = allocate_large(50 * PAGE_SIZE);
+    void* user_ptr_d = allocate_large(10 * PAGE_SIZE);
     ASSERT_NE(user_ptr_a, nullptr);
     ASSERT_NE(user_ptr_b, nullptr);
     ASSERT_NE(user_ptr_c, nullptr);
+    ASSERT_NE(user_ptr_d, nullptr);
 
     // 获取它们的真实页数
     uint16_t pages_a = heap_->get_slab_pages(user_ptr_a);
@@ -184,7 +186,7 @@ TEST_F(CoalescingTest, CoalesceWithBothNeighbors) {
     
     // 3. 验证初始状态：freelist 中有 A 和 C
     ASSERT_NE(heap_->get_freelist_head(pages_a), nullptr);
-    ASSERT_NE(heap_->get_freelist_head(509 - pages_a - pages_b), nullptr);
+    ASSERT_NE(heap_->get_freelist_head(pages_c), nullptr);
     expect_freelist_is_empty(pages_b);
 
     // 4. 【执行操作】: 释放 B。
@@ -199,15 +201,42 @@ TEST_F(CoalescingTest, CoalesceWithBothNeighbors) {
     expect_freelist_is_empty(pages_c);
 
     // b. 应该出现一个合并了三者大小的新空闲块
-    LargeSlabHeader* merged_slab = heap_->get_freelist_head(509);
+    const uint16_t merged_pages = pages_a + pages_b + pages_c;
+    LargeSlabHeader* merged_slab = heap_->get_freelist_head(merged_pages);
     ASSERT_NE(merged_slab, nullptr) << "Blocks A, B, and C were not merged correctly.";
     
     // c. 验证合并后的块大小
-    EXPECT_EQ(merged_slab->num_pages_, 509);
+    EXPECT_EQ(merged_slab->num_pages_, merged_pages);
 
     // d. 【关键】验证合并后的块头部是 A 的头部
-    void* header_ptr_a = static_cast<char*>(user_ptr_a) - header_size;
-    EXPECT_EQ(static_cast<void*>(merged_slab), header_ptr_a);
+    EXPECT_EQ(static_cast<void*>(merged_slab), user_ptr_a);
+
+    heap_->free(user_ptr_d);
+}
+
+// ===================================================================================
+// 场景 5: 与分配边界相邻的 span 释放后退回边界，而不是进入 freelist
+// ===================================================================================
+TEST_F(CoalescingTest, FreeAtFrontierRetractsFrontier) {
+    void* user_ptr_a = allocate_large(10 * PAGE_SIZE);
+    void* user_ptr_b = allocate_large(20 * PAGE_SIZE);
+    ASSERT_NE(user_ptr_a, nullptr);
+    ASSERT_NE(user_ptr_b, nullptr);
+
+    MappedSegment* seg = MappedSegment::get_segment(user_ptr_a);
+    const uint16_t pages_a = heap_->get_slab_pages(user_ptr_a);
+    const uint16_t pages_b = heap_->get_slab_pages(user_ptr_b);
+    const uint16_t metadata_pages = SEGMENT_METADATA_SIZE / PAGE_SIZE;
+    ASSERT_EQ(seg->next_free_page_idx_, metadata_pages + pages_a + pages_b);
+
+    heap_->free(user_ptr_b);
+    EXPECT_EQ(seg->next_free_page_idx_, metadata_pages + pages_a);
+    expect_freelist_is_empty(pages_b);
+    EXPECT_EQ(seg->get_page_desc(user_ptr_b)->slab_ptr, nullptr);
+
+    heap_->free(user_ptr_a);
+    EXPECT_EQ(seg->next_free_page_idx_, metadata_pages);
+    expect_freelist_is_empty(pages_a);
 }
 
 } // namespace my_malloc
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/Control.hpp>
+#include <my_malloc/internal/SlabConfig.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace my_malloc {
+
+class ControlTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+    }
+
+    void TearDown() override {
+        delete heap_;
+
+        auto& options = AllocatorOptions::get_instance();
+        options.huge_cache_budget = DEFAULT_HUGE_CACHE_BUDGET;
+        options.huge_cache_decay_ms = DEFAULT_HUGE_CACHE_DECAY_MS;
+        options.hugetlb_mode = HugeTlbMode::OFF;
+        options.huge_layout = HugeLayout::INLINE;
+        options.medium_cache_depth = DEFAULT_MEDIUM_CACHE_DEPTH;
+        options.empty_slab_reserve = 0;
+    }
+
+    static uint64_t read(const char* name) {
+        uint64_t value = 0;
+        EXPECT_TRUE(ctl_read(name, value)) << name;
+        return value;
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: opt.* 按名字读写，支持枚举名和 k/m/g 后缀，非法值被拒绝
+// ===================================================================================
+TEST_F(ControlTest, OptionsReadAndWrite) {
+    auto& options = AllocatorOptions::get_instance();
+
+    EXPECT_TRUE(ctl_write("opt.huge_cache_budget", "64m"));
+    EXPECT_EQ(options.huge_cache_budget.load(), 64u * 1024 * 1024);
+    EXPECT_EQ(read("opt.huge_cache_budget"), 64u * 1024 * 1024);
+
+    EXPECT_TRUE(ctl_write("opt.huge_cache_decay_ms", uint64_t{250}));
+    EXPECT_EQ(options.huge_cache_decay_ms.load(), 250u);
+
+    EXPECT_TRUE(ctl_write("opt.huge_layout", "segment_aligned"));
+    EXPECT_EQ(options.huge_layout.load(), HugeLayout::SEGMENT_ALIGNED);
+    EXPECT_TRUE(ctl_write("opt.hugetlb_mode", "2"));
+    EXPECT_EQ(read("opt.hugetlb_mode"), static_cast<uint64_t>(HugeTlbMode::ALL_SEGMENTS));
+
+    EXPECT_FALSE(ctl_write("opt.hugetlb_mode", "sometimes"));
+    EXPECT_FALSE(ctl_write("opt.hugetlb_page_size", uint64_t{4096}));
+    EXPECT_FALSE(ctl_write("opt.medium_cache_depth", "12x"));
+    EXPECT_FALSE(ctl_write("opt.no_such_option", uint64_t{1}));
+    EXPECT_EQ(options.medium_cache_depth.load(), DEFAULT_MEDIUM_CACHE_DEPTH);
+
+    uint64_t value;
+    EXPECT_FALSE(ctl_read("opt.no_such_option", value));
+    EXPECT_FALSE(ctl_write("stats.live_bytes", uint64_t{0}));
+}
+
+// ===================================================================================
+// 测试用例 2: MY_MALLOC_CONF 语法：逐项应用，失败的项被跳过
+// ===================================================================================
+TEST_F(ControlTest, ApplyConfString) {
+    auto& options = AllocatorOptions::get_instance();
+
+    EXPECT_FALSE(options.apply_conf("medium_cache_depth:7,bogus:1,empty_slab_reserve:2,huge_layout:segment_aligned"));
+    EXPECT_EQ(options.medium_cache_depth.load(), 7u);
+    EXPECT_EQ(options.empty_slab_reserve.load(), 2u);
+    EXPECT_EQ(options.huge_layout.load(), HugeLayout::SEGMENT_ALIGNED);
+
+    EXPECT_TRUE(options.apply_conf("huge_cache_budget:1g"));
+    EXPECT_EQ(options.huge_cache_budget.load(), 1024u * 1024 * 1024);
+    EXPECT_TRUE(options.apply_conf(""));
+    EXPECT_FALSE(options.apply_conf("medium_cache_depth"));
+}
+
+// ===================================================================================
+// 测试用例 3: stats.* 读取快照，只有写 epoch 才刷新
+// ===================================================================================
+TEST_F(ControlTest, StatsFollowEpoch) {
+    const size_t class_id = SlabConfig::get_instance().get_size_class_index(96);
+    const std::string allocs = "stats.small." + std::to_string(class_id) + ".allocs";
+
+    ASSERT_TRUE(ctl_write("epoch", uint64_t{0}));
+    const uint64_t epoch = read("epoch");
+    const uint64_t before = read(allocs.c_str());
+
+    void* ptr = heap_->allocate(96);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(read(allocs.c_str()), before);
+
+    ASSERT_TRUE(ctl_write("epoch", uint64_t{0}));
+    EXPECT_EQ(read("epoch"), epoch + 1);
+    EXPECT_EQ(read(allocs.c_str()), before + 1);
+    EXPECT_GE(read("stats.heaps"), 1u);
+
+    uint64_t value;
+    EXPECT_FALSE(ctl_read("stats.small.100000.allocs", value));
+    EXPECT_FALSE(ctl_read("stats.small.0.nothing", value));
+
+    heap_->free(ptr);
+}
+
+// ===================================================================================
+// 测试用例 4: 列出的每个名字都能读到
+// ===================================================================================
+TEST_F(ControlTest, EveryListedNameIsReadable) {
+    std::vector<std::string> names;
+    ctl_for_each_name([](const char* name, void* arg) {
+        static_cast<std::vector<std::string>*>(arg)->push_back(name);
+    }, &names);
+
+    EXPECT_GT(names.size(), 100u);
+    for (const std::string& name : names) {
+        uint64_t value;
+        EXPECT_TRUE(ctl_read(name.c_str(), value)) << name;
+    }
+}
+
+// ===================================================================================
+// 测试用例 5: 空 slab 按预留数量保留并被复用，heap.purge 时归还
+// ===================================================================================
+TEST_F(ControlTest, EmptySlabReserveAndPurge) {
+    ASSERT_TRUE(ctl_write("opt.empty_slab_reserve", uint64_t{1}));
+    const size_t class_id = SlabConfig::get_instance().get_size_class_index(512);
+
+    void* first = heap_->allocate(512);
+    ASSERT_NE(first, nullptr);
+    const void* slab = MappedSegment::get_segment(first)->get_page_desc(first)->slab_ptr;
+    heap_->free(first);
+
+    // 空 slab 留在预留链表上，仍计入该类的 slab 数
+    EXPECT_EQ(heap_->slab_caches_[class_id].num_empty, 1u);
+    EXPECT_EQ(heap_->stats_.small[class_id].slabs.load(), 1u);
+
+    void* second = heap_->allocate(512);
+    EXPECT_EQ(MappedSegment::get_segment(second)->get_page_desc(second)->slab_ptr, slab);
+    EXPECT_EQ(heap_->slab_caches_[class_id].num_empty, 0u);
+    heap_->free(second);
+
+    void* medium = heap_->allocate(MAX_SMALL_OBJECT_SIZE + PAGE_SIZE);
+    ASSERT_NE(medium, nullptr);
+    heap_->free(medium);
+    const size_t medium_class = SlabConfig::get_instance().get_medium_class_index(
+        (MAX_SMALL_OBJECT_SIZE + PAGE_SIZE) / PAGE_SIZE);
+    EXPECT_EQ(heap_->medium_caches_[medium_class].count, 1u);
+
+    ASSERT_TRUE(ctl_write("heap.purge", uint64_t{1}));
+    EXPECT_EQ(heap_->slab_caches_[class_id].num_empty, 0u);
+    EXPECT_EQ(heap_->stats_.small[class_id].slabs.load(), 0u);
+    EXPECT_EQ(heap_->medium_caches_[medium_class].count, 0u);
+    EXPECT_EQ(heap_->stats_.medium[medium_class].slabs.load(), 0u);
+}
+
+// ===================================================================================
+// 测试用例 6: heap.purge 与线程退出并发时，不会清理正在析构的 heap
+// ===================================================================================
+TEST_F(ControlTest, PurgeWhileThreadsExit) {
+    ASSERT_TRUE(ctl_write("opt.empty_slab_reserve", uint64_t{1}));
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                // 每个线程用完即退出，留下预留的空 slab、缓存的 span 和 Huge 映射给 purge
+                std::thread([] {
+                    ThreadHeap heap;
+                    heap.free(heap.allocate(512));
+                    heap.free(heap.allocate(MAX_SMALL_OBJECT_SIZE + PAGE_SIZE));
+                    heap.free(heap.allocate(4 * SEGMENT_SIZE));
+                    heap.allocate(64);
+                }).join();
+            }
+        });
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_TRUE(ctl_write("heap.purge", uint64_t{1}));
+        std::this_thread::yield();
+    }
+    stop = true;
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace my_malloc
@@ -5,10 +5,14 @@
 #include <my_malloc/internal/MappedSegment.hpp>
 #include <my_malloc/internal/definitions.hpp>
 
+#include "scoped_options.hpp"
+
 namespace my_malloc {
 
 class FreeTest : public ::testing::Test {
 protected:
+    // 这些用例验证的是归还到 freelist 的路径，关闭中等对象的 span 缓存
+    ScopedMediumCacheDepth medium_cache_depth_{0};
     ThreadHeap* heap_ = nullptr;
 
     void SetUp() override {
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/HeapInspector.hpp>
+#include <my_malloc/internal/SlabConfig.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace my_malloc {
+
+class HeapInspectorTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+    }
+
+    void TearDown() override {
+        delete heap_;
+    }
+
+    static std::string render(const HeapSnapshot& snapshot, StatsFormat format) {
+        FILE* out = tmpfile();
+        EXPECT_NE(out, nullptr);
+        snapshot.write(fileno(out), format);
+
+        std::string text;
+        rewind(out);
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), out)) > 0) {
+            text.append(buf, n);
+        }
+        fclose(out);
+        return text;
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 每个 Segment 的页分类加起来正好覆盖全部页
+// ===================================================================================
+TEST_F(HeapInspectorTest, PageMixCoversSegment) {
+    void* small = heap_->allocate(64);
+    void* medium = heap_->allocate(MAX_SMALL_OBJECT_SIZE + PAGE_SIZE);
+    ASSERT_NE(small, nullptr);
+    ASSERT_NE(medium, nullptr);
+
+    HeapSnapshot snapshot;
+    ASSERT_TRUE(snapshot.capture(*heap_));
+    ASSERT_EQ(snapshot.get_num_segments(), 1u);
+
+    const SegmentSnapshot& seg = snapshot.get_segment(0);
+    EXPECT_EQ(seg.metadata_pages + seg.small_pages + seg.large_pages + seg.cached_pages +
+              seg.free_pages + seg.untouched_pages, SEGMENT_NUM_PAGES);
+    EXPECT_GT(seg.metadata_pages, 0);
+    EXPECT_GT(seg.small_pages, 0);
+    EXPECT_GT(seg.large_pages, 0);
+    EXPECT_EQ(seg.untouched_pages, SEGMENT_NUM_PAGES - seg.frontier);
+    EXPECT_EQ(seg.largest_free_span, seg.free_pages + seg.untouched_pages);
+    EXPECT_EQ(seg.heat_map[0], HEAT_METADATA);
+
+    heap_->free(small);
+    heap_->free(medium);
+}
+
+// ===================================================================================
+// 测试用例 2: 小对象 slab 的使用率与存活对象数一致
+// ===================================================================================
+TEST_F(HeapInspectorTest, ReportsSlabUtilization) {
+    const size_t class_id = SlabConfig::get_instance().get_size_class_index(128);
+    const size_t capacity = SlabConfig::get_instance().get_info(class_id).slab_capacity;
+    ASSERT_GE(capacity, 4u);
+
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < capacity / 2; ++i) {
+        ptrs.push_back(heap_->allocate(128));
+    }
+
+    HeapSnapshot snapshot;
+    ASSERT_TRUE(snapshot.capture(*heap_));
+    const SegmentSnapshot& seg = snapshot.get_segment(0);
+    ASSERT_EQ(seg.num_slabs, 1);
+
+    const SlabSnapshot& slab = seg.slabs[0];
+    EXPECT_EQ(slab.class_id, class_id);
+    EXPECT_EQ(slab.used, capacity / 2);
+    EXPECT_EQ(slab.capacity, capacity);
+    EXPECT_EQ(seg.heat_map[slab.first_page], static_cast<char>('0' + (capacity / 2) * 10 / capacity));
+
+    for (void* ptr : ptrs) {
+        heap_->free(ptr);
+    }
+}
+
+// ===================================================================================
+// 测试用例 3: 释放中间的 span 后，最大空闲段不跨过仍在使用的页
+// ===================================================================================
+TEST_F(HeapInspectorTest, LargestFreeSpanStopsAtLiveSpans) {
+    const size_t size = MAX_SMALL_OBJECT_SIZE + PAGE_SIZE;
+    void* first = heap_->allocate(size);
+    void* middle = heap_->allocate(size);
+    void* last = heap_->allocate(size);
+    ASSERT_NE(last, nullptr);
+    heap_->free(middle);
+
+    HeapSnapshot snapshot;
+    ASSERT_TRUE(snapshot.capture(*heap_));
+    const SegmentSnapshot& seg = snapshot.get_segment(0);
+    EXPECT_EQ(seg.largest_free_span, seg.untouched_pages);
+    EXPECT_GT(seg.free_pages + seg.cached_pages, 0);
+
+    heap_->free(first);
+    heap_->free(last);
+}
+
+// ===================================================================================
+// 测试用例 4: ASCII 与 JSON 两种热力图输出
+// ===================================================================================
+TEST_F(HeapInspectorTest, WritesAsciiAndJson) {
+    void* ptr = heap_->allocate(256);
+    ASSERT_NE(ptr, nullptr);
+
+    HeapSnapshot snapshot;
+    ASSERT_TRUE(snapshot.capture(*heap_));
+
+    const std::string text = render(snapshot, StatsFormat::TEXT);
+    EXPECT_NE(text.find("legend: "), std::string::npos);
+    EXPECT_NE(text.find("largest free span "), std::string::npos);
+    EXPECT_NE(text.find("    0 |M"), std::string::npos);
+
+    const std::string json = render(snapshot, StatsFormat::JSON);
+    EXPECT_EQ(json.rfind("{\"heap\": \"", 0), 0u);
+    EXPECT_NE(json.find("\"small_slabs\": [{\"first_page\": "), std::string::npos);
+    EXPECT_NE(json.find("\"heat_map\": [\"M"), std::string::npos);
+
+    int depth = 0;
+    for (char c : json) {
+        depth += (c == '{' || c == '[') - (c == '}' || c == ']');
+        ASSERT_GE(depth, 0);
+    }
+    EXPECT_EQ(depth, 0);
+
+    heap_->free(ptr);
+}
+
+// ===================================================================================
+// 测试用例 5: 非阻塞抓取遇到被占用的 heap 时直接失败
+// ===================================================================================
+TEST_F(HeapInspectorTest, NonBlockingCaptureSkipsBusyHeap) {
+    void* ptr = heap_->allocate(64);
+    ASSERT_NE(ptr, nullptr);
+
+    HeapSnapshot snapshot;
+    {
+        std::lock_guard<std::mutex> guard(heap_->lock_);
+        EXPECT_FALSE(snapshot.capture(*heap_, false));
+    }
+    EXPECT_EQ(snapshot.get_num_segments(), 0u);
+    EXPECT_TRUE(snapshot.capture(*heap_, false));
+    EXPECT_EQ(snapshot.get_num_segments(), 1u);
+
+    heap_->free(ptr);
+}
+
+} // namespace my_malloc
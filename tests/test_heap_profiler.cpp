@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/HeapProfiler.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace my_malloc {
+
+class HeapProfilerTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+    HeapProfiler& profiler_ = HeapProfiler::get_instance();
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+    }
+
+    void TearDown() override {
+        delete heap_;
+
+        auto& options = AllocatorOptions::get_instance();
+        options.profile_sample_interval = 0;
+        options.region_max_segments = DEFAULT_REGION_MAX_SEGMENTS;
+    }
+
+    // 间隔为 1 时，第一次分配只抽取间隔，之后每次分配都是样本
+    void sample_everything() {
+        AllocatorOptions::get_instance().profile_sample_interval = 1;
+        heap_->free(heap_->allocate(8));
+        ASSERT_TRUE(heap_->sampling_armed_);
+    }
+};
+
+__attribute__((noinline)) size_t capture_here(void** frames, void** caller) {
+    *caller = __builtin_return_address(0);
+    return HeapProfiler::capture_stack(frames, PROFILE_MAX_DEPTH, 0);
+}
+
+// ===================================================================================
+// 测试用例 1: 关闭采样时不记录样本，只在倒计时耗尽后重新读取选项
+// ===================================================================================
+TEST_F(HeapProfilerTest, DisabledSamplingRecordsNothing) {
+    const size_t before = profiler_.get_live_samples();
+
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 100; ++i) {
+        ptrs.push_back(heap_->allocate(1000));
+    }
+    EXPECT_EQ(profiler_.get_live_samples(), before);
+    EXPECT_FALSE(heap_->sampling_armed_);
+    EXPECT_EQ(heap_->bytes_until_sample_, PROFILE_RECHECK_BYTES - 99 * 1000);
+
+    for (void* ptr : ptrs) {
+        heap_->free(ptr);
+    }
+}
+
+// ===================================================================================
+// 测试用例 2: 样本随 free 注销，页描述符上的计数归零
+// ===================================================================================
+TEST_F(HeapProfilerTest, FreeRetiresSamples) {
+    sample_everything();
+    const size_t before = profiler_.get_live_samples();
+
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 10; ++i) {
+        ptrs.push_back(heap_->allocate(100));
+        ASSERT_NE(ptrs.back(), nullptr);
+    }
+    EXPECT_EQ(profiler_.get_live_samples(), before + 10);
+    EXPECT_NE(MappedSegment::get_segment(ptrs[0])->get_page_desc(ptrs[0])->sampled, 0);
+
+    for (void* ptr : ptrs) {
+        heap_->free(ptr);
+    }
+    EXPECT_EQ(profiler_.get_live_samples(), before);
+    EXPECT_EQ(MappedSegment::get_segment(ptrs[0])->get_page_desc(ptrs[0])->sampled, 0);
+}
+
+// ===================================================================================
+// 测试用例 3: 帧指针回溯得到调用者的返回地址
+// ===================================================================================
+TEST_F(HeapProfilerTest, CaptureStackFollowsFramePointers) {
+    void* frames[PROFILE_MAX_DEPTH];
+    void* caller = nullptr;
+    const size_t depth = capture_here(frames, &caller);
+
+    // 优化后的 capture_here 可能直接尾调用，所以只要求调用者出现在栈中
+    ASSERT_GE(depth, 1u);
+    bool found = false;
+    for (size_t i = 0; i < depth && i < 2; ++i) {
+        found = found || frames[i] == caller;
+    }
+    EXPECT_TRUE(found);
+}
+
+// ===================================================================================
+// 测试用例 4: 输出 pprof 可读的 heap_v2 文本格式
+// ===================================================================================
+TEST_F(HeapProfilerTest, WritesLegacyHeapProfile) {
+    sample_everything();
+    void* ptr = heap_->allocate(4096);
+    ASSERT_NE(ptr, nullptr);
+
+    FILE* out = tmpfile();
+    ASSERT_NE(out, nullptr);
+    ASSERT_TRUE(profiler_.write_profile(fileno(out)));
+
+    std::string text;
+    rewind(out);
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), out)) > 0) {
+        text.append(buf, n);
+    }
+    fclose(out);
+
+    EXPECT_EQ(text.rfind("heap profile: ", 0), 0u);
+    EXPECT_NE(text.find("] @ heap_v2/1\n"), std::string::npos);
+    EXPECT_NE(text.find(": 4096 ["), std::string::npos);
+    EXPECT_NE(text.find("] @ 0x"), std::string::npos);
+    EXPECT_NE(text.find("\nMAPPED_LIBRARIES:\n"), std::string::npos);
+
+    heap_->free(ptr);
+}
+
+// ===================================================================================
+// 测试用例 5: Huge 对象原地 realloc 搬迁后样本跟随新地址
+// ===================================================================================
+TEST_F(HeapProfilerTest, HugeSampleFollowsRealloc) {
+    AllocatorOptions::get_instance().region_max_segments = 0;
+    sample_everything();
+    const size_t before = profiler_.get_live_samples();
+
+    const size_t size = 4 * 1024 * 1024;
+    void* ptr = heap_->allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    MappedSegment* seg = MappedSegment::get_owning_segment(ptr);
+    EXPECT_EQ(seg->page_descriptors_[0].sampled, 1);
+
+    // 在映射末尾放一个页，迫使增长时搬迁
+    char* seg_end = reinterpret_cast<char*>(seg) + seg->total_size_;
+    void* blocker = mmap(seg_end, PAGE_SIZE, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(blocker, MAP_FAILED);
+
+    void* grown = heap_->reallocate(ptr, 5 * size);
+    ASSERT_NE(grown, nullptr);
+    EXPECT_NE(grown, ptr);
+    EXPECT_EQ(profiler_.get_live_samples(), before + 1);
+
+    heap_->free(grown);
+    EXPECT_EQ(profiler_.get_live_samples(), before);
+    munmap(blocker, PAGE_SIZE);
+}
+
+// ===================================================================================
+// 测试用例 6: Huge 对象原地缩小后样本与桶的 inuse_bytes 随新大小更新
+// ===================================================================================
+TEST_F(HeapProfilerTest, HugeSampleTracksInPlaceResize) {
+    AllocatorOptions::get_instance().region_max_segments = 0;
+    sample_everything();
+
+    const size_t size = 8 * 1024 * 1024;
+    const size_t shrunk = 3 * 1024 * 1024;
+    void* ptr = heap_->allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_NE(profiler_.find_live(ptr), SIZE_MAX);
+    const ProfileBucket& bucket = profiler_.buckets_[profiler_.live_[profiler_.find_live(ptr)].bucket];
+    const uint64_t inuse = bucket.inuse_bytes;
+
+    // 缩小到一半以下时归还尾部，mremap 缩小总是原地完成
+    ASSERT_EQ(heap_->reallocate(ptr, shrunk), ptr);
+    ASSERT_NE(profiler_.find_live(ptr), SIZE_MAX);
+    EXPECT_EQ(profiler_.live_[profiler_.find_live(ptr)].size, shrunk);
+    EXPECT_EQ(bucket.inuse_bytes, inuse - size + shrunk);
+
+    heap_->free(ptr);
+    EXPECT_EQ(bucket.inuse_bytes, inuse - size);
+}
+
+// ===================================================================================
+// 测试用例 7: heap 销毁时其上的样本一并注销
+// ===================================================================================
+TEST_F(HeapProfilerTest, DestroyedHeapRetiresSamples) {
+    AllocatorOptions::get_instance().profile_sample_interval = 1;
+    const size_t before = profiler_.get_live_samples();
+
+    auto* other = new ThreadHeap();
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_NE(other->allocate(256), nullptr);
+    }
+    EXPECT_EQ(profiler_.get_live_samples(), before + 19);
+
+    delete other;
+    EXPECT_EQ(profiler_.get_live_samples(), before);
+}
+
+// ===================================================================================
+// 测试用例 8: 采样间隔服从均值为 interval 的几何分布
+// ===================================================================================
+TEST_F(HeapProfilerTest, SampleDistanceHasRequestedMean) {
+    uint64_t state = 0x12345678;
+    const size_t interval = 512 * 1024;
+    const int draws = 200000;
+
+    double sum = 0;
+    for (int i = 0; i < draws; ++i) {
+        const int64_t distance = HeapProfiler::next_sample_distance(&state, interval);
+        ASSERT_GE(distance, 0);
+        sum += static_cast<double>(distance);
+    }
+    EXPECT_NEAR(sum / draws, static_cast<double>(interval), interval * 0.02);
+}
+
+} // namespace my_malloc
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/SlabConfig.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace my_malloc {
+
+class HeapWalkTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+    }
+
+    void TearDown() override {
+        delete heap_;
+        AllocatorOptions::get_instance().empty_slab_reserve = 0;
+    }
+
+    struct Walked {
+        size_t usable_size;
+        BlockKind kind;
+    };
+
+    std::map<void*, Walked> walk() {
+        std::map<void*, Walked> blocks;
+        EXPECT_TRUE(heap_->heap_walk([](const HeapBlock& block, void* arg) {
+            auto* out = static_cast<std::map<void*, Walked>*>(arg);
+            EXPECT_EQ(out->count(block.ptr), 0u);
+            (*out)[block.ptr] = Walked{block.usable_size, block.kind};
+        }, &blocks));
+        return blocks;
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 遍历结果与存活的 small/large/huge 块一一对应，大小等于可用大小
+// ===================================================================================
+TEST_F(HeapWalkTest, ReportsEveryLiveBlock) {
+    std::vector<void*> small;
+    for (size_t size : {16, 64, 100, 512, 4000}) {
+        for (int i = 0; i < 20; ++i) {
+            small.push_back(heap_->allocate(size));
+        }
+    }
+    void* medium = heap_->allocate(MAX_SMALL_OBJECT_SIZE + PAGE_SIZE);
+    void* huge = heap_->allocate(4 * SEGMENT_SIZE);
+    ASSERT_NE(medium, nullptr);
+    ASSERT_NE(huge, nullptr);
+
+    const auto blocks = walk();
+    EXPECT_EQ(blocks.size(), small.size() + 2);
+
+    for (void* ptr : small) {
+        ASSERT_EQ(blocks.count(ptr), 1u);
+        EXPECT_EQ(blocks.at(ptr).kind, BlockKind::SMALL);
+        EXPECT_EQ(blocks.at(ptr).usable_size, ThreadHeap::get_usable_size(ptr));
+    }
+    ASSERT_EQ(blocks.count(medium), 1u);
+    EXPECT_EQ(blocks.at(medium).kind, BlockKind::LARGE);
+    EXPECT_EQ(blocks.at(medium).usable_size, ThreadHeap::get_usable_size(medium));
+    ASSERT_EQ(blocks.count(huge), 1u);
+    EXPECT_EQ(blocks.at(huge).kind, BlockKind::HUGE);
+    EXPECT_GE(blocks.at(huge).usable_size, 4 * SEGMENT_SIZE);
+
+    for (void* ptr : small) {
+        heap_->free(ptr);
+    }
+    heap_->free(medium);
+    heap_->free(huge);
+}
+
+// ===================================================================================
+// 测试用例 2: 释放后的块不再出现，空闲 span 和缓存的 span 被整段跳过
+// ===================================================================================
+TEST_F(HeapWalkTest, FreedBlocksDisappear) {
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 200; ++i) {
+        ptrs.push_back(heap_->allocate(48));
+    }
+    void* medium_a = heap_->allocate(MAX_SMALL_OBJECT_SIZE + PAGE_SIZE);
+    void* medium_b = heap_->allocate(MAX_SMALL_OBJECT_SIZE + 8 * PAGE_SIZE);
+    void* medium_c = heap_->allocate(MAX_SMALL_OBJECT_SIZE + PAGE_SIZE);
+
+    for (size_t i = 0; i < ptrs.size(); i += 2) {
+        heap_->free(ptrs[i]);
+    }
+    heap_->free(medium_a);
+    heap_->free(medium_b);
+
+    const auto blocks = walk();
+    EXPECT_EQ(blocks.size(), ptrs.size() / 2 + 1);
+    for (size_t i = 0; i < ptrs.size(); ++i) {
+        EXPECT_EQ(blocks.count(ptrs[i]), i % 2) << i;
+    }
+    EXPECT_EQ(blocks.count(medium_c), 1u);
+
+    for (size_t i = 1; i < ptrs.size(); i += 2) {
+        heap_->free(ptrs[i]);
+    }
+    heap_->free(medium_c);
+    EXPECT_TRUE(walk().empty());
+}
+
+// ===================================================================================
+// 测试用例 3: 预留的空 slab 不产生任何块
+// ===================================================================================
+TEST_F(HeapWalkTest, ReservedEmptySlabHasNoBlocks) {
+    AllocatorOptions::get_instance().empty_slab_reserve = 1;
+    const size_t class_id = SlabConfig::get_instance().get_size_class_index(256);
+
+    heap_->free(heap_->allocate(256));
+    ASSERT_EQ(heap_->slab_caches_[class_id].num_empty, 1u);
+    EXPECT_TRUE(walk().empty());
+    heap_->purge();
+}
+
+// ===================================================================================
+// 测试用例 4: 非阻塞模式下 heap 正忙时直接返回 false，不调用回调
+// ===================================================================================
+TEST_F(HeapWalkTest, NonBlockingWalkFailsWhenBusy) {
+    void* ptr = heap_->allocate(64);
+    int calls = 0;
+    auto count = [](const HeapBlock&, void* arg) { ++*static_cast<int*>(arg); };
+
+    {
+        std::lock_guard<std::mutex> guard(heap_->lock_);
+        bool walked = true;
+        // 同一线程上 try_lock 一个已持有的 mutex 是未定义行为，换一个线程来试
+        std::thread([&] { walked = heap_->heap_walk(count, &calls, false); }).join();
+        EXPECT_FALSE(walked);
+        EXPECT_EQ(calls, 0);
+    }
+
+    EXPECT_TRUE(heap_->heap_walk(count, &calls, false));
+    EXPECT_EQ(calls, 1);
+    heap_->free(ptr);
+}
+
+} // namespace my_malloc
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <cstring>
+
+namespace my_malloc {
+
+class HugeAlignmentTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+        AllocatorOptions::get_instance().huge_layout = HugeLayout::SEGMENT_ALIGNED;
+    }
+
+    void TearDown() override {
+        delete heap_;
+
+        auto& options = AllocatorOptions::get_instance();
+        options.huge_layout = HugeLayout::INLINE;
+        options.hugetlb_mode = HugeTlbMode::OFF;
+        options.region_max_segments = DEFAULT_REGION_MAX_SEGMENTS;
+    }
+
+    static bool is_segment_aligned(const void* ptr) {
+        return (reinterpret_cast<uintptr_t>(ptr) & (SEGMENT_SIZE - 1)) == 0;
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 用户指针落在 2MB 边界上，头部位于其下方
+// ===================================================================================
+TEST_F(HugeAlignmentTest, UserPointerIsSegmentAligned) {
+    const size_t size = 6 * 1024 * 1024;
+    void* ptr = heap_->allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(is_segment_aligned(ptr));
+
+    MappedSegment* seg = MappedSegment::get_owning_segment(ptr);
+    EXPECT_EQ(reinterpret_cast<char*>(seg) + SEGMENT_METADATA_SIZE, ptr);
+    EXPECT_EQ(seg->page_descriptors_[0].status, PageStatus::HUGE_SLAB);
+    EXPECT_TRUE(seg->is_aligned_huge());
+    EXPECT_EQ(heap_->huge_segments_, seg);
+
+    EXPECT_GE(ThreadHeap::get_usable_size(ptr), size);
+    memset(ptr, 0x5A, ThreadHeap::get_usable_size(ptr));
+
+    heap_->free(ptr);
+    EXPECT_EQ(heap_->huge_segments_, nullptr);
+}
+
+// ===================================================================================
+// 测试用例 2: 普通对象不受对齐布局影响
+// ===================================================================================
+TEST_F(HugeAlignmentTest, RegularObjectsStillResolveToTheirSegment) {
+    void* small = heap_->allocate(64);
+    void* large = heap_->allocate(MAX_SMALL_OBJECT_SIZE + 4 * PAGE_SIZE);
+    ASSERT_NE(small, nullptr);
+    ASSERT_NE(large, nullptr);
+
+    EXPECT_EQ(MappedSegment::get_owning_segment(small), MappedSegment::get_segment(small));
+    EXPECT_EQ(MappedSegment::get_owning_segment(large), MappedSegment::get_segment(large));
+
+    heap_->free(large);
+    heap_->free(small);
+}
+
+// ===================================================================================
+// 测试用例 3: 缓存只复用布局相同的映射
+// ===================================================================================
+TEST_F(HugeAlignmentTest, CacheDoesNotMixLayouts) {
+    const size_t size = 5 * 1024 * 1024;
+    auto& options = AllocatorOptions::get_instance();
+
+    options.huge_layout = HugeLayout::INLINE;
+    options.region_max_segments = 0;
+    void* inline_ptr = heap_->allocate(size);
+    ASSERT_NE(inline_ptr, nullptr);
+    MappedSegment* inline_seg = MappedSegment::get_owning_segment(inline_ptr);
+    EXPECT_FALSE(inline_seg->is_aligned_huge());
+    heap_->free(inline_ptr);
+    ASSERT_EQ(heap_->huge_cache_.get_cached_bytes(), inline_seg->total_size_);
+
+    options.huge_layout = HugeLayout::SEGMENT_ALIGNED;
+    void* aligned_ptr = heap_->allocate(size);
+    ASSERT_NE(aligned_ptr, nullptr);
+    EXPECT_TRUE(is_segment_aligned(aligned_ptr));
+    MappedSegment* aligned_seg = MappedSegment::get_owning_segment(aligned_ptr);
+    EXPECT_NE(aligned_seg, inline_seg) << "An inline mapping must not be reused for the aligned layout.";
+    heap_->free(aligned_ptr);
+
+    // 再次以对齐布局申请时命中刚归还的映射
+    void* again = heap_->allocate(size);
+    EXPECT_EQ(again, aligned_ptr);
+    heap_->free(again);
+}
+
+// ===================================================================================
+// 测试用例 4: realloc 增长后仍然保持 2MB 对齐，数据不变
+// ===================================================================================
+TEST_F(HugeAlignmentTest, ReallocKeepsAlignmentAndData) {
+    const size_t size = 4 * 1024 * 1024;
+    char* ptr = static_cast<char*>(heap_->allocate(size));
+    ASSERT_NE(ptr, nullptr);
+    ptr[0] = 1;
+    ptr[size - 1] = 2;
+
+    // 在映射末尾放一个页，迫使增长时搬迁
+    MappedSegment* seg = MappedSegment::get_owning_segment(ptr);
+    char* seg_end = reinterpret_cast<char*>(seg) + seg->total_size_;
+    void* blocker = mmap(seg_end, PAGE_SIZE, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(blocker, MAP_FAILED);
+
+    const size_t new_size = 5 * size;
+    char* grown = static_cast<char*>(heap_->reallocate(ptr, new_size));
+    ASSERT_NE(grown, nullptr);
+    EXPECT_TRUE(is_segment_aligned(grown));
+    EXPECT_EQ(grown[0], 1);
+    EXPECT_EQ(grown[size - 1], 2);
+    EXPECT_GE(ThreadHeap::get_usable_size(grown), new_size);
+
+    MappedSegment* moved = MappedSegment::get_owning_segment(grown);
+    EXPECT_EQ(moved->page_descriptors_[0].slab_ptr, moved);
+    EXPECT_EQ(heap_->huge_segments_, moved);
+
+    heap_->free(grown);
+    munmap(blocker, PAGE_SIZE);
+}
+
+// ===================================================================================
+// 测试用例 5: 与 hugetlb 组合时同样返回对齐指针 (命中或回退均可)
+// ===================================================================================
+TEST_F(HugeAlignmentTest, AlignedLayoutWithHugeTlb) {
+    AllocatorOptions::get_instance().hugetlb_mode = HugeTlbMode::HUGE_ONLY;
+
+    const size_t size = 3 * 1024 * 1024;
+    void* ptr = heap_->allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(is_segment_aligned(ptr));
+
+    MappedSegment* seg = MappedSegment::get_owning_segment(ptr);
+    EXPECT_EQ(seg->page_descriptors_[0].status, PageStatus::HUGE_SLAB);
+    if (seg->is_hugetlb()) {
+        EXPECT_EQ(seg->mapping_offset_, SEGMENT_SIZE - SEGMENT_METADATA_SIZE);
+    } else {
+        EXPECT_EQ(seg->mapping_offset_, 0u);
+    }
+    EXPECT_GE(ThreadHeap::get_usable_size(ptr), size);
+    memset(ptr, 0x3C, size);
+
+    heap_->free(ptr);
+}
+
+} // namespace my_malloc
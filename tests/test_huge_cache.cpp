@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/HugeSegmentCache.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <cstring>
+
+namespace my_malloc {
+
+class HugeCacheTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+        // 小于 16MB 的请求默认走 Segment 区域，这里只测试独立映射的缓存
+        AllocatorOptions::get_instance().region_max_segments = 0;
+    }
+
+    void TearDown() override {
+        delete heap_;
+
+        // 恢复全局策略，避免影响其他测试
+        auto& options = AllocatorOptions::get_instance();
+        options.huge_cache_budget = DEFAULT_HUGE_CACHE_BUDGET;
+        options.huge_cache_decay_ms = DEFAULT_HUGE_CACHE_DECAY_MS;
+        options.region_max_segments = DEFAULT_REGION_MAX_SEGMENTS;
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 桶大小取整的基本性质
+// ===================================================================================
+TEST_F(HugeCacheTest, BucketRoundingIsMonotonicAndPageAligned) {
+    size_t prev = 0;
+    for (size_t size = SEGMENT_SIZE - PAGE_SIZE; size <= 64 * SEGMENT_SIZE; size += 37 * PAGE_SIZE) {
+        SCOPED_TRACE("size = " + std::to_string(size));
+        const size_t rounded = HugeSegmentCache::round_to_bucket_size(size);
+
+        EXPECT_GE(rounded, size);
+        EXPECT_GE(rounded, prev);
+        EXPECT_EQ(rounded % PAGE_SIZE, 0u);
+        // 四分之一 2 的幂步长，最多浪费 25%
+        EXPECT_LE(rounded - size, size / 4 + PAGE_SIZE);
+        EXPECT_LT(HugeSegmentCache::get_bucket_index(rounded), HUGE_CACHE_NUM_BUCKETS);
+
+        prev = rounded;
+    }
+}
+
+// ===================================================================================
+// 测试用例 2: 释放后的 Huge 映射被同一个桶内的请求复用
+// ===================================================================================
+TEST_F(HugeCacheTest, FreedHugeMappingIsReusedBySameBucket) {
+    const size_t size = 4 * 1024 * 1024;
+
+    void* ptr1 = heap_->allocate(size);
+    ASSERT_NE(ptr1, nullptr);
+    memset(ptr1, 0x5A, size);
+    heap_->free(ptr1);
+
+    EXPECT_GT(heap_->huge_cache_.get_cached_bytes(), 0u);
+
+    // 略大一点的请求仍落在同一个桶里
+    void* ptr2 = heap_->allocate(size + 1000);
+    ASSERT_NE(ptr2, nullptr);
+    EXPECT_EQ(ptr1, ptr2) << "A cached huge mapping should be reused for a request in the same bucket.";
+    EXPECT_EQ(heap_->huge_cache_.get_cached_bytes(), 0u);
+
+    MappedSegment* seg = MappedSegment::get_segment(ptr2);
+    EXPECT_EQ(seg->page_descriptors_[0].status, PageStatus::HUGE_SLAB);
+    EXPECT_EQ(seg->get_owner_heap(), heap_);
+
+    heap_->free(ptr2);
+}
+
+// ===================================================================================
+// 测试用例 3: 预算为 0 时缓存被禁用
+// ===================================================================================
+TEST_F(HugeCacheTest, ZeroBudgetDisablesCache) {
+    AllocatorOptions::get_instance().huge_cache_budget = 0;
+
+    void* ptr = heap_->allocate(8 * 1024 * 1024);
+    ASSERT_NE(ptr, nullptr);
+    heap_->free(ptr);
+
+    EXPECT_EQ(heap_->huge_cache_.get_cached_bytes(), 0u);
+    EXPECT_EQ(heap_->huge_segments_, nullptr);
+}
+
+// ===================================================================================
+// 测试用例 4: 超出预算时用 MADV_FREE 清理最久未用的映射，但保留映射本身
+// ===================================================================================
+TEST_F(HugeCacheTest, BudgetPressurePurgesOldestButKeepsMapping) {
+    const size_t size = 6 * 1024 * 1024;
+    const size_t mapping_size = HugeSegmentCache::round_to_bucket_size(sizeof(MappedSegment) + size);
+    AllocatorOptions::get_instance().huge_cache_budget = mapping_size + mapping_size / 2;
+
+    void* ptr_a = heap_->allocate(size);
+    void* ptr_b = heap_->allocate(size);
+    ASSERT_NE(ptr_a, nullptr);
+    ASSERT_NE(ptr_b, nullptr);
+    MappedSegment* seg_a = MappedSegment::get_segment(ptr_a);
+    MappedSegment* seg_b = MappedSegment::get_segment(ptr_b);
+
+    heap_->free(ptr_a);
+    heap_->free(ptr_b);
+
+    EXPECT_EQ(heap_->huge_cache_.get_cached_bytes(), 2 * mapping_size);
+    EXPECT_EQ(heap_->huge_cache_.get_dirty_bytes(), mapping_size);
+    EXPECT_TRUE(seg_a->flags_ & MappedSegment::FLAG_PURGED) << "The older mapping should be purged first.";
+    EXPECT_FALSE(seg_b->flags_ & MappedSegment::FLAG_PURGED);
+
+    // 被 purge 的映射依然可以安全复用
+    void* ptr_c = heap_->allocate(size);
+    void* ptr_d = heap_->allocate(size);
+    ASSERT_NE(ptr_c, nullptr);
+    ASSERT_NE(ptr_d, nullptr);
+    memset(ptr_c, 0x11, size);
+    memset(ptr_d, 0x22, size);
+    EXPECT_EQ(heap_->huge_cache_.get_cached_bytes(), 0u);
+
+    heap_->free(ptr_c);
+    heap_->free(ptr_d);
+}
+
+// ===================================================================================
+// 测试用例 5: decay 为 0 时放入缓存的映射立即被 purge
+// ===================================================================================
+TEST_F(HugeCacheTest, ZeroDecayPurgesImmediately) {
+    AllocatorOptions::get_instance().huge_cache_decay_ms = 0;
+
+    void* ptr = heap_->allocate(16 * 1024 * 1024);
+    ASSERT_NE(ptr, nullptr);
+    heap_->free(ptr);
+
+    EXPECT_GT(heap_->huge_cache_.get_cached_bytes(), 0u);
+    EXPECT_EQ(heap_->huge_cache_.get_dirty_bytes(), 0u);
+}
+
+// ===================================================================================
+// 测试用例 6: 对已缓存映射的重复释放被忽略
+// ===================================================================================
+TEST_F(HugeCacheTest, DoubleFreeOfCachedMappingIsIgnored) {
+    void* ptr = heap_->allocate(3 * 1024 * 1024);
+    ASSERT_NE(ptr, nullptr);
+    heap_->free(ptr);
+
+    const size_t cached = heap_->huge_cache_.get_cached_bytes();
+    heap_->free(ptr);
+    EXPECT_EQ(heap_->huge_cache_.get_cached_bytes(), cached);
+}
+
+} // namespace my_malloc
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <cstring>
+
+namespace my_malloc {
+
+// 测试机上的 hugetlb 池可能为空，因此每个用例都同时接受"命中"与"回退"两种结果，
+// 只要求计数器与映射的状态彼此一致。
+class HugeTlbTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+    uint64_t hits_before_ = 0;
+    uint64_t fallbacks_before_ = 0;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+        hits_before_ = MappedSegment::get_counters().hugetlb_hits.load();
+        fallbacks_before_ = MappedSegment::get_counters().hugetlb_fallbacks.load();
+    }
+
+    void TearDown() override {
+        delete heap_;
+
+        auto& options = AllocatorOptions::get_instance();
+        options.hugetlb_mode = HugeTlbMode::OFF;
+        options.hugetlb_page_size = DEFAULT_HUGETLB_PAGE_SIZE;
+    }
+
+    uint64_t attempts() const {
+        const auto& counters = MappedSegment::get_counters();
+        return (counters.hugetlb_hits.load() - hits_before_)
+             + (counters.hugetlb_fallbacks.load() - fallbacks_before_);
+    }
+
+    uint64_t hits() const {
+        return MappedSegment::get_counters().hugetlb_hits.load() - hits_before_;
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 默认关闭时不会尝试 MAP_HUGETLB
+// ===================================================================================
+TEST_F(HugeTlbTest, DisabledByDefault) {
+    void* ptr = heap_->allocate(4 * 1024 * 1024);
+    ASSERT_NE(ptr, nullptr);
+
+    EXPECT_EQ(attempts(), 0u);
+    EXPECT_FALSE(MappedSegment::get_segment(ptr)->is_hugetlb());
+
+    heap_->free(ptr);
+}
+
+// ===================================================================================
+// 测试用例 2: 直接创建 hugetlb Segment，命中或干净地回退
+// ===================================================================================
+TEST_F(HugeTlbTest, CreateFallsBackCleanly) {
+    MappedSegment* seg = MappedSegment::create(3 * 1024 * 1024, true);
+    ASSERT_NE(seg, nullptr);
+    EXPECT_EQ(attempts(), 1u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(seg) % SEGMENT_SIZE, 0u);
+
+    if (hits() == 1) {
+        EXPECT_TRUE(seg->is_hugetlb());
+        EXPECT_EQ(seg->total_size_ % DEFAULT_HUGETLB_PAGE_SIZE, 0u);
+    } else {
+        EXPECT_FALSE(seg->is_hugetlb());
+        EXPECT_EQ(seg->total_size_, 3u * 1024 * 1024);
+    }
+
+    // 整个映射都必须可写
+    memset(reinterpret_cast<char*>(seg) + sizeof(MappedSegment), 0xAB, seg->total_size_ - sizeof(MappedSegment));
+    MappedSegment::destroy(seg);
+}
+
+// ===================================================================================
+// 测试用例 3: HUGE_ONLY 模式只影响 Huge 对象
+// ===================================================================================
+TEST_F(HugeTlbTest, HugeOnlyModeAppliesToHugeAllocations) {
+    AllocatorOptions::get_instance().hugetlb_mode = HugeTlbMode::HUGE_ONLY;
+
+    void* small = heap_->allocate(64);
+    ASSERT_NE(small, nullptr);
+    EXPECT_EQ(attempts(), 0u) << "Regular segments must not use hugetlb in HUGE_ONLY mode.";
+
+    const size_t size = 5 * 1024 * 1024;
+    void* huge = heap_->allocate(size);
+    ASSERT_NE(huge, nullptr);
+    EXPECT_EQ(attempts(), 1u);
+    EXPECT_EQ(MappedSegment::get_segment(huge)->is_hugetlb(), hits() == 1);
+    memset(huge, 0xCD, size);
+
+    heap_->free(huge);
+    heap_->free(small);
+}
+
+// ===================================================================================
+// 测试用例 4: ALL_SEGMENTS 模式下普通 Segment 也尝试 hugetlb
+// ===================================================================================
+TEST_F(HugeTlbTest, AllSegmentsModeAppliesToRegularSegments) {
+    AllocatorOptions::get_instance().hugetlb_mode = HugeTlbMode::ALL_SEGMENTS;
+
+    void* small = heap_->allocate(64);
+    ASSERT_NE(small, nullptr);
+    EXPECT_EQ(attempts(), 1u);
+
+    MappedSegment* seg = MappedSegment::get_segment(small);
+    EXPECT_EQ(seg->is_hugetlb(), hits() == 1);
+    EXPECT_EQ(seg->total_size_, SEGMENT_SIZE);
+
+    heap_->free(small);
+}
+
+// ===================================================================================
+// 测试用例 5: 非法的大页尺寸不会产生 hugetlb 映射
+// ===================================================================================
+TEST_F(HugeTlbTest, InvalidPageSizeIsRejected) {
+    auto& options = AllocatorOptions::get_instance();
+    options.hugetlb_mode = HugeTlbMode::HUGE_ONLY;
+    options.hugetlb_page_size = PAGE_SIZE;
+
+    void* huge = heap_->allocate(4 * 1024 * 1024);
+    ASSERT_NE(huge, nullptr);
+    EXPECT_EQ(hits(), 0u);
+    EXPECT_FALSE(MappedSegment::get_segment(huge)->is_hugetlb());
+
+    heap_->free(huge);
+}
+
+// ===================================================================================
+// 测试用例 6: hugetlb 映射的 realloc 走拷贝路径，数据保持不变
+// ===================================================================================
+TEST_F(HugeTlbTest, ReallocOfHugeTlbMappingCopies) {
+    AllocatorOptions::get_instance().hugetlb_mode = HugeTlbMode::HUGE_ONLY;
+
+    const size_t size = 4 * 1024 * 1024;
+    char* ptr = static_cast<char*>(heap_->allocate(size));
+    ASSERT_NE(ptr, nullptr);
+    ptr[0] = 1;
+    ptr[size - 1] = 2;
+
+    char* grown = static_cast<char*>(heap_->reallocate(ptr, 4 * size));
+    ASSERT_NE(grown, nullptr);
+    EXPECT_EQ(grown[0], 1);
+    EXPECT_EQ(grown[size - 1], 2);
+
+    heap_->free(grown);
+}
+
+} // namespace my_malloc
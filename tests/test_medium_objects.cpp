@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/SlabConfig.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <vector>
+
+namespace my_malloc {
+
+class MediumObjectTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+    const SlabConfig* config_ = nullptr;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+        config_ = &SlabConfig::get_instance();
+    }
+
+    void TearDown() override {
+        delete heap_;
+        AllocatorOptions::get_instance().medium_cache_depth = DEFAULT_MEDIUM_CACHE_DEPTH;
+    }
+
+    uint16_t class_pages_for(size_t size) const {
+        const size_t num_pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+        return config_->get_medium_class_pages(config_->get_medium_class_index(num_pages));
+    }
+
+    static PageDescriptor* head_desc(void* ptr) {
+        return MappedSegment::get_segment(ptr)->get_page_desc(ptr);
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 档位表单调递增、覆盖整个中等对象区间，且相邻档位间距不超过 25%
+// ===================================================================================
+TEST_F(MediumObjectTest, ClassTableCoversMediumRange) {
+    const size_t num_classes = config_->get_num_medium_classes();
+    ASSERT_GT(num_classes, 0u);
+    ASSERT_LE(num_classes, MAX_NUM_MEDIUM_CLASSES);
+
+    EXPECT_GT(config_->get_medium_class_pages(0), MAX_SMALL_OBJECT_SIZE / PAGE_SIZE);
+    EXPECT_EQ(config_->get_medium_class_pages(num_classes - 1), SEGMENT_USABLE_PAGES);
+
+    for (size_t i = 1; i < num_classes; ++i) {
+        SCOPED_TRACE("Medium class " + std::to_string(i));
+        const uint16_t prev = config_->get_medium_class_pages(i - 1);
+        const uint16_t cur = config_->get_medium_class_pages(i);
+        EXPECT_GT(cur, prev);
+        EXPECT_LE(cur - prev, prev / 4 + 1);
+    }
+
+    // 每个页数都映射到不小于它的最小档位
+    for (size_t pages = MAX_SMALL_OBJECT_SIZE / PAGE_SIZE + 1; pages <= SEGMENT_USABLE_PAGES; ++pages) {
+        const size_t index = config_->get_medium_class_index(pages);
+        ASSERT_LT(index, num_classes);
+        EXPECT_GE(config_->get_medium_class_pages(index), pages);
+        if (index > 0) {
+            EXPECT_LT(config_->get_medium_class_pages(index - 1), pages);
+        }
+    }
+    EXPECT_EQ(config_->get_medium_class_index(SEGMENT_USABLE_PAGES + 1), static_cast<size_t>(-1));
+}
+
+// ===================================================================================
+// 测试用例 2: 分配按档位取整，2 的幂大小没有额外开销
+// ===================================================================================
+TEST_F(MediumObjectTest, AllocationIsRoundedToClass) {
+    void* odd = heap_->allocate(MAX_SMALL_OBJECT_SIZE + 3 * PAGE_SIZE + 1);
+    ASSERT_NE(odd, nullptr);
+    EXPECT_EQ(head_desc(odd)->num_pages, class_pages_for(MAX_SMALL_OBJECT_SIZE + 3 * PAGE_SIZE + 1));
+    EXPECT_EQ(ThreadHeap::get_usable_size(odd), head_desc(odd)->num_pages * PAGE_SIZE);
+
+    void* exact = heap_->allocate(1024 * 1024);
+    ASSERT_NE(exact, nullptr);
+    EXPECT_EQ(head_desc(exact)->num_pages, 1024 * 1024 / PAGE_SIZE);
+
+    heap_->free(odd);
+    heap_->free(exact);
+}
+
+// ===================================================================================
+// 测试用例 3: 同一档位内不同大小的请求复用缓存中的 span
+// ===================================================================================
+TEST_F(MediumObjectTest, FreedSpanIsReusedWithinClass) {
+    const size_t size_a = MAX_SMALL_OBJECT_SIZE + 5 * PAGE_SIZE;
+    const size_t size_b = MAX_SMALL_OBJECT_SIZE + 9 * PAGE_SIZE;
+    ASSERT_EQ(class_pages_for(size_a), class_pages_for(size_b));
+
+    void* ptr_a = heap_->allocate(size_a);
+    ASSERT_NE(ptr_a, nullptr);
+    heap_->free(ptr_a);
+
+    // 缓存中的 span 只有首页被标记，其余页仍指向首页
+    EXPECT_EQ(head_desc(ptr_a)->status, PageStatus::CACHED_SLAB);
+    PageDescriptor* tail = MappedSegment::get_segment(ptr_a)->get_page_desc(static_cast<char*>(ptr_a) + PAGE_SIZE);
+    EXPECT_EQ(tail->status, PageStatus::LARGE_SLAB);
+    EXPECT_EQ(tail->slab_ptr, ptr_a);
+
+    void* ptr_b = heap_->allocate(size_b);
+    EXPECT_EQ(ptr_b, ptr_a);
+    EXPECT_EQ(head_desc(ptr_b)->status, PageStatus::LARGE_SLAB);
+
+    heap_->free(ptr_b);
+}
+
+// ===================================================================================
+// 测试用例 4: 对缓存中的 span 重复释放被忽略
+// ===================================================================================
+TEST_F(MediumObjectTest, DoubleFreeOfCachedSpanIsIgnored) {
+    const size_t size = MAX_SMALL_OBJECT_SIZE + 20 * PAGE_SIZE;
+    void* ptr = heap_->allocate(size);
+    ASSERT_NE(ptr, nullptr);
+
+    heap_->free(ptr);
+    heap_->free(ptr);
+
+    EXPECT_EQ(heap_->allocate(size), ptr);
+    void* other = heap_->allocate(size);
+    EXPECT_NE(other, ptr) << "A span must not be cached twice.";
+
+    heap_->free(ptr);
+    heap_->free(other);
+}
+
+// ===================================================================================
+// 测试用例 5: 缓存深度有上限，超出的 span 归还 freelist；深度为 0 时关闭缓存
+// ===================================================================================
+TEST_F(MediumObjectTest, CacheDepthIsBounded) {
+    auto& options = AllocatorOptions::get_instance();
+    options.medium_cache_depth = 2;
+
+    const size_t size = MAX_SMALL_OBJECT_SIZE + PAGE_SIZE;
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 3; ++i) {
+        ptrs.push_back(heap_->allocate(size));
+        ASSERT_NE(ptrs.back(), nullptr);
+    }
+    for (void* ptr : ptrs) {
+        heap_->free(ptr);
+    }
+
+    EXPECT_EQ(head_desc(ptrs[0])->status, PageStatus::CACHED_SLAB);
+    EXPECT_EQ(head_desc(ptrs[1])->status, PageStatus::CACHED_SLAB);
+    EXPECT_EQ(head_desc(ptrs[2])->status, PageStatus::FREE);
+
+    options.medium_cache_depth = 0;
+    void* reused = heap_->allocate(size);
+    ASSERT_NE(reused, nullptr);
+    EXPECT_EQ(reused, ptrs[1]) << "Cached spans are still handed out when the cache is disabled.";
+    heap_->free(reused);
+    EXPECT_EQ(head_desc(reused)->status, PageStatus::FREE);
+}
+
+} // namespace my_malloc
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/HugeSegmentCache.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/SlabConfig.hpp>
+#include <my_malloc/internal/definitions.hpp>
+#include <my_malloc/sys/mman.hpp>
+
+#include <cstring>
+
+namespace my_malloc {
+
+class ReallocTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+    }
+
+    void TearDown() override {
+        delete heap_;
+    }
+
+    static void fill_pattern(void* ptr, size_t size) {
+        auto* bytes = static_cast<unsigned char*>(ptr);
+        for (size_t i = 0; i < size; i += PAGE_SIZE / 2) {
+            bytes[i] = static_cast<unsigned char>(i / PAGE_SIZE);
+        }
+    }
+
+    static bool check_pattern(const void* ptr, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(ptr);
+        for (size_t i = 0; i < size; i += PAGE_SIZE / 2) {
+            if (bytes[i] != static_cast<unsigned char>(i / PAGE_SIZE)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool huge_list_contains(MappedSegment* target) {
+        MappedSegment* prev = nullptr;
+        for (MappedSegment* cur = heap_->huge_segments_; cur != nullptr; cur = cur->list_node.next) {
+            EXPECT_EQ(cur->list_node.prev, prev) << "huge_segments_ back links are broken.";
+            if (cur == target) {
+                return true;
+            }
+            prev = cur;
+        }
+        return false;
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 基本语义 (nullptr / size 0)
+// ===================================================================================
+TEST_F(ReallocTest, NullptrAndZeroSizeFollowReallocSemantics) {
+    void* ptr = heap_->reallocate(nullptr, 64);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_GE(ThreadHeap::get_usable_size(ptr), 64u);
+
+    EXPECT_EQ(heap_->reallocate(ptr, 0), nullptr);
+}
+
+// ===================================================================================
+// 测试用例 2: 小对象与大对象之间的 realloc 保留数据
+// ===================================================================================
+TEST_F(ReallocTest, SmallToLargeToSmallPreservesData) {
+    char* ptr = static_cast<char*>(heap_->allocate(100));
+    ASSERT_NE(ptr, nullptr);
+    for (int i = 0; i < 100; ++i) ptr[i] = static_cast<char>(i);
+
+    ptr = static_cast<char*>(heap_->reallocate(ptr, MAX_SMALL_OBJECT_SIZE + 10 * PAGE_SIZE));
+    ASSERT_NE(ptr, nullptr);
+    for (int i = 0; i < 100; ++i) ASSERT_EQ(ptr[i], static_cast<char>(i));
+
+    ptr = static_cast<char*>(heap_->reallocate(ptr, 50));
+    ASSERT_NE(ptr, nullptr);
+    for (int i = 0; i < 50; ++i) ASSERT_EQ(ptr[i], static_cast<char>(i));
+
+    heap_->free(ptr);
+}
+
+// ===================================================================================
+// 测试用例 3: 桶内余量足够时，Huge 对象的增长不移动也不重新映射
+// ===================================================================================
+TEST_F(ReallocTest, HugeGrowthWithinBucketSlackKeepsPointer) {
+    const size_t size = 5 * 1024 * 1024;
+    void* ptr = heap_->allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    MappedSegment* seg = MappedSegment::get_segment(ptr);
+    const size_t mapping_size = seg->total_size_;
+    const size_t slack = mapping_size - sizeof(MappedSegment) - size;
+    ASSERT_GT(slack, 0u);
+
+    void* grown = heap_->reallocate(ptr, size + slack);
+    EXPECT_EQ(grown, ptr);
+    EXPECT_EQ(seg->total_size_, mapping_size);
+
+    heap_->free(grown);
+}
+
+// ===================================================================================
+// 测试用例 4: Huge 对象增长通过 mremap 完成，数据与链表都保持正确
+// ===================================================================================
+TEST_F(ReallocTest, HugeGrowthRemapsAndPreservesData) {
+    const size_t size = 4 * 1024 * 1024;
+    void* neighbor_a = heap_->allocate(3 * 1024 * 1024);
+    void* ptr = heap_->allocate(size);
+    void* neighbor_b = heap_->allocate(3 * 1024 * 1024);
+    ASSERT_NE(neighbor_a, nullptr);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_NE(neighbor_b, nullptr);
+    fill_pattern(ptr, size);
+
+    const size_t new_size = 40 * 1024 * 1024;
+    void* grown = heap_->reallocate(ptr, new_size);
+    ASSERT_NE(grown, nullptr);
+
+    MappedSegment* seg = MappedSegment::get_segment(grown);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(seg) % SEGMENT_SIZE, 0u);
+    EXPECT_EQ(seg->page_descriptors_[0].status, PageStatus::HUGE_SLAB);
+    EXPECT_GE(seg->total_size_, sizeof(MappedSegment) + new_size);
+    EXPECT_GE(ThreadHeap::get_usable_size(grown), new_size);
+    EXPECT_TRUE(check_pattern(grown, size)) << "mremap must carry the old contents.";
+    EXPECT_TRUE(huge_list_contains(seg));
+
+    memset(static_cast<char*>(grown) + size, 0x7F, new_size - size);
+
+    heap_->free(neighbor_a);
+    heap_->free(grown);
+    heap_->free(neighbor_b);
+    EXPECT_EQ(heap_->huge_segments_, nullptr);
+}
+
+// ===================================================================================
+// 测试用例 5: 原地增长被阻挡时，映射被整体搬到新的对齐地址
+// ===================================================================================
+TEST_F(ReallocTest, HugeGrowthMovesWhenBlocked) {
+    const size_t size = 4 * 1024 * 1024;
+    void* ptr = heap_->allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    fill_pattern(ptr, size);
+
+    // 在映射末尾紧挨着放一个页，使原地扩展失败
+    MappedSegment* seg = MappedSegment::get_segment(ptr);
+    char* seg_end = reinterpret_cast<char*>(seg) + seg->total_size_;
+    void* blocker = mmap(seg_end, PAGE_SIZE, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(blocker, MAP_FAILED);
+
+    void* grown = heap_->reallocate(ptr, 3 * size);
+    ASSERT_NE(grown, nullptr);
+    if (blocker == seg_end) {
+        EXPECT_NE(grown, ptr) << "Growth past a blocker page must move the mapping.";
+    }
+
+    MappedSegment* moved = MappedSegment::get_segment(grown);
+    EXPECT_EQ(heap_->huge_segments_, moved);
+    EXPECT_EQ(moved->page_descriptors_[0].slab_ptr, moved);
+    EXPECT_TRUE(check_pattern(grown, size));
+
+    heap_->free(grown);
+    munmap(blocker, PAGE_SIZE);
+}
+
+// ===================================================================================
+// 测试用例 6: 缩小到一半以下时归还尾部，指针不变
+// ===================================================================================
+TEST_F(ReallocTest, HugeShrinkReleasesTailInPlace) {
+    const size_t size = 32 * 1024 * 1024;
+    void* ptr = heap_->allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    fill_pattern(ptr, 4 * 1024 * 1024);
+
+    void* shrunk = heap_->reallocate(ptr, 4 * 1024 * 1024);
+    EXPECT_EQ(shrunk, ptr);
+
+    MappedSegment* seg = MappedSegment::get_segment(shrunk);
+    EXPECT_EQ(seg->total_size_, HugeSegmentCache::round_to_bucket_size(sizeof(MappedSegment) + 4 * 1024 * 1024));
+    EXPECT_TRUE(check_pattern(shrunk, 4 * 1024 * 1024));
+
+    heap_->free(shrunk);
+}
+
+// ===================================================================================
+// 测试用例 7: 缩小到 Huge 阈值以下时迁移为普通对象
+// ===================================================================================
+TEST_F(ReallocTest, HugeShrinkBelowThresholdBecomesLargeObject) {
+    void* ptr = heap_->allocate(8 * 1024 * 1024);
+    ASSERT_NE(ptr, nullptr);
+    fill_pattern(ptr, MAX_SMALL_OBJECT_SIZE * 2);
+
+    void* shrunk = heap_->reallocate(ptr, MAX_SMALL_OBJECT_SIZE * 2);
+    ASSERT_NE(shrunk, nullptr);
+
+    MappedSegment* seg = MappedSegment::get_segment(shrunk);
+    EXPECT_NE(seg->page_descriptors_[0].status, PageStatus::HUGE_SLAB);
+    EXPECT_EQ(seg->get_page_desc(shrunk)->status, PageStatus::LARGE_SLAB);
+    EXPECT_TRUE(check_pattern(shrunk, MAX_SMALL_OBJECT_SIZE * 2));
+
+    heap_->free(shrunk);
+}
+
+} // namespace my_malloc
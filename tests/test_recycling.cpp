@@ -15,11 +15,15 @@
 #include <vector>
 #include <algorithm>
 
+#include "scoped_options.hpp"
+
 namespace my_malloc {
 
 // 使用一个专用的测试固件，以便将来添加更复杂的设置
 class RecyclingTest : public ::testing::Test {
 protected:
+    // 这些用例验证的是归还到 freelist 的路径，关闭中等对象的 span 缓存
+    ScopedMediumCacheDepth medium_cache_depth_{0};
     ThreadHeap* heap_ = nullptr;
 
     void SetUp() override {
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/sys/sdt.hpp>
+
+#include <elf.h>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace my_malloc {
+
+namespace {
+
+// 从可执行文件的 .note.stapsdt 节读出 "provider:name" -> 参数描述
+std::map<std::string, std::string> read_probes(const char* path) {
+    std::map<std::string, std::string> probes;
+    FILE* in = fopen(path, "rb");
+    if (in == nullptr) {
+        return probes;
+    }
+    std::vector<char> file;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        file.insert(file.end(), buf, buf + n);
+    }
+    fclose(in);
+
+    const auto* ehdr = reinterpret_cast<const Elf64_Ehdr*>(file.data());
+    const auto* shdrs = reinterpret_cast<const Elf64_Shdr*>(file.data() + ehdr->e_shoff);
+    const char* shstrtab = file.data() + shdrs[ehdr->e_shstrndx].sh_offset;
+
+    for (size_t i = 0; i < ehdr->e_shnum; ++i) {
+        if (std::strcmp(shstrtab + shdrs[i].sh_name, ".note.stapsdt") != 0) {
+            continue;
+        }
+        size_t off = shdrs[i].sh_offset;
+        const size_t end = off + shdrs[i].sh_size;
+        while (off + sizeof(Elf64_Nhdr) <= end) {
+            const auto* note = reinterpret_cast<const Elf64_Nhdr*>(file.data() + off);
+            const char* desc = file.data() + off + sizeof(Elf64_Nhdr) + ((note->n_namesz + 3) & ~3u);
+            if (note->n_type == 3) {
+                // 描述符：探针地址、base 地址、信号量地址，然后是三个字符串
+                const char* provider = desc + 3 * sizeof(uint64_t);
+                const char* name = provider + std::strlen(provider) + 1;
+                const char* args = name + std::strlen(name) + 1;
+                probes[std::string(provider) + ":" + name] = args;
+            }
+            off += sizeof(Elf64_Nhdr) + ((note->n_namesz + 3) & ~3u) + ((note->n_descsz + 3) & ~3u);
+        }
+    }
+    return probes;
+}
+
+} // namespace
+
+// ===================================================================================
+// 测试用例 1: 分配器中的探针都以 stapsdt note 的形式链接进可执行文件
+// ===================================================================================
+TEST(SdtTest, AllocatorProbesAreEmitted) {
+#if defined(MY_MALLOC_DISABLE_SDT) || !(defined(__x86_64__) || defined(__aarch64__))
+    GTEST_SKIP() << "USDT probes are compiled out on this target";
+#endif
+    // 引用 ThreadHeap，保证静态库中带探针的目标文件被链接进来
+    ThreadHeap heap;
+    heap.free(heap.allocate(64));
+
+    const auto probes = read_probes("/proc/self/exe");
+
+    const char* expected[] = {
+        "my_malloc:segment_create", "my_malloc:segment_destroy",
+        "my_malloc:slab_create", "my_malloc:slab_release",
+        "my_malloc:huge_alloc", "my_malloc:huge_free",
+    };
+    for (const char* probe : expected) {
+        EXPECT_EQ(probes.count(probe), 1u) << probe;
+    }
+
+    // 指针按无符号 8 字节描述，bool 为 1 字节
+    const std::string& args = probes.at("my_malloc:segment_create");
+    EXPECT_EQ(args.rfind("8@", 0), 0u) << args;
+    EXPECT_NE(args.find(" 1@"), std::string::npos) << args;
+}
+
+// ===================================================================================
+// 测试用例 2: 有符号参数的大小为负数
+// ===================================================================================
+TEST(SdtTest, SignedArgumentsAreNegative) {
+#if defined(MY_MALLOC_DISABLE_SDT) || !(defined(__x86_64__) || defined(__aarch64__))
+    GTEST_SKIP() << "USDT probes are compiled out on this target";
+#endif
+    volatile int value = -5;
+    const int copy = value;
+    MY_SDT_PROBE1(my_malloc_test, signed_probe, copy);
+
+    const auto probes = read_probes("/proc/self/exe");
+    ASSERT_EQ(probes.count("my_malloc_test:signed_probe"), 1u);
+    EXPECT_EQ(probes.at("my_malloc_test:signed_probe").rfind("-4@", 0), 0u);
+}
+
+} // namespace my_malloc
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/MappedSegment.hpp>
+#include <my_malloc/internal/SegmentRegion.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace my_malloc {
+
+class SegmentRegionTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+    }
+
+    void TearDown() override {
+        delete heap_;
+        AllocatorOptions::get_instance().region_max_segments = DEFAULT_REGION_MAX_SEGMENTS;
+    }
+
+    static size_t segments_for(size_t size) {
+        return (sizeof(MappedSegment) + size + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 略大于一个 Segment 的请求从区域中取连续的 Segment
+// ===================================================================================
+TEST_F(SegmentRegionTest, JustAboveOneSegmentComesFromRegion) {
+    const size_t size = SEGMENT_SIZE + SEGMENT_SIZE / 20;
+    void* ptr = heap_->allocate(size);
+    ASSERT_NE(ptr, nullptr);
+
+    MappedSegment* seg = MappedSegment::get_owning_segment(ptr);
+    EXPECT_TRUE(seg->is_region_backed());
+    EXPECT_TRUE(heap_->segment_region_.contains(seg));
+    EXPECT_EQ(seg->page_descriptors_[0].status, PageStatus::HUGE_SLAB);
+    EXPECT_EQ(seg->total_size_, 2 * SEGMENT_SIZE);
+    EXPECT_GE(ThreadHeap::get_usable_size(ptr), size);
+    EXPECT_EQ(heap_->segment_region_.get_free_segments(), SEGMENT_REGION_NUM_SEGMENTS - 2);
+
+    memset(ptr, 0xA5, size);
+    heap_->free(ptr);
+    EXPECT_EQ(heap_->segment_region_.get_free_segments(), SEGMENT_REGION_NUM_SEGMENTS);
+    EXPECT_EQ(heap_->huge_segments_, nullptr);
+    EXPECT_EQ(heap_->huge_cache_.get_cached_bytes(), 0u) << "Region runs must bypass the huge cache.";
+}
+
+// ===================================================================================
+// 测试用例 2: 相邻的空闲 Segment 合并后能服务更大的请求
+// ===================================================================================
+TEST_F(SegmentRegionTest, AdjacentFreeRunsCoalesce) {
+    const size_t small_size = 3 * 1024 * 1024;
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 4; ++i) {
+        ptrs.push_back(heap_->allocate(small_size));
+        ASSERT_NE(ptrs.back(), nullptr);
+        ASSERT_TRUE(MappedSegment::get_owning_segment(ptrs.back())->is_region_backed());
+    }
+
+    // 释放中间两个：它们的 4 个 Segment 合并为一段
+    heap_->free(ptrs[1]);
+    heap_->free(ptrs[2]);
+
+    const size_t big_size = 7 * 1024 * 1024;
+    ASSERT_EQ(segments_for(big_size), 2 * segments_for(small_size));
+    void* big = heap_->allocate(big_size);
+    ASSERT_NE(big, nullptr);
+    EXPECT_EQ(MappedSegment::get_owning_segment(big), MappedSegment::get_owning_segment(ptrs[1]));
+
+    heap_->free(big);
+    heap_->free(ptrs[0]);
+    heap_->free(ptrs[3]);
+    EXPECT_EQ(heap_->segment_region_.get_free_segments(), SEGMENT_REGION_NUM_SEGMENTS);
+}
+
+// ===================================================================================
+// 测试用例 3: 超过上限或关闭区域时仍使用独立映射
+// ===================================================================================
+TEST_F(SegmentRegionTest, LargerRequestsUseDedicatedMappings) {
+    void* big = heap_->allocate(20 * 1024 * 1024);
+    ASSERT_NE(big, nullptr);
+    EXPECT_FALSE(MappedSegment::get_owning_segment(big)->is_region_backed());
+    heap_->free(big);
+
+    AllocatorOptions::get_instance().region_max_segments = 0;
+    void* small = heap_->allocate(3 * 1024 * 1024);
+    ASSERT_NE(small, nullptr);
+    EXPECT_FALSE(MappedSegment::get_owning_segment(small)->is_region_backed());
+    heap_->free(small);
+}
+
+// ===================================================================================
+// 测试用例 4: 区域中的对象 realloc 时走拷贝路径，数据不变
+// ===================================================================================
+TEST_F(SegmentRegionTest, ReallocOfRegionRunCopies) {
+    const size_t size = 3 * 1024 * 1024;
+    char* ptr = static_cast<char*>(heap_->allocate(size));
+    ASSERT_NE(ptr, nullptr);
+    ptr[0] = 7;
+    ptr[size - 1] = 9;
+
+    char* grown = static_cast<char*>(heap_->reallocate(ptr, 3 * size));
+    ASSERT_NE(grown, nullptr);
+    EXPECT_EQ(grown[0], 7);
+    EXPECT_EQ(grown[size - 1], 9);
+    EXPECT_GE(ThreadHeap::get_usable_size(grown), 3 * size);
+
+    heap_->free(grown);
+    EXPECT_EQ(heap_->segment_region_.get_free_segments(), SEGMENT_REGION_NUM_SEGMENTS);
+}
+
+// ===================================================================================
+// 测试用例 5: 重复释放被忽略
+// ===================================================================================
+TEST_F(SegmentRegionTest, DoubleFreeIsIgnored) {
+    void* ptr = heap_->allocate(5 * 1024 * 1024);
+    ASSERT_NE(ptr, nullptr);
+
+    heap_->free(ptr);
+    heap_->free(ptr);
+    EXPECT_EQ(heap_->segment_region_.get_free_segments(), SEGMENT_REGION_NUM_SEGMENTS);
+}
+
+// ===================================================================================
+// 测试用例 6: 位图中的空闲段查找 (first fit)
+// ===================================================================================
+TEST_F(SegmentRegionTest, FindFreeRunIsFirstFit) {
+    SegmentRegion region;
+    region.free_mask_ = 0b1110'0110'1011;
+
+    EXPECT_EQ(region.find_free_run(1), 0u);
+    EXPECT_EQ(region.find_free_run(2), 0u);
+    EXPECT_EQ(region.find_free_run(3), 9u);
+    EXPECT_EQ(region.find_free_run(4), SIZE_MAX);
+
+    region.free_mask_ = ~static_cast<uint64_t>(0);
+    EXPECT_EQ(region.find_free_run(SEGMENT_REGION_NUM_SEGMENTS), 0u);
+    region.free_mask_ = 0;
+}
+
+// ===================================================================================
+// 测试用例 7: 头部落在用过的内存上时，元数据之后的描述符被重置为 FREE
+// ===================================================================================
+TEST_F(SegmentRegionTest, ReusedSegmentHasFreeDescriptors) {
+    SegmentRegion region;
+    MappedSegment* run = region.take(2);
+    ASSERT_NE(run, nullptr);
+
+    // 第二个 Segment 是用户数据，填满非零字节
+    char* second = reinterpret_cast<char*>(run) + SEGMENT_SIZE;
+    memset(second, 0xAB, SEGMENT_SIZE);
+    region.put(run);
+
+    MappedSegment* first_seg = region.take(1);
+    MappedSegment* second_seg = region.take(1);
+    ASSERT_EQ(first_seg, run);
+    ASSERT_EQ(reinterpret_cast<char*>(second_seg), second);
+
+    const size_t metadata_pages = (sizeof(MappedSegment) + PAGE_SIZE - 1) / PAGE_SIZE;
+    EXPECT_EQ(second_seg->next_free_page_idx_, metadata_pages);
+    for (size_t i = metadata_pages; i < SEGMENT_SIZE / PAGE_SIZE; ++i) {
+        const PageDescriptor& desc = second_seg->page_descriptors_[i];
+        ASSERT_EQ(desc.status, PageStatus::FREE) << i;
+        ASSERT_EQ(desc.sampled, 0) << i;
+        ASSERT_EQ(desc.num_pages, 0) << i;
+        ASSERT_EQ(desc.slab_ptr, nullptr) << i;
+    }
+
+    region.put(first_seg);
+    region.put(second_seg);
+    region.release_all();
+}
+
+} // namespace my_malloc
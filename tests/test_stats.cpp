@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/AllocatorOptions.hpp>
+#include <my_malloc/internal/HeapInspector.hpp>
+#include <my_malloc/internal/HeapStats.hpp>
+#include <my_malloc/internal/SlabConfig.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace my_malloc {
+
+class HeapStatsTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+    }
+
+    void TearDown() override {
+        delete heap_;
+    }
+
+    static size_t small_class(size_t size) {
+        return SlabConfig::get_instance().get_size_class_index(size);
+    }
+
+    static size_t medium_class(size_t size) {
+        return SlabConfig::get_instance().get_medium_class_index((size + PAGE_SIZE - 1) / PAGE_SIZE);
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 小对象的分配/释放次数、存活字节与 slab 数
+// ===================================================================================
+TEST_F(HeapStatsTest, SmallClassCounters) {
+    const size_t class_id = small_class(64);
+    const size_t block_size = SlabConfig::get_instance().get_info(class_id).block_size;
+    const ClassCounters& counters = heap_->stats_.small[class_id];
+
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 10; ++i) {
+        ptrs.push_back(heap_->allocate(64));
+        ASSERT_NE(ptrs.back(), nullptr);
+    }
+    EXPECT_EQ(counters.allocs.load(), 10u);
+    EXPECT_EQ(counters.frees.load(), 0u);
+    EXPECT_EQ(counters.slabs.load(), 1u);
+
+    const HeapStats stats = ThreadHeap::get_stats();
+    EXPECT_EQ(stats.small_classes[class_id].block_size, block_size);
+    EXPECT_GE(stats.small_classes[class_id].live_bytes, 10 * block_size);
+    EXPECT_GE(stats.small_classes[class_id].slab_bytes, stats.small_classes[class_id].live_bytes);
+
+    for (void* ptr : ptrs) {
+        heap_->free(ptr);
+    }
+    EXPECT_EQ(counters.frees.load(), 10u);
+    EXPECT_EQ(counters.slabs.load(), 0u) << "The empty slab is returned to the page heap.";
+}
+
+// ===================================================================================
+// 测试用例 2: 中等对象按页数类计数，缓存中的 span 仍属于该类
+// ===================================================================================
+TEST_F(HeapStatsTest, MediumClassCounters) {
+    const size_t size = MAX_SMALL_OBJECT_SIZE + 8 * PAGE_SIZE;
+    const ClassCounters& counters = heap_->stats_.medium[medium_class(size)];
+
+    void* a = heap_->allocate(size);
+    void* b = heap_->allocate(size);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(counters.allocs.load(), 2u);
+    EXPECT_EQ(counters.slabs.load(), 2u);
+
+    heap_->free(a);
+    EXPECT_EQ(counters.frees.load(), 1u);
+    EXPECT_EQ(counters.slabs.load(), 2u);
+
+    // 从缓存中取回不产生新的 span
+    void* c = heap_->allocate(size);
+    EXPECT_EQ(c, a);
+    EXPECT_EQ(counters.slabs.load(), 2u);
+
+    heap_->free(b);
+    heap_->free(c);
+    EXPECT_EQ(counters.allocs.load(), counters.frees.load());
+}
+
+// ===================================================================================
+// 测试用例 3: Huge 对象的字节数与 Segment 计数
+// ===================================================================================
+TEST_F(HeapStatsTest, HugeBytesAndSegments) {
+    void* small = heap_->allocate(32);
+    ASSERT_NE(small, nullptr);
+    EXPECT_EQ(heap_->stats_.segments.load(), 1u);
+
+    void* huge = heap_->allocate(6 * 1024 * 1024);
+    ASSERT_NE(huge, nullptr);
+    const MappedSegment* seg = MappedSegment::get_owning_segment(huge);
+    EXPECT_EQ(heap_->stats_.huge_allocs.load(), 1u);
+    EXPECT_EQ(heap_->stats_.huge_bytes.load(), seg->total_size_);
+
+    heap_->free(huge);
+    EXPECT_EQ(heap_->stats_.huge_frees.load(), 1u);
+    EXPECT_EQ(heap_->stats_.huge_bytes.load(), 0u);
+    heap_->free(small);
+}
+
+// ===================================================================================
+// 测试用例 4: 独立映射的 Huge 对象计入 mmap/munmap 次数
+// ===================================================================================
+TEST_F(HeapStatsTest, MappingCallsAreCounted) {
+    auto& options = AllocatorOptions::get_instance();
+    options.region_max_segments = 0;
+    options.huge_cache_budget = 0;
+
+    const HeapStats before = ThreadHeap::get_stats();
+    void* huge = heap_->allocate(20 * 1024 * 1024);
+    ASSERT_NE(huge, nullptr);
+    heap_->free(huge);
+    const HeapStats after = ThreadHeap::get_stats();
+
+    EXPECT_GE(after.mmap_calls, before.mmap_calls + 1);
+    EXPECT_GE(after.munmap_calls, before.munmap_calls + 1);
+
+    options.region_max_segments = DEFAULT_REGION_MAX_SEGMENTS;
+    options.huge_cache_budget = DEFAULT_HUGE_CACHE_BUDGET;
+}
+
+// ===================================================================================
+// 测试用例 5: 汇总所有 heap，销毁的 heap 的累计次数被保留
+// ===================================================================================
+TEST_F(HeapStatsTest, AggregatesAcrossHeaps) {
+    const size_t class_id = small_class(200);
+    const HeapStats before = ThreadHeap::get_stats();
+    EXPECT_GE(before.num_heaps, 1u);
+
+    std::thread worker([] {
+        ThreadHeap other;
+        for (int i = 0; i < 100; ++i) {
+            other.free(other.allocate(200));
+        }
+    });
+    worker.join();
+
+    void* ptr = heap_->allocate(200);
+    ASSERT_NE(ptr, nullptr);
+
+    const HeapStats after = ThreadHeap::get_stats();
+    EXPECT_EQ(after.num_heaps, before.num_heaps);
+    EXPECT_EQ(after.small_classes[class_id].allocs, before.small_classes[class_id].allocs + 101);
+    EXPECT_EQ(after.small_classes[class_id].frees, before.small_classes[class_id].frees + 100);
+    EXPECT_GE(after.live_bytes, after.small_classes[class_id].block_size);
+    EXPECT_GE(after.fragmentation(), 0.0);
+    EXPECT_LT(after.fragmentation(), 1.0);
+
+    heap_->free(ptr);
+}
+
+// ===================================================================================
+// 测试用例 6: 延迟直方图按 log2 分桶，分位数取桶的上界
+// ===================================================================================
+TEST_F(HeapStatsTest, LatencyHistogramBuckets) {
+    EXPECT_EQ(LatencyCounters::bucket_of(0), 0u);
+    EXPECT_EQ(LatencyCounters::bucket_of(1), 1u);
+    EXPECT_EQ(LatencyCounters::bucket_of(1000), 10u);
+    EXPECT_EQ(LatencyCounters::bucket_of(UINT64_MAX), LATENCY_BUCKETS - 1);
+
+    LatencyHistogram histogram;
+    histogram.buckets[LatencyCounters::bucket_of(100)] = 998;
+    histogram.buckets[LatencyCounters::bucket_of(5000)] = 1;
+    histogram.buckets[LatencyCounters::bucket_of(90000)] = 1;
+    histogram.count = 1000;
+    EXPECT_EQ(histogram.percentile(0.5), 128u);
+    EXPECT_EQ(histogram.percentile(0.999), 8192u);
+    EXPECT_EQ(histogram.percentile(1.0), 131072u);
+}
+
+// ===================================================================================
+// 测试用例 7: 打开直方图编译选项时，慢路径被计时并归到各自的类型
+// ===================================================================================
+TEST_F(HeapStatsTest, SlowPathsAreTimed) {
+    const HeapStats before = ThreadHeap::get_stats();
+
+    // 新 heap 的第一次小对象分配要建 Segment、初始化 slab；中等 span 释放时要合并
+    void* small = heap_->allocate(64);
+    void* medium = heap_->allocate(MAX_SMALL_OBJECT_SIZE + PAGE_SIZE);
+    ASSERT_NE(small, nullptr);
+    ASSERT_NE(medium, nullptr);
+    heap_->free(small);
+    heap_->free(medium);
+
+    const HeapStats after = ThreadHeap::get_stats();
+    auto delta = [&](SlowPath path) {
+        const size_t i = static_cast<size_t>(path);
+        return after.slow_paths[i].count - before.slow_paths[i].count;
+    };
+    if (!LATENCY_HISTOGRAMS_ENABLED) {
+        EXPECT_EQ(delta(SlowPath::SEGMENT_CREATE), 0u);
+        EXPECT_EQ(delta(SlowPath::SMALL_SLAB_INIT), 0u);
+        return;
+    }
+    EXPECT_EQ(delta(SlowPath::SEGMENT_CREATE), 1u);
+    EXPECT_EQ(delta(SlowPath::SMALL_SLAB_INIT), 1u);
+    EXPECT_GE(delta(SlowPath::SPAN_RELEASE), 1u);
+    EXPECT_GT(after.slow_paths[static_cast<size_t>(SlowPath::SEGMENT_CREATE)].total_ticks, 0u);
+}
+
+// ===================================================================================
+// 测试用例 8: 打开锁统计编译选项时，每个加锁点分别计数；另一线程持锁时记为争用
+// ===================================================================================
+TEST_F(HeapStatsTest, LockSitesAreCounted) {
+    const LockCounters* locks = heap_->stats_.locks;
+    auto acquisitions = [&](LockSite site) {
+        return locks[static_cast<size_t>(site)].acquisitions.load();
+    };
+
+    void* small = heap_->allocate(64);
+    void* huge = heap_->allocate(4 * SEGMENT_SIZE);
+    ASSERT_NE(small, nullptr);
+    ASSERT_NE(huge, nullptr);
+    heap_->free(small);
+    heap_->free(huge);
+
+    if (!LOCK_STATS_ENABLED) {
+        EXPECT_EQ(acquisitions(LockSite::ALLOCATE), 0u);
+        EXPECT_EQ(acquisitions(LockSite::FREE), 0u);
+        return;
+    }
+    EXPECT_EQ(acquisitions(LockSite::ALLOCATE), 2u);
+    EXPECT_EQ(acquisitions(LockSite::FREE), 1u);
+    EXPECT_EQ(acquisitions(LockSite::HUGE_FREE), 1u);
+
+    // 持锁期间让另一个线程来分配，它必然先自旋失败
+    void* contended_ptr = nullptr;
+    {
+        std::unique_lock<std::mutex> guard(heap_->lock_);
+        std::thread other([&] { contended_ptr = heap_->allocate(64); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        guard.unlock();
+        other.join();
+    }
+    ASSERT_NE(contended_ptr, nullptr);
+    heap_->free(contended_ptr);
+
+    const LockCounters& allocate = locks[static_cast<size_t>(LockSite::ALLOCATE)];
+    EXPECT_EQ(allocate.contended.load(), 1u);
+    EXPECT_GT(allocate.spin_ticks.load(), 0u);
+    EXPECT_GT(allocate.wait_ticks.load(), 0u);
+
+    // purge、遍历与快照同样经过计数，持锁时间不会被漏掉
+    heap_->purge();
+    EXPECT_TRUE(heap_->heap_walk([](const HeapBlock&, void*) {}, nullptr, false));
+    HeapSnapshot snapshot;
+    EXPECT_TRUE(snapshot.capture(*heap_));
+    EXPECT_EQ(acquisitions(LockSite::PURGE), 1u);
+    EXPECT_EQ(acquisitions(LockSite::INSPECT), 2u);
+
+    const HeapStats stats = ThreadHeap::get_stats();
+    EXPECT_GE(stats.locks[static_cast<size_t>(LockSite::ALLOCATE)].contended, 1u);
+    EXPECT_EQ(stats.locks[static_cast<size_t>(LockSite::FREE)].hold.count,
+              stats.locks[static_cast<size_t>(LockSite::FREE)].acquisitions);
+}
+
+// ===================================================================================
+// 测试用例 9: realloc 的原地、重映射与复制分别计数，复制字节数取新旧大小的较小者
+// ===================================================================================
+TEST_F(HeapStatsTest, ReallocOutcomesAreCounted) {
+    const HeapCounters& counters = heap_->stats_;
+
+    void* ptr = heap_->allocate(100);
+    ASSERT_NE(ptr, nullptr);
+    const size_t old_size = ThreadHeap::get_usable_size(ptr);
+
+    EXPECT_EQ(heap_->reallocate(ptr, 90), ptr);
+    EXPECT_EQ(counters.realloc_in_place.load(), 1u);
+    EXPECT_EQ(counters.realloc_copies.load(), 0u);
+
+    ptr = heap_->reallocate(ptr, 1000);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(counters.realloc_copies.load(), 1u);
+    EXPECT_EQ(counters.realloc_copied_bytes.load(), old_size);
+
+    // 独立映射的 Huge 对象靠 mremap 扩展，无论是否搬家都不复制；区域中的 Segment 走复制路径
+    auto& options = AllocatorOptions::get_instance();
+    options.region_max_segments = 0;
+    void* huge = heap_->allocate(6 * 1024 * 1024);
+    ASSERT_NE(huge, nullptr);
+    huge = heap_->reallocate(huge, 12 * 1024 * 1024);
+    ASSERT_NE(huge, nullptr);
+    EXPECT_EQ(counters.realloc_in_place.load() + counters.realloc_remapped.load(), 2u);
+    EXPECT_EQ(counters.realloc_copies.load(), 1u);
+
+    heap_->free(ptr);
+    heap_->free(huge);
+    options.region_max_segments = DEFAULT_REGION_MAX_SEGMENTS;
+}
+
+} // namespace my_malloc
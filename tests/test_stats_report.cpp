@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <my_malloc/ThreadHeap.hpp>
+#include <my_malloc/internal/StatsReport.hpp>
+#include <my_malloc/internal/definitions.hpp>
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace my_malloc {
+
+class StatsReportTest : public ::testing::Test {
+protected:
+    ThreadHeap* heap_ = nullptr;
+    FILE* out_ = nullptr;
+
+    void SetUp() override {
+        heap_ = new ThreadHeap();
+        out_ = tmpfile();
+        ASSERT_NE(out_, nullptr);
+    }
+
+    void TearDown() override {
+        fclose(out_);
+        delete heap_;
+    }
+
+    std::string read_output() {
+        std::string text;
+        rewind(out_);
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), out_)) > 0) {
+            text.append(buf, n);
+        }
+        return text;
+    }
+
+    static std::string address_of(const void* ptr) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%p", ptr);
+        return buf;
+    }
+};
+
+// ===================================================================================
+// 测试用例 1: 文本报告包含用过的类和每个 Segment 的页占用
+// ===================================================================================
+TEST_F(StatsReportTest, TextReportListsClassesAndSegments) {
+    void* small = heap_->allocate(48);
+    void* medium = heap_->allocate(MAX_SMALL_OBJECT_SIZE + PAGE_SIZE);
+    ASSERT_NE(small, nullptr);
+    ASSERT_NE(medium, nullptr);
+
+    dump_stats(out_, StatsFormat::TEXT);
+    const std::string text = read_output();
+
+    EXPECT_NE(text.find("small classes:"), std::string::npos);
+    EXPECT_NE(text.find("medium classes:"), std::string::npos);
+    EXPECT_NE(text.find("heap " + address_of(heap_) + ":"), std::string::npos);
+    EXPECT_NE(text.find("segment " + address_of(MappedSegment::get_segment(small))), std::string::npos);
+
+    heap_->free(medium);
+    heap_->free(small);
+}
+
+// ===================================================================================
+// 测试用例 2: JSON 报告括号配对，字段齐全
+// ===================================================================================
+TEST_F(StatsReportTest, JsonReportIsWellFormed) {
+    void* ptr = heap_->allocate(1000);
+    ASSERT_NE(ptr, nullptr);
+
+    dump_stats(out_, StatsFormat::JSON);
+    const std::string json = read_output();
+
+    ASSERT_FALSE(json.empty());
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.substr(json.size() - 2), "}\n");
+
+    int braces = 0;
+    int brackets = 0;
+    for (char c : json) {
+        braces += (c == '{') - (c == '}');
+        brackets += (c == '[') - (c == ']');
+        ASSERT_GE(braces, 0);
+        ASSERT_GE(brackets, 0);
+    }
+    EXPECT_EQ(braces, 0);
+    EXPECT_EQ(brackets, 0);
+
+    EXPECT_NE(json.find("\"small_classes\": ["), std::string::npos);
+    EXPECT_NE(json.find("\"utilization\": "), std::string::npos);
+    EXPECT_NE(json.find("\"heap\": \"" + address_of(heap_) + "\""), std::string::npos);
+
+    heap_->free(ptr);
+}
+
+// ===================================================================================
+// 测试用例 3: 正在使用的 heap 不等待，报告中标记为 busy
+// ===================================================================================
+TEST_F(StatsReportTest, BusyHeapIsSkipped) {
+    void* ptr = heap_->allocate(64);
+    ASSERT_NE(ptr, nullptr);
+
+    heap_->lock_.lock();
+    dump_stats(out_, StatsFormat::TEXT);
+    heap_->lock_.unlock();
+
+    EXPECT_NE(read_output().find("heap " + address_of(heap_) + ": busy"), std::string::npos);
+    heap_->free(ptr);
+}
+
+// ===================================================================================
+// 测试用例 4: 收到信号时输出报告
+// ===================================================================================
+TEST_F(StatsReportTest, DumpsOnSignal) {
+    void* ptr = heap_->allocate(64);
+    ASSERT_NE(ptr, nullptr);
+
+    ASSERT_TRUE(install_stats_signal_handler(SIGUSR2, fileno(out_), StatsFormat::TEXT));
+    raise(SIGUSR2);
+    signal(SIGUSR2, SIG_DFL);
+
+    EXPECT_NE(read_output().find("___ my_malloc statistics ___"), std::string::npos);
+    heap_->free(ptr);
+}
+
+// ===================================================================================
+// 测试用例 5: 其他线程反复创建、销毁 heap 时输出报告，不会读到已拆除的 Segment
+// ===================================================================================
+TEST_F(StatsReportTest, DumpWhileHeapsComeAndGo) {
+    const int null_fd = open("/dev/null", O_WRONLY);
+    ASSERT_GE(null_fd, 0);
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                // 留下存活的块，析构时要拆除 Segment 和 Huge 映射
+                ThreadHeap heap;
+                for (int i = 0; i < 64; ++i) {
+                    heap.allocate(64 + i * 16);
+                }
+                heap.allocate(MAX_SMALL_OBJECT_SIZE + PAGE_SIZE);
+                heap.allocate(4 * SEGMENT_SIZE);
+            }
+        });
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        dump_stats(null_fd, i % 2 ? StatsFormat::JSON : StatsFormat::TEXT);
+        std::this_thread::yield();
+    }
+    stop = true;
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    close(null_fd);
+}
+
+} // namespace my_malloc